@@ -0,0 +1,593 @@
+#include "ArenaBatch.h"
+#include "SpawnScheduler.h"
+#include "SpawnWave.h"
+#include "Serializer.h"
+#include "BotController.h"
+#include "BubbleGrid.h"
+#include "JobSystem.h"
+#include "PlayerMovement.h"
+#include "nodes/Body.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <nctl/algorithms.h>
+#include <ncine/AppConfiguration.h>
+#include <ncine/TimeStamp.h>
+
+namespace {
+
+	/// Splits the correction of a contact between two dynamic circles, like `ContactSolver` does
+	inline void addCircleCorrections(const nc::Vector2f &normal, float penetrationAmount,
+	                                 float &correctionAX, float &correctionAY, float &correctionBX, float &correctionBY)
+	{
+		correctionAX += normal.x * (penetrationAmount * 0.5f);
+		correctionAY += normal.y * (penetrationAmount * 0.5f);
+		correctionBX -= normal.x * (penetrationAmount * 0.5f);
+		correctionBY -= normal.y * (penetrationAmount * 0.5f);
+	}
+
+	inline uint64_t bubbleBit(unsigned int index)
+	{
+		return uint64_t(1) << index;
+	}
+}
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS AND DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+ArenaBatch::ArenaBatch(unsigned int numArenas, unsigned int numThreads, uint64_t seed)
+    : numArenas_(numArenas), seed_(seed),
+      arenaWidth_(static_cast<float>(Cfg::Game::Resolution.x)), arenaHeight_(static_cast<float>(Cfg::Game::Resolution.y)),
+      numSteps_(0)
+{
+	FATAL_ASSERT(numArenas_ > 0);
+
+	matchTime_ = nctl::makeUnique<float[]>(numArenas_);
+	numBubbles_ = nctl::makeUnique<unsigned int[]>(numArenas_);
+	numMatches_ = nctl::makeUnique<unsigned int[]>(numArenas_);
+	numCatchedBubbles_ = nctl::makeUnique<unsigned int[]>(numArenas_);
+	numDroppedBubbles_ = nctl::makeUnique<unsigned int[]>(numArenas_);
+	spawnSchedulers_ = nctl::makeUnique<SpawnScheduler[]>(numArenas_);
+
+	const unsigned int numPlayers = numArenas_ * NumPlayers;
+	playerPosX_ = nctl::makeUnique<float[]>(numPlayers);
+	playerPosY_ = nctl::makeUnique<float[]>(numPlayers);
+	playerVelX_ = nctl::makeUnique<float[]>(numPlayers);
+	playerVelY_ = nctl::makeUnique<float[]>(numPlayers);
+	playerDamping_ = nctl::makeUnique<float[]>(numPlayers);
+	playerGravityY_ = nctl::makeUnique<float[]>(numPlayers);
+	stamina_ = nctl::makeUnique<float[]>(numPlayers);
+	dashEnergy_ = nctl::makeUnique<float[]>(numPlayers);
+	dashDirX_ = nctl::makeUnique<float[]>(numPlayers);
+	jumpCount_ = nctl::makeUnique<int[]>(numPlayers);
+	points_ = nctl::makeUnique<unsigned int[]>(numPlayers);
+	grounded_ = nctl::makeUnique<bool[]>(numPlayers);
+	actions_ = nctl::makeUnique<uint8_t[]>(numPlayers);
+
+	const unsigned int numBubbleSlots = numArenas_ * MaxBubbles;
+	bubblePosX_ = nctl::makeUnique<float[]>(numBubbleSlots);
+	bubblePosY_ = nctl::makeUnique<float[]>(numBubbleSlots);
+	bubbleVelX_ = nctl::makeUnique<float[]>(numBubbleSlots);
+	bubbleVelY_ = nctl::makeUnique<float[]>(numBubbleSlots);
+
+	nctl::Array<SpawnWave> waves;
+	SpawnScheduler::defaultWaves(waves);
+	const nc::Vector2f areaMin(arenaWidth_ * Cfg::Spawn::AreaRelativeMin.x, arenaHeight_ * Cfg::Spawn::AreaRelativeMin.y);
+	const nc::Vector2f areaMax(arenaWidth_ * Cfg::Spawn::AreaRelativeMax.x, arenaHeight_ * Cfg::Spawn::AreaRelativeMax.y);
+	const nc::Rectf area(areaMin.x, areaMin.y, areaMax.x - areaMin.x, areaMax.y - areaMin.y);
+	for (unsigned int i = 0; i < numArenas_; i++)
+	{
+		spawnSchedulers_[i].setWaves(waves);
+		spawnSchedulers_[i].setupArea(area, Cfg::Arena::BubbleRadius * 2.0f * Cfg::Spawn::MinDistanceFactor);
+	}
+	reset();
+
+	jobSystem_ = nctl::makeUnique<JobSystem>(numThreads);
+}
+
+ArenaBatch::~ArenaBatch()
+{
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+unsigned int ArenaBatch::numThreads() const
+{
+	return jobSystem_->numThreads();
+}
+
+void ArenaBatch::setWaves(const nctl::Array<SpawnWave> &waves)
+{
+	for (unsigned int i = 0; i < numArenas_; i++)
+		spawnSchedulers_[i].setWaves(waves);
+	reset();
+}
+
+void ArenaBatch::reset()
+{
+	for (unsigned int i = 0; i < numArenas_; i++)
+	{
+		numMatches_[i] = 0;
+		numCatchedBubbles_[i] = 0;
+		numDroppedBubbles_[i] = 0;
+		resetArena(i);
+	}
+	numSteps_ = 0;
+}
+
+void ArenaBatch::setAction(unsigned int arena, unsigned int player, const PlayerInput &input)
+{
+	ASSERT(arena < numArenas_ && player < NumPlayers);
+	actions_[arena * NumPlayers + player] = input.toBits();
+}
+
+void ArenaBatch::step()
+{
+	jobSystem_->parallelFor(0, numArenas_, Cfg::Arena::ArenasPerChunk, [this](unsigned int first, unsigned int last) {
+		for (unsigned int arena = first; arena < last; arena++)
+			stepArena(arena);
+	});
+
+	numSteps_++;
+}
+
+void ArenaBatch::observe(unsigned int arena, unsigned int player, PlayerObservation &observation) const
+{
+	ASSERT(arena < numArenas_ && player < NumPlayers);
+	const unsigned int p = arena * NumPlayers + player;
+	const unsigned int opponent = arena * NumPlayers + (1 - player);
+
+	observation.position.set(playerPosX_[p], playerPosY_[p]);
+	observation.velocity.set(playerVelX_[p], playerVelY_[p]);
+	observation.opponentPosition.set(playerPosX_[opponent], playerPosY_[opponent]);
+	observation.stamina = stamina_[p];
+	observation.grounded = grounded_[p];
+	observation.dashing = (dashEnergy_[p] > 0.0f);
+	observation.jumpCount = jumpCount_[p];
+	observation.points = points_[p];
+	observation.secondsLeft = static_cast<float>(Cfg::Arena::MatchTime) - matchTime_[arena];
+	observation.numBubbles = numBubbles_[arena];
+
+	// Insertion into a short sorted list, there are only a few alive bubbles in an arena
+	float sqrDistances[Cfg::Arena::NumObservedBubbles];
+	unsigned int numNearest = 0;
+	const unsigned int first = arena * MaxBubbles;
+	for (unsigned int i = 0; i < numBubbles_[arena]; i++)
+	{
+		const nc::Vector2f relative(bubblePosX_[first + i] - playerPosX_[p], bubblePosY_[first + i] - playerPosY_[p]);
+		const float sqrDistance = relative.sqrLength();
+		if (numNearest == Cfg::Arena::NumObservedBubbles && sqrDistance >= sqrDistances[numNearest - 1])
+			continue;
+
+		unsigned int slot = (numNearest < Cfg::Arena::NumObservedBubbles) ? numNearest++ : numNearest - 1;
+		while (slot > 0 && sqrDistances[slot - 1] > sqrDistance)
+		{
+			sqrDistances[slot] = sqrDistances[slot - 1];
+			observation.nearestBubbles[slot] = observation.nearestBubbles[slot - 1];
+			slot--;
+		}
+		sqrDistances[slot] = sqrDistance;
+		observation.nearestBubbles[slot] = relative;
+	}
+	observation.numNearestBubbles = numNearest;
+}
+
+ArenaBatch::Totals ArenaBatch::totals() const
+{
+	Totals totals;
+	totals.numSteps = numSteps_ * numArenas_;
+	for (unsigned int i = 0; i < numArenas_; i++)
+	{
+		totals.numMatches += numMatches_[i];
+		totals.numCatchedBubbles += numCatchedBubbles_[i];
+		totals.numDroppedBubbles += numDroppedBubbles_[i];
+	}
+	return totals;
+}
+
+unsigned int ArenaBatch::requestedArenas(const nc::AppConfiguration &config)
+{
+	for (int i = 1; i < config.argc(); i++)
+	{
+		if (strcmp(config.argv(i), Cfg::Arena::CommandLineArg) == 0)
+		{
+			const int numArenas = (i + 1 < config.argc()) ? atoi(config.argv(i + 1)) : 0;
+			return (numArenas > 0) ? static_cast<unsigned int>(numArenas) : Cfg::Arena::DefaultNumArenas;
+		}
+	}
+	return 0;
+}
+
+void ArenaBatch::measureThroughput(unsigned int numArenas)
+{
+	nctl::Array<SpawnWave> waves;
+	if (Serializer::loadSpawnWaves(waves) == false)
+		SpawnScheduler::defaultWaves(waves);
+
+#ifndef __EMSCRIPTEN__
+	const unsigned int maxThreads = nctl::max(std::thread::hardware_concurrency(), 1u);
+#else
+	const unsigned int maxThreads = 1;
+#endif
+	LOGI_X("Arena throughput test: %u arenas, %u steps, up to %u threads", numArenas, Cfg::Arena::NumMeasureSteps, maxThreads);
+
+	float singleThreadRate = 0.0f;
+	Totals singleThreadTotals;
+	unsigned int numThreads = 1;
+	while (true)
+	{
+		ArenaBatch batch(numArenas, numThreads, 1);
+		batch.setWaves(waves);
+
+		// New bots with the same seeds for every thread count, the second player of each arena cycles through the difficulties
+		nctl::UniquePtr<BotController[]> bots = nctl::makeUnique<BotController[]>(numArenas * NumPlayers);
+		for (unsigned int arena = 0; arena < numArenas; arena++)
+		{
+			for (unsigned int player = 0; player < NumPlayers; player++)
+			{
+				BotController &bot = bots[arena * NumPlayers + player];
+				bot.seed(arena, player);
+				const unsigned int difficulty = (player == 0) ? Cfg::Bot::BenchmarkDifficulty : arena % static_cast<unsigned int>(BotDifficulty::COUNT);
+				bot.setDifficulty(static_cast<BotDifficulty>(difficulty));
+			}
+		}
+		BubbleGrid bubbleGrid(MaxBubbles);
+		bubbleGrid.setupArea(nc::Rectf(0.0f, 0.0f, batch.arenaWidth_, batch.arenaHeight_ * Cfg::Spawn::AreaRelativeMax.y), Cfg::Bot::GridCellSize);
+
+		float stepTime = 0.0f;
+		for (unsigned int i = 0; i < Cfg::Arena::NumMeasureSteps; i++)
+		{
+			for (unsigned int arena = 0; arena < numArenas; arena++)
+			{
+				bubbleGrid.clear();
+				for (unsigned int bubble = 0; bubble < batch.numBubbles(arena); bubble++)
+					bubbleGrid.addPoint(batch.bubblePosition(arena, bubble));
+				bubbleGrid.build();
+
+				for (unsigned int player = 0; player < NumPlayers; player++)
+				{
+					// Bots only read what an external agent would, through the observations
+					PlayerObservation observation;
+					batch.observe(arena, player, observation);
+
+					BotView view;
+					view.position = observation.position;
+					view.velocity = observation.velocity;
+					view.stamina = observation.stamina;
+					view.jumpCount = observation.jumpCount;
+					view.grounded = observation.grounded;
+					batch.setAction(arena, player, bots[arena * NumPlayers + player].think(view, bubbleGrid));
+				}
+			}
+
+			const nc::TimeStamp stepStart = nc::TimeStamp::now();
+			batch.step();
+			stepTime += stepStart.secondsSince();
+		}
+
+		const Totals totals = batch.totals();
+		const float stepsPerSecond = (stepTime > 0.0f) ? static_cast<float>(totals.numSteps) / stepTime : 0.0f;
+		if (numThreads == 1)
+		{
+			singleThreadRate = stepsPerSecond;
+			singleThreadTotals = totals;
+		}
+		else if (totals.numCatchedBubbles != singleThreadTotals.numCatchedBubbles || totals.numDroppedBubbles != singleThreadTotals.numDroppedBubbles)
+			LOGW_X("Arena results with %u threads differ from the single thread ones", numThreads);
+
+		LOGI_X("Arena throughput with %u threads: %.0f arena-steps/s, %.2fx, %u matches, %u catched and %u dropped bubbles",
+		       numThreads, stepsPerSecond, (singleThreadRate > 0.0f) ? stepsPerSecond / singleThreadRate : 0.0f,
+		       totals.numMatches, totals.numCatchedBubbles, totals.numDroppedBubbles);
+
+		if (numThreads == maxThreads)
+			break;
+		numThreads = nctl::min(numThreads * 2, maxThreads);
+	}
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void ArenaBatch::resetArena(unsigned int arena)
+{
+	matchTime_[arena] = 0.0f;
+	numBubbles_[arena] = 0;
+
+	// Every match of every arena has its own spawns, they do not depend on how arenas are assigned to threads
+	SpawnScheduler &spawnScheduler = spawnSchedulers_[arena];
+	spawnScheduler.reset();
+	spawnScheduler.seed(seed_ + numMatches_[arena], arena);
+
+	for (unsigned int player = 0; player < NumPlayers; player++)
+	{
+		const unsigned int p = arena * NumPlayers + player;
+		// The starting positions of the game, computed with the default collider size of a body
+		const float startX = Cfg::Physics::ColliderHalfSize.x * 2.0f;
+		playerPosX_[p] = (player == 0) ? startX : arenaWidth_ - startX;
+		playerPosY_[p] = Cfg::Physics::ColliderHalfSize.y * 2.1f;
+		playerVelX_[p] = 0.0f;
+		playerVelY_[p] = 0.0f;
+		playerDamping_[p] = Cfg::Player::StartDamping;
+		playerGravityY_[p] = Cfg::Physics::Gravity.y;
+		stamina_[p] = Cfg::Player::MaxStamina;
+		dashEnergy_[p] = 0.0f;
+		dashDirX_[p] = 0.0f;
+		jumpCount_[p] = 0;
+		points_[p] = 0;
+		grounded_[p] = false;
+		actions_[p] = 0;
+	}
+}
+
+void ArenaBatch::spawnBubbles(unsigned int arena)
+{
+	SpawnScheduler &spawnScheduler = spawnSchedulers_[arena];
+	const unsigned int numSpawns = spawnScheduler.update(Cfg::Arena::StepLength, numBubbles_[arena], NumPlayers);
+	if (numSpawns == 0)
+		return;
+
+	const unsigned int first = arena * MaxBubbles;
+	spawnScheduler.clearGrid();
+	for (unsigned int i = 0; i < numBubbles_[arena]; i++)
+		spawnScheduler.addPoint(nc::Vector2f(bubblePosX_[first + i], bubblePosY_[first + i]));
+
+	for (unsigned int i = 0; i < numSpawns; i++)
+	{
+		nc::Vector2f pos;
+		if (spawnScheduler.samplePosition(pos) == false)
+		{
+			spawnScheduler.postpone(numSpawns - i);
+			break;
+		}
+		// The variant is only picked to consume the same random numbers as the game
+		spawnScheduler.pickVariant();
+
+		// Like a full bubble pool
+		if (numBubbles_[arena] >= MaxBubbles)
+			break;
+
+		const unsigned int b = first + numBubbles_[arena]++;
+		bubblePosX_[b] = pos.x;
+		bubblePosY_[b] = pos.y;
+		bubbleVelX_[b] = 0.0f;
+		bubbleVelY_[b] = 0.0f;
+	}
+}
+
+void ArenaBatch::stepArena(unsigned int arena)
+{
+	const float deltaTime = Cfg::Arena::StepLength;
+
+	// A finished match is recorded and a new one starts in place, like a rematch
+	if (matchTime_[arena] > static_cast<float>(Cfg::Arena::MatchTime))
+	{
+		numMatches_[arena]++;
+		resetArena(arena);
+	}
+	matchTime_[arena] += deltaTime;
+	spawnBubbles(arena);
+
+	const unsigned int p0 = arena * NumPlayers;
+	const unsigned int first = arena * MaxBubbles;
+	const unsigned int numBubbles = numBubbles_[arena];
+	float *posX = bubblePosX_.get() + first;
+	float *posY = bubblePosY_.get() + first;
+	float *velX = bubbleVelX_.get() + first;
+	float *velY = bubbleVelY_.get() + first;
+
+	const unsigned int NumObstacles = Cfg::Game::NumObstacles;
+	static_assert(NumObstacles <= 8, "The obstacles of a body are tracked in an 8 bit mask");
+	nc::Vector2f obstaclePos[NumObstacles];
+	nc::Vector2f obstacleHalfSize[NumObstacles];
+	for (unsigned int o = 0; o < NumObstacles; o++)
+	{
+		obstaclePos[o].set(arenaWidth_ * Cfg::Game::Obstacles[o].relativePosition.x, arenaHeight_ * Cfg::Game::Obstacles[o].relativePosition.y);
+		obstacleHalfSize[o] = Cfg::Game::Obstacles[o].halfSize;
+	}
+
+	// A pair of bodies is resolved at most once per step, like the pairs already in `Body::Collisions`
+	bool playersTouched = false;
+	uint8_t playerObstacles[NumPlayers] = {};
+	uint64_t playerBubbles[NumPlayers] = {};
+	uint8_t bubbleObstacles[MaxBubbles];
+	uint64_t bubblePairs[MaxBubbles];
+	uint64_t groundedBubbles = 0;
+	for (unsigned int i = 0; i < numBubbles; i++)
+	{
+		bubbleObstacles[i] = 0;
+		bubblePairs[i] = 0;
+	}
+	grounded_[p0] = false;
+	grounded_[p0 + 1] = false;
+
+	const float subStepLength = deltaTime / static_cast<float>(Cfg::Physics::NumSubSteps);
+	for (unsigned int subStep = 0; subStep < Cfg::Physics::NumSubSteps; subStep++)
+	{
+		for (unsigned int p = p0; p < p0 + NumPlayers; p++)
+		{
+			nc::Vector2f position(playerPosX_[p], playerPosY_[p]);
+			nc::Vector2f velocity(playerVelX_[p], playerVelY_[p]);
+			Body::integrate(position, velocity, nc::Vector2f(0.0f, playerGravityY_[p]), playerDamping_[p], Cfg::Player::MaxVelocity, subStepLength);
+			playerPosX_[p] = position.x;
+			playerPosY_[p] = position.y;
+			playerVelX_[p] = velocity.x;
+			playerVelY_[p] = velocity.y;
+		}
+		for (unsigned int i = 0; i < numBubbles; i++)
+		{
+			nc::Vector2f position(posX[i], posY[i]);
+			nc::Vector2f velocity(velX[i], velY[i]);
+			Body::integrate(position, velocity, Cfg::Physics::BubbleGravity, Cfg::Physics::BubbleDamping, Cfg::Physics::BubbleMaxVelocity, subStepLength);
+			posX[i] = position.x;
+			posY[i] = position.y;
+			velX[i] = velocity.x;
+			velY[i] = velocity.y;
+		}
+
+		// Pairs are visited in the order of the pair ids of `ContactSolver`, with `Body::All` sorted as players,
+		// obstacles, then bubbles. Corrections are computed from the positions at the start of the substep.
+		float playerCorrectionX[NumPlayers] = {};
+		float playerCorrectionY[NumPlayers] = {};
+		float bubbleCorrectionX[MaxBubbles];
+		float bubbleCorrectionY[MaxBubbles];
+		for (unsigned int i = 0; i < numBubbles; i++)
+		{
+			bubbleCorrectionX[i] = 0.0f;
+			bubbleCorrectionY[i] = 0.0f;
+		}
+
+		nc::Vector2f normal;
+		float penetrationAmount = 0.0f;
+		for (unsigned int player = 0; player < NumPlayers; player++)
+		{
+			const unsigned int p = p0 + player;
+			const nc::Vector2f playerPos(playerPosX_[p], playerPosY_[p]);
+			if (player == 0 && playersTouched == false &&
+			    Body::circleVsCircleContact(playerPos, Cfg::Player::Radius, nc::Vector2f(playerPosX_[p + 1], playerPosY_[p + 1]), Cfg::Player::Radius,
+			                                normal, penetrationAmount))
+			{
+				playersTouched = true;
+				addCircleCorrections(normal, penetrationAmount, playerCorrectionX[0], playerCorrectionY[0], playerCorrectionX[1], playerCorrectionY[1]);
+			}
+
+			for (unsigned int o = 0; o < NumObstacles; o++)
+			{
+				if ((playerObstacles[player] & (1 << o)) == 0 &&
+				    Body::circleVsAabbContact(playerPos, Cfg::Player::Radius, obstaclePos[o], obstacleHalfSize[o], normal, penetrationAmount))
+				{
+					playerObstacles[player] |= (1 << o);
+					grounded_[p] = grounded_[p] || (normal.y > 0.0f);
+					playerCorrectionX[player] += normal.x * penetrationAmount;
+					playerCorrectionY[player] += normal.y * penetrationAmount;
+				}
+			}
+
+			for (unsigned int i = 0; i < numBubbles; i++)
+			{
+				if ((playerBubbles[player] & bubbleBit(i)) == 0 &&
+				    Body::circleVsCircleContact(playerPos, Cfg::Player::Radius, nc::Vector2f(posX[i], posY[i]), Cfg::Arena::BubbleRadius,
+				                                normal, penetrationAmount))
+				{
+					playerBubbles[player] |= bubbleBit(i);
+					addCircleCorrections(normal, penetrationAmount, playerCorrectionX[player], playerCorrectionY[player], bubbleCorrectionX[i], bubbleCorrectionY[i]);
+				}
+			}
+		}
+
+		for (unsigned int o = 0; o < NumObstacles; o++)
+		{
+			for (unsigned int i = 0; i < numBubbles; i++)
+			{
+				if ((bubbleObstacles[i] & (1 << o)) == 0 &&
+				    Body::circleVsAabbContact(nc::Vector2f(posX[i], posY[i]), Cfg::Arena::BubbleRadius, obstaclePos[o], obstacleHalfSize[o],
+				                              normal, penetrationAmount))
+				{
+					bubbleObstacles[i] |= (1 << o);
+					if (normal.y > 0.0f)
+						groundedBubbles |= bubbleBit(i);
+					bubbleCorrectionX[i] += normal.x * penetrationAmount;
+					bubbleCorrectionY[i] += normal.y * penetrationAmount;
+				}
+			}
+		}
+
+		for (unsigned int i = 0; i < numBubbles; i++)
+		{
+			for (unsigned int j = i + 1; j < numBubbles; j++)
+			{
+				if ((bubblePairs[i] & bubbleBit(j)) == 0 &&
+				    Body::circleVsCircleContact(nc::Vector2f(posX[i], posY[i]), Cfg::Arena::BubbleRadius, nc::Vector2f(posX[j], posY[j]), Cfg::Arena::BubbleRadius,
+				                                normal, penetrationAmount))
+				{
+					bubblePairs[i] |= bubbleBit(j);
+					addCircleCorrections(normal, penetrationAmount, bubbleCorrectionX[i], bubbleCorrectionY[i], bubbleCorrectionX[j], bubbleCorrectionY[j]);
+				}
+			}
+		}
+
+		for (unsigned int player = 0; player < NumPlayers; player++)
+		{
+			playerPosX_[p0 + player] += playerCorrectionX[player];
+			playerPosY_[p0 + player] += playerCorrectionY[player];
+		}
+		for (unsigned int i = 0; i < numBubbles; i++)
+		{
+			posX[i] += bubbleCorrectionX[i];
+			posY[i] += bubbleCorrectionY[i];
+		}
+	}
+
+	// Player movement, with the same rule as `Player::simulate()`
+	uint64_t killedBubbles = 0;
+	for (unsigned int player = 0; player < NumPlayers; player++)
+	{
+		const unsigned int p = p0 + player;
+		PlayerMotion motion;
+		motion.velocity.set(playerVelX_[p], playerVelY_[p]);
+		motion.damping = playerDamping_[p];
+		motion.gravity.set(0.0f, playerGravityY_[p]);
+		motion.stamina = stamina_[p];
+		motion.dashEnergy = dashEnergy_[p];
+		motion.dashDir.set(dashDirX_[p], 0.0f);
+		motion.jumpCount = jumpCount_[p];
+
+		movePlayer(motion, grounded_[p], PlayerInput::fromBits(actions_[p]), deltaTime, nullptr);
+		// A press is consumed by the step that uses it, like the pressed keys of the game
+		actions_[p] &= ~PlayerInput::PressedBits;
+
+		playerVelX_[p] = motion.velocity.x;
+		playerVelY_[p] = motion.velocity.y;
+		playerDamping_[p] = motion.damping;
+		playerGravityY_[p] = motion.gravity.y;
+		stamina_[p] = motion.stamina;
+		dashEnergy_[p] = motion.dashEnergy;
+		dashDirX_[p] = motion.dashDir.x;
+		jumpCount_[p] = motion.jumpCount;
+
+		// Every touched bubble is a point, also one already taken by the other player in the same step
+		for (unsigned int i = 0; i < numBubbles; i++)
+		{
+			if (playerBubbles[player] & bubbleBit(i))
+			{
+				if ((killedBubbles & bubbleBit(i)) == 0)
+					numCatchedBubbles_[arena]++;
+				killedBubbles |= bubbleBit(i);
+				points_[p]++;
+			}
+		}
+	}
+
+	// Bubbles that reached the ground, as in `Bubble::simulate()`
+	for (unsigned int i = 0; i < numBubbles; i++)
+	{
+		if ((groundedBubbles & bubbleBit(i)) && (killedBubbles & bubbleBit(i)) == 0)
+		{
+			killedBubbles |= bubbleBit(i);
+			numDroppedBubbles_[arena]++;
+		}
+	}
+
+	// The last alive bubble takes the place of each removed one
+	unsigned int numAlive = numBubbles;
+	unsigned int i = 0;
+	while (i < numAlive)
+	{
+		if (killedBubbles & bubbleBit(i))
+		{
+			const unsigned int last = numAlive - 1;
+			posX[i] = posX[last];
+			posY[i] = posY[last];
+			velX[i] = velX[last];
+			velY[i] = velY[last];
+			killedBubbles = (killedBubbles & ~bubbleBit(i)) | (((killedBubbles >> last) & 1) << i);
+			numAlive--;
+		}
+		else
+			i++;
+	}
+	numBubbles_[arena] = numAlive;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <nctl/Array.h>
+#include <nctl/UniquePtr.h>
+#include <ncine/Vector2.h>
+#include "Config.h"
+#include "PlayerInput.h"
+
+namespace ncine {
+	class AppConfiguration;
+}
+class SpawnScheduler;
+class JobSystem;
+struct SpawnWave;
+
+namespace nc = ncine;
+
+/// Steps many independent two players arenas in lockstep, without scene nodes, sprites or sounds
+/*! Every arena follows the rules of the game by calling the same functions for the body integration, the contact
+ *  tests, the player movement and the spawns, but the state of all arenas is kept in arrays of plain values.
+ *  Arenas are split in ranges that are stepped by the threads of a job system, the calling thread included.
+ *  An arena only depends on its own seed and actions, the results do not change with the number of threads. */
+class ArenaBatch
+{
+  public:
+	/// What a player can know about its arena, positions are in arena coordinates
+	struct PlayerObservation
+	{
+		nc::Vector2f position;
+		nc::Vector2f velocity;
+		nc::Vector2f opponentPosition;
+		float stamina = 0.0f;
+		bool grounded = false;
+		bool dashing = false;
+		int jumpCount = 0;
+		unsigned int points = 0;
+		float secondsLeft = 0.0f;
+		unsigned int numBubbles = 0;
+		/// Nearest bubbles first, relative to the player position
+		nc::Vector2f nearestBubbles[Cfg::Arena::NumObservedBubbles];
+		unsigned int numNearestBubbles = 0;
+	};
+
+	/// Counters summed over every arena since the batch has been created
+	struct Totals
+	{
+		unsigned long int numSteps = 0;
+		unsigned int numMatches = 0;
+		unsigned int numCatchedBubbles = 0;
+		unsigned int numDroppedBubbles = 0;
+	};
+
+	/// One thread steps every arena, zero threads uses every hardware thread
+	ArenaBatch(unsigned int numArenas, unsigned int numThreads, uint64_t seed);
+	~ArenaBatch();
+
+	inline unsigned int numArenas() const { return numArenas_; }
+	unsigned int numThreads() const;
+
+	/// Replaces the default spawn waves and restarts every arena
+	void setWaves(const nctl::Array<SpawnWave> &waves);
+	/// Starts a new match in every arena, the seeds only depend on the batch seed and on the arena index
+	void reset();
+
+	/// Movement is applied on every following step until it is changed, a jump or a dash only on the next step
+	void setAction(unsigned int arena, unsigned int player, const PlayerInput &input);
+	/// Advances every arena by `Cfg::Arena::StepLength`, a finished match is restarted in place
+	void step();
+	void observe(unsigned int arena, unsigned int player, PlayerObservation &observation) const;
+	inline unsigned int numBubbles(unsigned int arena) const { return numBubbles_[arena]; }
+	/// Alive bubbles are at the indices from zero to `numBubbles(arena) - 1`
+	inline nc::Vector2f bubblePosition(unsigned int arena, unsigned int index) const
+	{
+		return nc::Vector2f(bubblePosX_[arena * MaxBubbles + index], bubblePosY_[arena * MaxBubbles + index]);
+	}
+	Totals totals() const;
+
+	/// Returns the number of arenas passed on the command line, zero if the simulator has not been requested
+	static unsigned int requestedArenas(const nc::AppConfiguration &config);
+	/// Measures the arena steps per second with an increasing number of threads and logs the results
+	/*! Every arena is played by bots, their actions are chosen outside of the measured time */
+	static void measureThroughput(unsigned int numArenas);
+
+  private:
+	static const unsigned int NumPlayers = 2;
+	static const unsigned int MaxBubbles = Cfg::Arena::MaxBubbles;
+	static_assert(MaxBubbles <= 64, "The bubbles of an arena are tracked in 64 bit masks");
+
+	unsigned int numArenas_;
+	/// Not the one shared by the game, as the throughput test changes the number of threads
+	nctl::UniquePtr<JobSystem> jobSystem_;
+	uint64_t seed_;
+	float arenaWidth_;
+	float arenaHeight_;
+
+	/// Per arena state
+	nctl::UniquePtr<float[]> matchTime_;
+	nctl::UniquePtr<unsigned int[]> numBubbles_;
+	nctl::UniquePtr<unsigned int[]> numMatches_;
+	nctl::UniquePtr<unsigned int[]> numCatchedBubbles_;
+	nctl::UniquePtr<unsigned int[]> numDroppedBubbles_;
+	nctl::UniquePtr<SpawnScheduler[]> spawnSchedulers_;
+
+	/// Per player state, player `p` of arena `a` is at index `a * NumPlayers + p`
+	nctl::UniquePtr<float[]> playerPosX_;
+	nctl::UniquePtr<float[]> playerPosY_;
+	nctl::UniquePtr<float[]> playerVelX_;
+	nctl::UniquePtr<float[]> playerVelY_;
+	nctl::UniquePtr<float[]> playerDamping_;
+	nctl::UniquePtr<float[]> playerGravityY_;
+	nctl::UniquePtr<float[]> stamina_;
+	nctl::UniquePtr<float[]> dashEnergy_;
+	nctl::UniquePtr<float[]> dashDirX_;
+	nctl::UniquePtr<int[]> jumpCount_;
+	nctl::UniquePtr<unsigned int[]> points_;
+	nctl::UniquePtr<bool[]> grounded_;
+	/// Packed as `PlayerInput::toBits()`
+	nctl::UniquePtr<uint8_t[]> actions_;
+
+	/// Per bubble state, bubble `b` of arena `a` is at index `a * MaxBubbles + b`, alive bubbles are packed at the start
+	nctl::UniquePtr<float[]> bubblePosX_;
+	nctl::UniquePtr<float[]> bubblePosY_;
+	nctl::UniquePtr<float[]> bubbleVelX_;
+	nctl::UniquePtr<float[]> bubbleVelY_;
+
+	/// Steps of a single arena, they are the same for all of them
+	unsigned long int numSteps_;
+
+	void resetArena(unsigned int arena);
+	void spawnBubbles(unsigned int arena);
+	void stepArena(unsigned int arena);
+};
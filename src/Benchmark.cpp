@@ -0,0 +1,314 @@
+#include <ncine/config.h>
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	#include <ncine/imgui.h>
+#endif
+
+#include "Benchmark.h"
+#include "Config.h"
+#include "RenderStats.h"
+#include "ShaderEffects.h"
+#include "GpuProfiler.h"
+#include "QualityScaler.h"
+#include "GameSnapshot.h"
+#include "main.h"
+#include "nodes/Game.h"
+
+#include <cstring>
+#include <nctl/String.h>
+#include <ncine/Application.h>
+#include <ncine/AppConfiguration.h>
+#include <ncine/FileSystem.h>
+#include <ncine/IFile.h>
+
+namespace {
+	nctl::String auxString(512);
+
+	/// Pass names declared by `ShaderEffects`, the screen pass is also measured without shaders
+	const char *GpuPassNames[] = { "Background", "Scene", "Scene blending", "Foreground", "Screen" };
+	const char *GpuPassColumns[] = { "gpu_background_ms", "gpu_scene_ms", "gpu_scene_blending_ms", "gpu_foreground_ms", "gpu_screen_ms" };
+}
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS AND DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+Benchmark::Benchmark(MyEventHandler *eventHandler)
+    : eventHandler_(eventHandler), state_(State::SETUP), stageIndex_(0),
+      results_(NumStages), snapshot_(nctl::makeUnique<GameSnapshot>()),
+      settingsApplied_(false), savedWithShaders_(false), savedNumPlayers_(0)
+{
+}
+
+Benchmark::~Benchmark() = default;
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+bool Benchmark::isRequested(const nc::AppConfiguration &config)
+{
+	for (int i = 1; i < config.argc(); i++)
+	{
+		if (strcmp(config.argv(i), Cfg::Benchmark::CommandLineArg) == 0)
+			return true;
+	}
+	return false;
+}
+
+void Benchmark::applySettings()
+{
+	Settings &settings = eventHandler_->settingsMut();
+	savedWithShaders_ = settings.withShaders;
+	savedNumPlayers_ = settings.numPlayers;
+	settingsApplied_ = true;
+
+	// Two AI players and no shaders until the first stage has been setup
+	settings.numPlayers = 2;
+	settings.withShaders = false;
+	// Every stage is measured with the quality it asks for
+	eventHandler_->qualityScaler().setEnabled(false);
+}
+
+void Benchmark::restoreSettings()
+{
+	if (settingsApplied_ == false)
+		return;
+
+	Settings &settings = eventHandler_->settingsMut();
+	settings.withShaders = savedWithShaders_;
+	settings.numPlayers = savedNumPlayers_;
+	settingsApplied_ = false;
+}
+
+void Benchmark::onFrameStart(Game &game)
+{
+	switch (state_)
+	{
+		case State::SETUP:
+			setupStage(game);
+			break;
+		case State::WARM_UP:
+			if (stageTimer_.secondsSince() >= Cfg::Benchmark::WarmUpTime)
+			{
+				frameProfiler().reset();
+				current_.numFrames = 0;
+				current_.averageFrameTime = 0.0f;
+				current_.averageRenderCommands = 0.0f;
+				current_.averagePhysicsTime = 0.0f;
+				current_.averageAliveBubbles = 0.0f;
+				current_.averageGpuTime = 0.0f;
+				for (unsigned int i = 0; i < NumGpuPasses; i++)
+					current_.averageGpuPassTimes[i] = 0.0f;
+				stageTimer_.toNow();
+				state_ = State::MEASURE;
+			}
+			break;
+		case State::MEASURE:
+			accumulateFrame(game);
+			if (stageTimer_.secondsSince() >= Cfg::Benchmark::MeasureTime)
+			{
+				measureSnapshots(game);
+				measureResimulation(game);
+				finishStage();
+			}
+			break;
+		case State::FINISHED:
+			break;
+	}
+}
+
+void Benchmark::drawGui()
+{
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	if (ImGui::TreeNodeEx("Benchmark", ImGuiTreeNodeFlags_DefaultOpen))
+	{
+		if (state_ != State::FINISHED)
+		{
+			ImGui::Text("Stage %u of %u: %u bubbles, shaders %s", stageIndex_ + 1, NumStages,
+			            current_.numBubbles, current_.withShaders ? "on" : "off");
+			ImGui::Text("State: %s", (state_ == State::MEASURE) ? "measuring" : "warming up");
+		}
+		else
+			ImGui::TextUnformatted("Finished");
+
+		for (const Result &result : results_)
+		{
+			ImGui::BulletText("%u bubbles, shaders %s: avg %.2f ms, p99 %.2f ms, %.0f commands, physics %.2f ms, GPU %.2f ms, snapshot %.1f/%.1f us, resim %.2f ms",
+			                  result.numBubbles, result.withShaders ? "on" : "off", result.averageFrameTime,
+			                  result.frameTimes.p99, result.averageRenderCommands, result.averagePhysicsTime, result.averageGpuTime,
+			                  result.averageSnapshotSaveTime, result.averageSnapshotRestoreTime, result.averageResimulationTime);
+		}
+
+		ImGui::TreePop();
+	}
+#endif
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void Benchmark::setupStage(Game &game)
+{
+	const bool shadersAvailable = eventHandler_->shaderEffects().isInitialized();
+
+	// Stages alternate shaders on and off for every bubble count
+	while (stageIndex_ < NumStages && (stageIndex_ % 2) == 0 && shadersAvailable == false)
+	{
+		LOGW_X("Shader effects are not available, skipping benchmark stage %u", stageIndex_);
+		stageIndex_++;
+	}
+
+	if (stageIndex_ >= NumStages)
+	{
+		restoreSettings();
+		if (writeResults())
+			LOGI_X("Benchmark results written to: %s", nc::fs::joinPath(nc::fs::savePath(), Cfg::Benchmark::ResultsFilename).data());
+		state_ = State::FINISHED;
+		nc::theApplication().quit();
+		return;
+	}
+
+	current_ = {};
+	current_.numBubbles = Cfg::Benchmark::StageBubbles[stageIndex_ / 2];
+	current_.withShaders = (stageIndex_ % 2) == 0;
+
+	Settings &settings = eventHandler_->settingsMut();
+	if (settings.withShaders != current_.withShaders)
+	{
+		settings.withShaders = current_.withShaders;
+		game.requestShaderEffectsChange();
+	}
+	game.setBubbleSpawnTarget(current_.numBubbles);
+
+	LOGI_X("Benchmark stage %u: %u bubbles, shaders %s", stageIndex_, current_.numBubbles, current_.withShaders ? "on" : "off");
+	stageTimer_.toNow();
+	state_ = State::WARM_UP;
+}
+
+void Benchmark::accumulateFrame(const Game &game)
+{
+	// Running averages avoid keeping per-frame samples for the whole stage
+	current_.numFrames++;
+	const float weight = 1.0f / static_cast<float>(current_.numFrames);
+
+	const float frameTime = nc::theApplication().frameTime() * 1000.0f;
+	const float renderCommands = static_cast<float>(RenderStats::collect().numCommands());
+	const float physicsTime = frameProfiler().lastZoneTime(FrameProfiler::Zone::PHYSICS);
+	const float aliveBubbles = static_cast<float>(game.numAliveBubbles());
+
+	current_.averageFrameTime += (frameTime - current_.averageFrameTime) * weight;
+	current_.averageRenderCommands += (renderCommands - current_.averageRenderCommands) * weight;
+	current_.averagePhysicsTime += (physicsTime - current_.averagePhysicsTime) * weight;
+	current_.averageAliveBubbles += (aliveBubbles - current_.averageAliveBubbles) * weight;
+
+	const GpuProfiler &gpuProfiler = eventHandler_->gpuProfiler();
+	current_.averageGpuTime += (gpuProfiler.lastTotalTime() - current_.averageGpuTime) * weight;
+	for (unsigned int i = 0; i < NumGpuPasses; i++)
+	{
+		const float passTime = gpuProfiler.lastPassTime(GpuPassNames[i]);
+		current_.averageGpuPassTimes[i] += (passTime - current_.averageGpuPassTimes[i]) * weight;
+	}
+}
+
+void Benchmark::measureSnapshots(Game &game)
+{
+	float saveTime = 0.0f;
+	float restoreTime = 0.0f;
+	for (unsigned int i = 0; i < Cfg::Benchmark::NumSnapshotRoundTrips; i++)
+	{
+		const nc::TimeStamp saveStart = nc::TimeStamp::now();
+		game.saveSnapshot(*snapshot_);
+		saveTime += saveStart.secondsSince();
+
+		const nc::TimeStamp restoreStart = nc::TimeStamp::now();
+		game.restoreSnapshot(*snapshot_);
+		restoreTime += restoreStart.secondsSince();
+	}
+
+	const float numRoundTrips = static_cast<float>(Cfg::Benchmark::NumSnapshotRoundTrips);
+	current_.averageSnapshotSaveTime = (saveTime / numRoundTrips) * 1000000.0f;
+	current_.averageSnapshotRestoreTime = (restoreTime / numRoundTrips) * 1000000.0f;
+	current_.snapshotBytes = snapshot_->usedBytes();
+}
+
+void Benchmark::measureResimulation(Game &game)
+{
+	const float stepLength = 1.0f / static_cast<float>(Cfg::Netplay::TickRate);
+	game.saveSnapshot(*snapshot_);
+
+	// The inputs are recorded in a forward pass and replayed by every resimulation, like `RollbackSession` does
+	PlayerInput inputs[Cfg::Netplay::MaxRollbackFrames][2];
+	for (unsigned int j = 0; j < Cfg::Netplay::MaxRollbackFrames; j++)
+	{
+		game.pollInputs(inputs[j]);
+		game.step(stepLength, inputs[j], true);
+	}
+	game.restoreSnapshot(*snapshot_);
+
+	float resimulationTime = 0.0f;
+	for (unsigned int i = 0; i < Cfg::Benchmark::NumResimulations; i++)
+	{
+		const nc::TimeStamp resimulationStart = nc::TimeStamp::now();
+		for (unsigned int j = 0; j < Cfg::Netplay::MaxRollbackFrames; j++)
+			game.step(stepLength, inputs[j], true);
+		resimulationTime += resimulationStart.secondsSince();
+		game.restoreSnapshot(*snapshot_);
+	}
+
+	current_.averageResimulationTime = (resimulationTime / static_cast<float>(Cfg::Benchmark::NumResimulations)) * 1000.0f;
+}
+
+void Benchmark::finishStage()
+{
+	current_.frameTimes = frameProfiler().summary();
+	results_.pushBack(current_);
+
+	LOGI_X("Benchmark stage %u: avg %.2f ms, p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms", stageIndex_,
+	       current_.averageFrameTime, current_.frameTimes.p50, current_.frameTimes.p95, current_.frameTimes.p99, current_.frameTimes.max);
+	LOGI_X("Benchmark stage %u: snapshot of %u bytes, save %.1f us, restore %.1f us", stageIndex_,
+	       current_.snapshotBytes, current_.averageSnapshotSaveTime, current_.averageSnapshotRestoreTime);
+	LOGI_X("Benchmark stage %u: resimulating %u frames takes %.2f ms, the frame budget is %.2f ms", stageIndex_,
+	       Cfg::Netplay::MaxRollbackFrames, current_.averageResimulationTime, 1000.0f / static_cast<float>(Cfg::Netplay::TickRate));
+
+	stageIndex_++;
+	state_ = State::SETUP;
+}
+
+bool Benchmark::writeResults() const
+{
+	const nctl::String resultsFilepath = nc::fs::joinPath(nc::fs::savePath(), Cfg::Benchmark::ResultsFilename);
+
+	const nctl::String resultsDirpath = nc::fs::dirName(resultsFilepath.data());
+	if (nc::fs::isDirectory(resultsDirpath.data()) == false)
+		nc::fs::createDir(resultsDirpath.data());
+
+	nctl::UniquePtr<nc::IFile> file = nc::IFile::createFileHandle(resultsFilepath.data());
+	file->open(nc::IFile::OpenMode::WRITE | nc::IFile::OpenMode::BINARY);
+	if (file->isOpened() == false)
+	{
+		LOGW_X("Cannot open benchmark results file for writing: %s", resultsFilepath.data());
+		return false;
+	}
+
+	auxString = "bubbles,shaders,frames,avg_ms,p50_ms,p95_ms,p99_ms,max_ms,render_commands,physics_ms,alive_bubbles,gpu_ms";
+	for (unsigned int i = 0; i < NumGpuPasses; i++)
+		auxString.formatAppend(",%s", GpuPassColumns[i]);
+	auxString.formatAppend(",snapshot_save_us,snapshot_restore_us,snapshot_bytes,resim_ms\n");
+	file->write(auxString.data(), auxString.length());
+	for (const Result &result : results_)
+	{
+		auxString.format("%u,%s,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.1f,%.3f,%.1f,%.3f", result.numBubbles, result.withShaders ? "on" : "off",
+		                 result.numFrames, result.averageFrameTime, result.frameTimes.p50, result.frameTimes.p95,
+		                 result.frameTimes.p99, result.frameTimes.max, result.averageRenderCommands,
+		                 result.averagePhysicsTime, result.averageAliveBubbles, result.averageGpuTime);
+		for (unsigned int i = 0; i < NumGpuPasses; i++)
+			auxString.formatAppend(",%.3f", result.averageGpuPassTimes[i]);
+		auxString.formatAppend(",%.2f,%.2f,%u,%.3f\n", result.averageSnapshotSaveTime, result.averageSnapshotRestoreTime,
+		                       result.snapshotBytes, result.averageResimulationTime);
+		file->write(auxString.data(), auxString.length());
+	}
+	file->close();
+
+	return true;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <nctl/Array.h>
+#include <nctl/UniquePtr.h>
+#include <ncine/TimeStamp.h>
+#include "FrameProfiler.h"
+
+namespace ncine {
+	class AppConfiguration;
+}
+class MyEventHandler;
+class Game;
+struct GameSnapshot;
+
+namespace nc = ncine;
+
+/// Drives the game through stages with increasing bubble counts and writes frame statistics to a CSV file
+class Benchmark
+{
+  public:
+	explicit Benchmark(MyEventHandler *eventHandler);
+	~Benchmark();
+
+	/// Returns true if the benchmark argument has been passed on the command line
+	static bool isRequested(const nc::AppConfiguration &config);
+
+	inline bool isFinished() const { return state_ == State::FINISHED; }
+
+	/// Forces the settings needed by the benchmark, to be called before creating the game
+	void applySettings();
+	/// Restores the user settings, so that the benchmark does not change the saved ones
+	void restoreSettings();
+
+	void onFrameStart(Game &game);
+	void drawGui();
+
+  private:
+	enum class State
+	{
+		SETUP,
+		WARM_UP,
+		MEASURE,
+		FINISHED
+	};
+
+	/// GPU passes of the game render graph written to the results, the blur ones never run as the game is not paused
+	static const unsigned int NumGpuPasses = 5;
+
+	struct Result
+	{
+		unsigned int numBubbles = 0;
+		bool withShaders = false;
+		unsigned int numFrames = 0;
+		/// Percentiles are computed over the last `Cfg::FrameStats::NumSamples` frames of the stage
+		FrameProfiler::Summary frameTimes;
+		float averageFrameTime = 0.0f;
+		float averageRenderCommands = 0.0f;
+		float averagePhysicsTime = 0.0f;
+		float averageAliveBubbles = 0.0f;
+		/// Zero when timer queries are not available
+		float averageGpuTime = 0.0f;
+		float averageGpuPassTimes[NumGpuPasses] = {};
+		/// Snapshot round trips of the alive bubbles at the end of the stage, in microseconds
+		float averageSnapshotSaveTime = 0.0f;
+		float averageSnapshotRestoreTime = 0.0f;
+		unsigned int snapshotBytes = 0;
+		/// A worst case rollback, `Cfg::Netplay::MaxRollbackFrames` steps resimulated from a snapshot, in milliseconds
+		float averageResimulationTime = 0.0f;
+	};
+
+	static const unsigned int NumStages = Cfg::Benchmark::NumStages * 2;
+
+	MyEventHandler *eventHandler_;
+	State state_;
+	unsigned int stageIndex_;
+	nc::TimeStamp stageTimer_;
+
+	/// Accumulators for the stage being measured
+	Result current_;
+	nctl::Array<Result> results_;
+	/// Allocated once, it is large enough for a full bubble pool
+	nctl::UniquePtr<GameSnapshot> snapshot_;
+
+	bool settingsApplied_;
+	bool savedWithShaders_;
+	unsigned int savedNumPlayers_;
+
+	void setupStage(Game &game);
+	void accumulateFrame(const Game &game);
+	/// Saves and restores the game state a number of times, restoring the state just saved does not change the match
+	void measureSnapshots(Game &game);
+	/// Resimulates the deepest rollback a number of times with recorded inputs, the state is restored after each of them
+	void measureResimulation(Game &game);
+	void finishStage();
+	bool writeResults() const;
+};
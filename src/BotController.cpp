@@ -0,0 +1,148 @@
+#include <ncine/config.h>
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	#include <ncine/imgui.h>
+#endif
+
+#include <cmath>
+#include "BotController.h"
+#include "BubbleGrid.h"
+#include "Config.h"
+
+namespace {
+	const char *DifficultyNames[] = { "Easy", "Normal", "Hard" };
+
+	inline const Cfg::BotProfile &profile(BotDifficulty difficulty)
+	{
+		return Cfg::Bot::Profiles[static_cast<unsigned int>(difficulty)];
+	}
+}
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS AND DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+BotController::BotController()
+    : difficulty_(BotDifficulty::NORMAL), hasTarget_(false), target_(0.0f, 0.0f), aimOffset_(0.0f),
+      stepsToDecision_(0), jumpCooldown_(0), dashCooldown_(0)
+{
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void BotController::setDifficulty(BotDifficulty difficulty)
+{
+	ASSERT(difficulty < BotDifficulty::COUNT);
+	difficulty_ = difficulty;
+	// A slower bot should not keep the old target for longer than its own reaction time
+	stepsToDecision_ = 0;
+}
+
+void BotController::seed(uint64_t initState, uint64_t initSequence)
+{
+	random_.init(initState, initSequence);
+}
+
+void BotController::reset()
+{
+	hasTarget_ = false;
+	aimOffset_ = 0.0f;
+	stepsToDecision_ = 0;
+	jumpCooldown_ = 0;
+	dashCooldown_ = 0;
+}
+
+/// Runs towards the target, jumping when it is within reach and dashing when it is far away
+PlayerInput BotController::think(const BotView &view, const BubbleGrid &bubbles)
+{
+	const Cfg::BotProfile &botProfile = profile(difficulty_);
+	PlayerInput input;
+
+	if (stepsToDecision_ == 0)
+	{
+		chooseTarget(view, bubbles);
+		stepsToDecision_ = botProfile.reactionSteps;
+	}
+	stepsToDecision_--;
+	if (jumpCooldown_ > 0)
+		jumpCooldown_--;
+	if (dashCooldown_ > 0)
+		dashCooldown_--;
+
+	if (hasTarget_ == false)
+		return input;
+
+	const nc::Vector2f distance(target_.x + aimOffset_ - view.position.x, target_.y - view.position.y);
+	input.left = (distance.x < -Cfg::Bot::DeadZone);
+	input.right = (distance.x > Cfg::Bot::DeadZone);
+
+	// Only jump again when falling, to avoid wasting the double jump on the way up
+	const bool canJump = view.grounded ||
+	                     (botProfile.useDoubleJump && view.velocity.y < 0.0f && view.jumpCount < Cfg::Player::MaxJumpCount);
+	if (jumpCooldown_ == 0 && canJump && distance.y > 0.0f && distance.length() < Cfg::Bot::JumpReach)
+	{
+		input.jump = true;
+		jumpCooldown_ = Cfg::Bot::ActionCooldownSteps;
+	}
+
+	if (dashCooldown_ == 0 && fabsf(distance.x) > Cfg::Bot::DashDistance && view.stamina >= botProfile.dashStamina)
+	{
+		input.dash = true;
+		dashCooldown_ = Cfg::Bot::ActionCooldownSteps;
+	}
+
+	return input;
+}
+
+const char *BotController::difficultyName(BotDifficulty difficulty)
+{
+	ASSERT(difficulty < BotDifficulty::COUNT);
+	return DifficultyNames[static_cast<unsigned int>(difficulty)];
+}
+
+void BotController::drawGui()
+{
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	int difficulty = static_cast<int>(difficulty_);
+	if (ImGui::Combo("Bot difficulty", &difficulty, DifficultyNames, static_cast<int>(BotDifficulty::COUNT)))
+		setDifficulty(static_cast<BotDifficulty>(difficulty));
+
+	if (hasTarget_)
+		ImGui::Text("Target: <%.1f, %.1f>, aim offset: %.1f", target_.x, target_.y, aimOffset_);
+	else
+		ImGui::TextUnformatted("Target: none");
+#endif
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+/// Prefers the bubbles that are close and low, as they are the first ones to reach the ground
+void BotController::chooseTarget(const BotView &view, const BubbleGrid &bubbles)
+{
+	nc::Vector2f candidates[Cfg::Bot::MaxCandidates];
+	const nc::Rectf searchRect(view.position.x - Cfg::Bot::SearchHalfSize.x, view.position.y - Cfg::Bot::SearchHalfSize.y,
+	                           Cfg::Bot::SearchHalfSize.x * 2.0f, Cfg::Bot::SearchHalfSize.y * 2.0f);
+	unsigned int numCandidates = bubbles.query(searchRect, candidates, Cfg::Bot::MaxCandidates);
+	if (numCandidates == 0)
+		numCandidates = bubbles.query(bubbles.area(), candidates, Cfg::Bot::MaxCandidates);
+
+	hasTarget_ = false;
+	float minCost = 0.0f;
+	for (unsigned int i = 0; i < numCandidates; i++)
+	{
+		const nc::Vector2f distance = candidates[i] - view.position;
+		const float cost = fabsf(distance.x) + fmaxf(distance.y, 0.0f) * Cfg::Bot::HeightCost;
+		if (hasTarget_ == false || cost < minCost)
+		{
+			target_ = candidates[i];
+			minCost = cost;
+			hasTarget_ = true;
+		}
+	}
+
+	const float aimError = profile(difficulty_).aimError;
+	aimOffset_ = (aimError > 0.0f) ? random_.fastReal(-aimError, aimError) : 0.0f;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <ncine/Vector2.h>
+#include <ncine/Random.h>
+#include "PlayerInput.h"
+
+class BubbleGrid;
+
+namespace nc = ncine;
+
+enum class BotDifficulty
+{
+	EASY,
+	NORMAL,
+	HARD,
+
+	COUNT
+};
+
+/// The state of the player driven by a bot, from a `Player` node or from a headless arena
+struct BotView
+{
+	nc::Vector2f position;
+	nc::Vector2f velocity;
+	float stamina = 0.0f;
+	int jumpCount = 0;
+	bool grounded = false;
+};
+
+/// Plays the game through the same actions as a human player, chasing the alive bubbles
+/*! The target is chosen among the bubbles near the player with a query to a shared grid, every few steps
+ *  depending on the difficulty. In between, the bot only steers towards the position it has chosen. */
+class BotController
+{
+  public:
+	BotController();
+
+	inline BotDifficulty difficulty() const { return difficulty_; }
+	void setDifficulty(BotDifficulty difficulty);
+	/// The same seed with the same views leads to the same actions
+	void seed(uint64_t initState, uint64_t initSequence);
+	/// Forgets the current target, to be called when a new match starts
+	void reset();
+
+	/// Returns the actions for the next step, the grid has to be built with the positions of the alive bubbles
+	PlayerInput think(const BotView &view, const BubbleGrid &bubbles);
+
+	static const char *difficultyName(BotDifficulty difficulty);
+	void drawGui();
+
+  private:
+	BotDifficulty difficulty_;
+	/// Not the global generator, so that bots do not change the spawns of a match
+	nc::Random random_;
+
+	bool hasTarget_;
+	nc::Vector2f target_;
+	float aimOffset_;
+	unsigned int stepsToDecision_;
+	unsigned int jumpCooldown_;
+	unsigned int dashCooldown_;
+
+	void chooseTarget(const BotView &view, const BubbleGrid &bubbles);
+};
@@ -0,0 +1,119 @@
+#include <cmath>
+#include "BubbleGrid.h"
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS AND DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+BubbleGrid::BubbleGrid(unsigned int capacity)
+    : capacity_(capacity), numPoints_(0), area_(0.0f, 0.0f, 0.0f, 0.0f), cellSize_(0.0f), gridWidth_(0), gridHeight_(0)
+{
+	points_ = nctl::makeUnique<nc::Vector2f[]>(capacity_);
+	pointCells_ = nctl::makeUnique<unsigned int[]>(capacity_);
+	sortedPoints_ = nctl::makeUnique<nc::Vector2f[]>(capacity_);
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void BubbleGrid::setupArea(const nc::Rectf &area, float cellSize)
+{
+	FATAL_ASSERT(cellSize > 0.0f);
+	area_ = area;
+	cellSize_ = cellSize;
+
+	gridWidth_ = static_cast<unsigned int>(ceilf(area_.w / cellSize_));
+	gridHeight_ = static_cast<unsigned int>(ceilf(area_.h / cellSize_));
+	if (gridWidth_ == 0)
+		gridWidth_ = 1;
+	if (gridHeight_ == 0)
+		gridHeight_ = 1;
+
+	cellStarts_ = nctl::makeUnique<unsigned int[]>(gridWidth_ * gridHeight_ + 1);
+	clear();
+	build();
+}
+
+void BubbleGrid::clear()
+{
+	numPoints_ = 0;
+}
+
+void BubbleGrid::addPoint(const nc::Vector2f &position)
+{
+	if (numPoints_ >= capacity_ || cellStarts_ == nullptr)
+		return;
+
+	unsigned int cellX = 0;
+	unsigned int cellY = 0;
+	cellCoordinates(position, cellX, cellY);
+	points_[numPoints_] = position;
+	pointCells_[numPoints_] = cellY * gridWidth_ + cellX;
+	numPoints_++;
+}
+
+void BubbleGrid::build()
+{
+	if (cellStarts_ == nullptr)
+		return;
+
+	const unsigned int numCells = gridWidth_ * gridHeight_;
+	for (unsigned int i = 0; i <= numCells; i++)
+		cellStarts_[i] = 0;
+
+	// Each cell counts its points in the slot of the following one, the prefix sum turns the counts into starts
+	for (unsigned int i = 0; i < numPoints_; i++)
+		cellStarts_[pointCells_[i] + 1]++;
+	for (unsigned int i = 0; i < numCells; i++)
+		cellStarts_[i + 1] += cellStarts_[i];
+
+	// The starts are advanced while scattering, then shifted back by one cell
+	for (unsigned int i = 0; i < numPoints_; i++)
+		sortedPoints_[cellStarts_[pointCells_[i]]++] = points_[i];
+	for (unsigned int i = numCells; i > 0; i--)
+		cellStarts_[i] = cellStarts_[i - 1];
+	cellStarts_[0] = 0;
+}
+
+unsigned int BubbleGrid::query(const nc::Rectf &rect, nc::Vector2f *points, unsigned int maxPoints) const
+{
+	if (cellStarts_ == nullptr || numPoints_ == 0)
+		return 0;
+
+	unsigned int minCellX = 0;
+	unsigned int minCellY = 0;
+	unsigned int maxCellX = 0;
+	unsigned int maxCellY = 0;
+	cellCoordinates(nc::Vector2f(rect.x, rect.y), minCellX, minCellY);
+	cellCoordinates(nc::Vector2f(rect.x + rect.w, rect.y + rect.h), maxCellX, maxCellY);
+
+	unsigned int numPoints = 0;
+	for (unsigned int cellY = minCellY; cellY <= maxCellY; cellY++)
+	{
+		for (unsigned int cellX = minCellX; cellX <= maxCellX; cellX++)
+		{
+			const unsigned int cell = cellY * gridWidth_ + cellX;
+			for (unsigned int i = cellStarts_[cell]; i < cellStarts_[cell + 1]; i++)
+			{
+				if (numPoints == maxPoints)
+					return numPoints;
+				points[numPoints++] = sortedPoints_[i];
+			}
+		}
+	}
+
+	return numPoints;
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void BubbleGrid::cellCoordinates(const nc::Vector2f &position, unsigned int &cellX, unsigned int &cellY) const
+{
+	const float x = floorf((position.x - area_.x) / cellSize_);
+	const float y = floorf((position.y - area_.y) / cellSize_);
+	cellX = (x < 0.0f) ? 0 : ((x >= static_cast<float>(gridWidth_)) ? gridWidth_ - 1 : static_cast<unsigned int>(x));
+	cellY = (y < 0.0f) ? 0 : ((y >= static_cast<float>(gridHeight_)) ? gridHeight_ - 1 : static_cast<unsigned int>(y));
+}
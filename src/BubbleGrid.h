@@ -0,0 +1,48 @@
+#pragma once
+
+#include <nctl/UniquePtr.h>
+#include <ncine/Rect.h>
+#include <ncine/Vector2.h>
+
+namespace nc = ncine;
+
+/// Buckets the positions of the alive bubbles in a uniform grid, to find the ones around a point without visiting all of them
+/*! The grid is filled again once per step and is then shared by every query of that step.
+ *  Points are sorted by cell with a counting sort, so building it never allocates. */
+class BubbleGrid
+{
+  public:
+	explicit BubbleGrid(unsigned int capacity);
+
+	/// Positions outside of the area are stored in the nearest border cell
+	void setupArea(const nc::Rectf &area, float cellSize);
+	inline const nc::Rectf &area() const { return area_; }
+
+	void clear();
+	/// Points added past the capacity are ignored
+	void addPoint(const nc::Vector2f &position);
+	/// Sorts the points by cell, to be called after adding all of them and before any query
+	void build();
+	inline unsigned int numPoints() const { return numPoints_; }
+
+	/// Copies the points of the cells overlapping the rectangle, up to `maxPoints`, and returns how many have been copied
+	unsigned int query(const nc::Rectf &rect, nc::Vector2f *points, unsigned int maxPoints) const;
+
+  private:
+	unsigned int capacity_;
+	unsigned int numPoints_;
+
+	nc::Rectf area_;
+	float cellSize_;
+	unsigned int gridWidth_;
+	unsigned int gridHeight_;
+
+	/// Points in the order they have been added, with the index of their cell
+	nctl::UniquePtr<nc::Vector2f[]> points_;
+	nctl::UniquePtr<unsigned int[]> pointCells_;
+	/// Points sorted by cell, the ones of cell `i` go from `cellStarts_[i]` to `cellStarts_[i + 1]`
+	nctl::UniquePtr<nc::Vector2f[]> sortedPoints_;
+	nctl::UniquePtr<unsigned int[]> cellStarts_;
+
+	void cellCoordinates(const nc::Vector2f &position, unsigned int &cellX, unsigned int &cellY) const;
+};
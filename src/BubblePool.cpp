@@ -0,0 +1,77 @@
+#include "BubblePool.h"
+#include "Config.h"
+#include "nodes/Bubble.h"
+
+#include <nctl/String.h>
+#include <ncine/Random.h>
+
+namespace {
+	nctl::String auxString(64);
+}
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS AND DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+BubblePool::BubblePool(nc::SceneNode *parent, unsigned int chunkSize, unsigned int maxSize)
+    : parent_(parent), chunkSize_(chunkSize), maxSize_(maxSize),
+      bubbles_(chunkSize), freeList_(chunkSize)
+{
+	FATAL_ASSERT(chunkSize_ > 0);
+	FATAL_ASSERT(maxSize_ >= chunkSize_);
+	grow();
+}
+
+BubblePool::~BubblePool() = default;
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+unsigned int BubblePool::grow()
+{
+	const unsigned int firstIndex = bubbles_.size();
+	if (firstIndex >= maxSize_)
+		return InvalidIndex;
+
+	const unsigned int numNewBubbles = (maxSize_ - firstIndex < chunkSize_) ? maxSize_ - firstIndex : chunkSize_;
+	const unsigned int newSize = firstIndex + numNewBubbles;
+	// Growing by whole chunks instead of letting the arrays double their capacity
+	if (bubbles_.capacity() < newSize)
+	{
+		bubbles_.setCapacity(newSize);
+		freeList_.setCapacity(newSize);
+	}
+
+	for (unsigned int i = firstIndex; i < newSize; i++)
+	{
+		auxString.format("Bubble #%u", i);
+		const unsigned int variant = nc::random().integer(0, Cfg::Textures::NumBubbleVariants);
+		nctl::UniquePtr<Bubble> bubble = nctl::makeUnique<Bubble>(parent_, auxString.data(), nc::Vector2f::Zero, variant, i);
+		bubble->onKilled();
+		bubbles_.pushBack(nctl::move(bubble));
+	}
+
+	// Pushed in reverse order so that lower indices are acquired first
+	for (unsigned int i = newSize; i > firstIndex; i--)
+		freeList_.pushBack(i - 1);
+
+	return firstIndex;
+}
+
+unsigned int BubblePool::acquire()
+{
+	if (freeList_.isEmpty() && grow() == InvalidIndex)
+		return InvalidIndex;
+
+	const unsigned int index = freeList_.back();
+	freeList_.popBack();
+	return index;
+}
+
+void BubblePool::release(unsigned int index)
+{
+	ASSERT(index < bubbles_.size());
+	ASSERT(freeList_.size() < bubbles_.size());
+	freeList_.pushBack(index);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <nctl/Array.h>
+#include <nctl/UniquePtr.h>
+
+namespace ncine {
+	class SceneNode;
+}
+class Bubble;
+
+namespace nc = ncine;
+
+/// A pool of bubbles that grows in chunks and recycles them through a free-list
+/*! The index of a bubble never changes, so it can be used to associate other resources with it. */
+class BubblePool
+{
+  public:
+	static const unsigned int InvalidIndex = ~0u;
+
+	BubblePool(nc::SceneNode *parent, unsigned int chunkSize, unsigned int maxSize);
+	~BubblePool();
+
+	/// Returns the number of bubbles created so far, both used and free
+	inline unsigned int size() const { return bubbles_.size(); }
+	inline unsigned int maxSize() const { return maxSize_; }
+	inline unsigned int numFree() const { return freeList_.size(); }
+	inline unsigned int numUsed() const { return bubbles_.size() - freeList_.size(); }
+
+	inline Bubble &operator[](unsigned int index) { return *bubbles_[index]; }
+	inline const Bubble &operator[](unsigned int index) const { return *bubbles_[index]; }
+
+	/// Creates a new chunk of bubbles, returns the index of the first one or `InvalidIndex` if the pool is full
+	unsigned int grow();
+	/// Takes a bubble from the free-list, growing the pool if needed, returns `InvalidIndex` on failure
+	unsigned int acquire();
+	/// Gives a bubble back to the free-list
+	void release(unsigned int index);
+
+  private:
+	nc::SceneNode *parent_;
+	unsigned int chunkSize_;
+	unsigned int maxSize_;
+
+	nctl::Array<nctl::UniquePtr<Bubble>> bubbles_;
+	/// Indices of the available bubbles, used as a stack
+	nctl::Array<unsigned int> freeList_;
+};
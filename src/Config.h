@@ -17,11 +17,15 @@ namespace Configuration
 			Gui_StaminaBar_Fill = Gui_StaminaBar + 1,
 			Gui_Text = Gui_StaminaBar + 1,
 			Menu_Page = 512,
+			Overlay = 1024,
 		};
 	}
 
 	char const * const SettingsFilename = "WetPaper/Settings.toml";
 	char const * const StatisticsFilename = "WetPaper/Statistics.toml";
+	char const * const SpawnWavesFilename = "waves.toml";
+	/// Directory of the linked shader program binaries, inside the engine cache path
+	char const * const ShaderCacheDirname = "WetPaperShaderCache";
 
 	namespace Textures
 	{
@@ -130,6 +134,8 @@ namespace Configuration
 		const float BackgroundBubbleSpeed = 150.0f;
 		const float BackgroundBubbleSpeedVariance = 0.25f;
 		const unsigned int MaxMenuEntryLength = 32;
+		/// Seconds without any input on the menu before bots start playing a match
+		const float AttractModeIdleTime = 30.0f;
 	}
 
 	namespace Settings
@@ -141,14 +147,212 @@ namespace Configuration
 		const unsigned int MatchTimeMin = 30;
 		const unsigned int MatchTimeMax = 120;
 		const unsigned int MatchTimeStep = 30;
+
+		/// Number of pause blur quality levels (full, half and quarter resolution)
+		const unsigned int NumBlurQualities = 3;
+
+		/// Fraction of the window resolution at which the background and the scene are rendered
+		const float RenderScaleMin = 0.5f;
+		const float RenderScaleMax = 1.0f;
+		const float RenderScaleStep = 0.25f;
 	}
 
+	namespace Blur
+	{
+		/// Separable blur passes at full, half and quarter resolution, a downsampled pass spreads over more pixels
+		const unsigned int NumPasses[Settings::NumBlurQualities] = { 2, 1, 1 };
+	}
+
+	namespace Upscale
+	{
+		/// Strength of the unsharp mask applied when the scene is upscaled to the window
+		const float Sharpness = 0.5f;
+	}
+
+	namespace WarmUp
+	{
+		/// Width and height of the offscreen target the shader programs are warmed up with
+		const int TargetSize = 16;
+		/// Sprites drawn with the dispersion shader to exercise its batched program
+		const unsigned int NumBatchedSprites = 16;
+	}
+
+	namespace Quality
+	{
+		/// The frame time the quality scaler tries to hold, in milliseconds
+		const float TargetFrameTime = 1000.0f / 60.0f;
+		/// Smoothing factor for the moving average of the frame time
+		const float AverageFactor = 0.05f;
+		/// Frame times are clamped to this factor of the target, a single hitch should not lower the quality
+		const float MaxSampleFactor = 3.0f;
+		/// The average frame time is over budget above this factor of the target
+		const float StepDownFactor = 1.15f;
+		/// The seconds over budget before lowering the quality
+		const float StepDownTime = 1.0f;
+		/// The average frame time is within budget below this factor of the target, vertical sync included
+		const float WithinBudgetFactor = 1.05f;
+		/// When timer queries are available, the GPU time must also be below this factor of the target to raise the quality
+		const float GpuHeadroomFactor = 0.6f;
+		/// The initial seconds within budget before raising the quality
+		const float StepUpTime = 5.0f;
+		/// Every failed attempt to raise the quality doubles the waiting time, up to this value
+		const float MaxStepUpTime = 80.0f;
+		/// Lowering the quality again within these seconds from raising it marks the attempt as failed
+		const float ProbeTime = 5.0f;
+		/// The seconds after a change during which the frame time settles and no other change is made
+		const float CooldownTime = 1.0f;
+	}
+
+	/// A static box of the arena, its position is relative to the screen size
+	struct ObstacleData
+	{
+		nc::Vector2f relativePosition;
+		nc::Vector2f halfSize;
+	};
+
 	namespace Game
 	{
 		const nc::Vector2i Resolution(1920, 1080);
-		const unsigned int BubblePoolSize = 25;
+		/// Number of bubbles created every time the pool grows
+		const unsigned int BubblePoolChunkSize = 32;
+		const unsigned int BubblePoolMaxSize = 8192;
 		const unsigned int NumBubbleForSpawnPerPlayer = 5;
 		const float FloorHeight = 32.0f;
+		/// The floor, then the left and the right limits, shared by the game scene and the headless arenas
+		const unsigned int NumObstacles = 3;
+		const ObstacleData Obstacles[NumObstacles] = {
+			{ nc::Vector2f(0.5f, 0.0f), nc::Vector2f(4096.0f, FloorHeight) },
+			{ nc::Vector2f(0.0f, 0.0f), nc::Vector2f(FloorHeight, 4096.0f) },
+			{ nc::Vector2f(1.0f, 1.0f), nc::Vector2f(FloorHeight, 4096.0f) }
+		};
+	}
+
+	namespace Spawn
+	{
+		/// Spawn area above the screen, relative to the screen size
+		const nc::Vector2f AreaRelativeMin(0.1f, 1.2f);
+		const nc::Vector2f AreaRelativeMax(0.9f, 2.0f);
+		/// Candidate positions tried by rejection sampling before postponing a spawn
+		const unsigned int MaxSampleAttempts = 16;
+		/// The minimum distance between spawned bubbles, relative to their diameter
+		const float MinDistanceFactor = 1.05f;
+		/// Points stored in a sampling grid cell, any further one is ignored
+		const unsigned int MaxPointsPerCell = 4;
+	}
+
+	namespace FrameStats
+	{
+		/// The number of frames in the rolling window
+		const unsigned int NumSamples = 512;
+		/// The width of a frame-time histogram bucket, in milliseconds
+		const float BucketWidth = 0.5f;
+		/// The number of histogram buckets, the last one collects all longer frames
+		const unsigned int NumBuckets = 100;
+		/// A frame is a hitch when it takes longer than this factor times the median
+		const float HitchFactor = 2.0f;
+		/// The minimum number of samples before starting to detect hitches
+		const unsigned int MinSamplesForHitches = 60;
+		/// Smoothing factor for the per-zone moving average used to attribute hitches
+		const float ZoneAverageFactor = 0.05f;
+		/// How often the overlay text is updated, in seconds
+		const float OverlayRefreshTime = 0.25f;
+		const nc::Vector2f OverlayRelativePos(0.01f, 0.98f);
+	}
+
+	namespace GpuProfiler
+	{
+		/// Timer queries of a frame are read back this many frames later, so that the CPU never waits for them
+		const unsigned int NumBufferedFrames = 2;
+		/// The maximum number of viewports measured in a frame
+		const unsigned int MaxPasses = 32;
+		/// Smoothing factor for the per-pass moving average
+		const float AverageFactor = 0.05f;
+	}
+
+	namespace Benchmark
+	{
+		/// The command line argument that starts the game in benchmark mode
+		char const * const CommandLineArg = "--benchmark";
+		char const * const ResultsFilename = "WetPaper/Benchmark.csv";
+		const unsigned int NumStages = 3;
+		/// Number of alive bubbles for each stage, every stage runs with and without shaders
+		const unsigned int StageBubbles[NumStages] = { 100, 1000, 5000 };
+		/// Time to let the bubble count and the frame rate settle before measuring, in seconds
+		const float WarmUpTime = 3.0f;
+		const float MeasureTime = 10.0f;
+		/// Snapshots saved and restored at the end of every stage to measure their average time
+		const unsigned int NumSnapshotRoundTrips = 100;
+		/// Resimulations of `Netplay::MaxRollbackFrames` steps at the end of every stage
+		const unsigned int NumResimulations = 10;
+	}
+
+	namespace Netplay
+	{
+		/// Starts a two players match as the host, listening on the loopback port that follows, if any
+		char const * const HostArg = "--netplay-host";
+		/// Starts a two players match connecting to a host on the loopback port that follows, if any
+		char const * const JoinArg = "--netplay-join";
+		/// Frames of local input delay, followed by a number
+		char const * const InputDelayArg = "--netplay-delay";
+		/// Simulated one way latency and jitter of the loopback harness in milliseconds, followed by a number
+		char const * const LatencyArg = "--netplay-latency";
+		char const * const JitterArg = "--netplay-jitter";
+		/// Simulated packet loss of the loopback harness in percent, followed by a number
+		char const * const PacketLossArg = "--netplay-loss";
+
+		const unsigned short DefaultPort = 7525;
+		/// The simulation runs at a fixed rate so that both peers step with the same time
+		const unsigned int TickRate = 60;
+		const unsigned int DefaultInputDelay = 2;
+		const unsigned int MaxInputDelay = 8;
+		/// The farthest the local simulation can run ahead of the last confirmed remote input
+		const unsigned int MaxRollbackFrames = 8;
+		/// Steps that can be simulated in one frame to catch up, resimulations excluded
+		const unsigned int MaxStepsPerFrame = 4;
+		/// Input history ring size, a power of two larger than any distance between the peers
+		const unsigned int InputHistorySize = 128;
+		/// Local inputs repeated in every packet, so that a lost packet is covered by the next ones
+		const unsigned int MaxInputsPerPacket = 32;
+		/// Seconds without packets after which the peer is considered disconnected
+		const float TimeoutTime = 5.0f;
+		/// Seconds between two handshake packets while connecting
+		const float HandshakeInterval = 0.25f;
+		/// Frames ahead of the remote peer after which a step is skipped to let it catch up
+		const int MaxFrameAdvantage = 2;
+	}
+
+	namespace Jobs
+	{
+		/// Threads of the job system shared by the game, the main one included, zero uses every hardware thread
+		const unsigned int NumThreads = 0;
+		/// Jobs waiting in the queue of a thread, a range that does not fit is run without splitting it further
+		const unsigned int QueueCapacity = 64;
+		/// Empty polls of the queues before a worker goes to sleep
+		const unsigned int NumSpinsBeforeSleep = 64;
+		/// The smallest ranges of a parallel loop, a shorter loop runs on the calling thread only
+		const unsigned int BodiesPerJob = 256;
+		const unsigned int BubblesPerJob = 128;
+		const unsigned int GridCellsPerJob = 16;
+	}
+
+	namespace Arena
+	{
+		/// Runs the headless arena simulator instead of the game, followed by the number of arenas, if any
+		char const * const CommandLineArg = "--arenas";
+		const unsigned int DefaultNumArenas = 256;
+		/// Alive bubbles in an arena, each player keeps its bubble contacts in a 64 bits mask
+		const unsigned int MaxBubbles = 64;
+		/// The game derives the bubble collider from the sprite size, there are no textures in a headless run
+		const float BubbleRadius = 64.0f;
+		const unsigned int MatchTime = 60;
+		/// Fixed step of the simulation, in seconds
+		const float StepLength = 1.0f / 60.0f;
+		/// Nearest bubbles reported in the observation of a player
+		const unsigned int NumObservedBubbles = 4;
+		/// The smallest range of arenas stepped by a job
+		const unsigned int ArenasPerChunk = 8;
+		/// Steps of every arena simulated for each thread count of the throughput test
+		const unsigned int NumMeasureSteps = 600;
 	}
 
 	namespace Player
@@ -162,6 +366,56 @@ namespace Configuration
 		const float DashStaminaCost = MaxStamina * 0.5f;
 		const float StaminaRegenTime = 2.0f;
 		const int MaxJumpCount = 2;
+
+		/// Body values set by the `Player` constructor, also used by the headless arenas
+		const float Radius = 64.0f;
+		const float MaxVelocity = 2000.0f;
+		const float StartDamping = 0.01f;
+		const float GroundDamping = 0.2f;
+		const float AirDamping = 1.0f;
+		const float AirGravity = -1250.0f;
+		/// Factors of the horizontal velocity kept when moving or dashing in the opposite direction
+		const float TurnVelocityFactor = 0.8f;
+		const float DashTurnVelocityFactor = 0.5f;
+	}
+
+	/// How a bot plays at one of the difficulty levels
+	struct BotProfile
+	{
+		/// Steps between two choices of the target, the bot keeps chasing the old position in between
+		unsigned int reactionSteps;
+		/// Maximum horizontal error added to the target position, picked again with every choice
+		float aimError;
+		bool useDoubleJump;
+		/// Stamina needed before dashing, a value above the maximum stamina disables the dash
+		float dashStamina;
+	};
+
+	namespace Bot
+	{
+		/// Easy, normal and hard
+		const BotProfile Profiles[3] = {
+			{ 20, 160.0f, false, 2.0f },
+			{ 8, 64.0f, true, 1.0f },
+			{ 2, 16.0f, true, 0.5f }
+		};
+		const unsigned int BenchmarkDifficulty = 2;
+		const unsigned int AttractDifficulty = 1;
+
+		/// Side of a cell of the grid of alive bubbles
+		const float GridCellSize = 256.0f;
+		/// Bubbles scored when choosing a target, the first ones returned by the grid query
+		const unsigned int MaxCandidates = 32;
+		/// Half size of the area searched around the bot, the whole arena is searched when there are no bubbles in it
+		const nc::Vector2f SearchHalfSize(640.0f, 720.0f);
+		/// A pixel of height above the bot costs like this many pixels of horizontal distance
+		const float HeightCost = 1.0f;
+		/// Horizontal distance under which the bot stops moving towards the target
+		const float DeadZone = 32.0f;
+		const float JumpReach = 400.0f;
+		const float DashDistance = 600.0f;
+		/// Steps after a jump or a dash before pressing it again, the body can still touch the ground right after a jump
+		const unsigned int ActionCooldownSteps = 8;
 	}
 
 	namespace Gui
@@ -179,8 +433,16 @@ namespace Configuration
 		const float LinearVelocityDamping = 1.0f;
 		const float PlayerMaxVelocity = 10000.0f;
 		const float BubbleMaxVelocity = 200.0f;
+		const float BubbleDamping = 1.0f;
+		const nc::Vector2f BubbleGravity(0.0f, -100.0f);
+		/// Integration and collision substeps in a simulation step, for the game and the headless arenas
+		const unsigned int NumSubSteps = 16;
 		const nc::Vector2f ColliderHalfSize(64.0f, 64.0f);
 		const nc::Vector2f Gravity(0.0f, -100.0f);
+		/// The broadphase grid gets coarser when the dynamic bodies are spread over more cells than this
+		const unsigned int MaxGridCells = 16384;
+		/// The broadphase grid never covers more than this, farther bodies are sorted in the border cells
+		const float MaxGridExtent = 1.0e6f;
 	}
 }
 
@@ -0,0 +1,288 @@
+#include <ncine/config.h>
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	#include <ncine/imgui.h>
+#endif
+
+#include <cmath>
+#include <nctl/algorithms.h>
+#include "ContactSolver.h"
+#include "JobSystem.h"
+#include "Config.h"
+#include "nodes/Body.h"
+
+namespace {
+	/// Half of the neighbour cells, every pair of adjacent cells is visited from only one of them
+	const int NeighbourOffsets[4][2] = { { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 } };
+
+	inline uint64_t pairId(unsigned int indexA, unsigned int indexB)
+	{
+		return (static_cast<uint64_t>(nctl::min(indexA, indexB)) << 32) | nctl::max(indexA, indexB);
+	}
+}
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS AND DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+ContactSolver::ContactSolver(JobSystem &jobSystem)
+    : jobSystem_(jobSystem), gridOrigin_(0.0f, 0.0f), cellSize_(1.0f), gridWidth_(0), gridHeight_(0),
+      currentResolvedPairs_(0), numDetectedContacts_(0), numResolvedContacts_(0)
+{
+	threadContacts_ = nctl::makeUnique<nctl::Array<Contact>[]>(jobSystem_.numThreads());
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void ContactSolver::beginStep()
+{
+	resolvedPairs_[currentResolvedPairs_].clear();
+	numResolvedContacts_ = 0;
+}
+
+void ContactSolver::solve()
+{
+	buildGrid();
+
+	for (unsigned int i = 0; i < jobSystem_.numThreads(); i++)
+		threadContacts_[i].clear();
+
+	// Positions are only read here, each job appends to the buffer of the thread running it
+	jobSystem_.parallelFor(0, gridWidth_ * gridHeight_, Cfg::Jobs::GridCellsPerJob, [this](unsigned int first, unsigned int last) {
+		detect(first, last, threadContacts_[jobSystem_.threadIndex()]);
+	});
+
+	mergeContacts();
+	applyCorrections();
+}
+
+void ContactSolver::drawGui()
+{
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	if (ImGui::TreeNode("Contact Solver"))
+	{
+		ImGui::Text("Grid: %u x %u cells of %.1f", gridWidth_, gridHeight_, cellSize_);
+		ImGui::Text("Dynamic bodies: %u, static bodies: %u", dynamicBodies_.size(), staticBodies_.size());
+		ImGui::Text("Contacts in the last substep: %u", numDetectedContacts_);
+		ImGui::Text("Pairs resolved in the last step: %u", numResolvedContacts_);
+		ImGui::TreePop();
+	}
+#endif
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void ContactSolver::buildGrid()
+{
+	staticBodies_.clear();
+	dynamicBodies_.clear();
+
+	nc::Vector2f minPosition(0.0f, 0.0f);
+	nc::Vector2f maxPosition(0.0f, 0.0f);
+	bool hasBounds = false;
+	float maxHalfSize = 0.0f;
+	for (unsigned int i = 0; i < Body::All.size(); i++)
+	{
+		const Body *body = Body::All[i];
+		if (body->colliderKind() == ColliderKind::NONE)
+			continue;
+
+		if (body->bodyKind() == BodyKind::STATIC)
+		{
+			staticBodies_.pushBack(i);
+			continue;
+		}
+
+		maxHalfSize = nctl::max(maxHalfSize, nctl::max(body->colliderHalfSize_.x, body->colliderHalfSize_.y));
+		dynamicBodies_.pushBack(i);
+
+		// A body with a non-finite position is left out of the bounds, it is sorted in a border cell
+		const nc::Vector2f position = body->position();
+		if (std::isfinite(position.x) == false || std::isfinite(position.y) == false)
+			continue;
+		if (hasBounds == false)
+		{
+			minPosition = position;
+			maxPosition = position;
+			hasBounds = true;
+		}
+		minPosition.set(nctl::min(minPosition.x, position.x), nctl::min(minPosition.y, position.y));
+		maxPosition.set(nctl::max(maxPosition.x, position.x), nctl::max(maxPosition.y, position.y));
+	}
+
+	gridOrigin_ = minPosition;
+	cellSize_ = nctl::max(maxHalfSize * 2.0f, 1.0f);
+	// The difference of two finite positions can overflow, the clamp keeps the loop below bounded
+	const nc::Vector2f extent(nctl::min(maxPosition.x - minPosition.x, Cfg::Physics::MaxGridExtent),
+	                          nctl::min(maxPosition.y - minPosition.y, Cfg::Physics::MaxGridExtent));
+	while ((extent.x / cellSize_ + 1.0f) * (extent.y / cellSize_ + 1.0f) > static_cast<float>(Cfg::Physics::MaxGridCells))
+		cellSize_ *= 2.0f;
+	gridWidth_ = dynamicBodies_.isEmpty() ? 0 : static_cast<unsigned int>(extent.x / cellSize_) + 1;
+	gridHeight_ = dynamicBodies_.isEmpty() ? 0 : static_cast<unsigned int>(extent.y / cellSize_) + 1;
+
+	// Counting sort of the bodies, the reverse pass keeps the order of `Body::All` inside a cell
+	const unsigned int numCells = gridWidth_ * gridHeight_;
+	cellStarts_.clear();
+	for (unsigned int i = 0; i <= numCells; i++)
+		cellStarts_.pushBack(0);
+
+	bodyCells_.clear();
+	sortedBodies_.clear();
+	for (unsigned int i = 0; i < dynamicBodies_.size(); i++)
+	{
+		const nc::Vector2f relPosition = Body::All[dynamicBodies_[i]]->position() - gridOrigin_;
+		// Clamped before the conversion, a NaN coordinate goes to the first cell
+		const unsigned int cellX = static_cast<unsigned int>(nctl::min(nctl::max(relPosition.x / cellSize_, 0.0f), static_cast<float>(gridWidth_ - 1)));
+		const unsigned int cellY = static_cast<unsigned int>(nctl::min(nctl::max(relPosition.y / cellSize_, 0.0f), static_cast<float>(gridHeight_ - 1)));
+		const unsigned int cell = cellY * gridWidth_ + cellX;
+		bodyCells_.pushBack(cell);
+		cellStarts_[cell]++;
+		sortedBodies_.pushBack(0);
+	}
+
+	for (unsigned int i = 1; i < numCells; i++)
+		cellStarts_[i] += cellStarts_[i - 1];
+	cellStarts_[numCells] = dynamicBodies_.size();
+
+	for (unsigned int i = dynamicBodies_.size(); i > 0; i--)
+		sortedBodies_[--cellStarts_[bodyCells_[i - 1]]] = dynamicBodies_[i - 1];
+}
+
+void ContactSolver::detect(unsigned int firstCell, unsigned int lastCell, nctl::Array<Contact> &contacts) const
+{
+	for (unsigned int cell = firstCell; cell < lastCell; cell++)
+	{
+		const int cellX = static_cast<int>(cell % gridWidth_);
+		const int cellY = static_cast<int>(cell / gridWidth_);
+
+		for (unsigned int i = cellStarts_[cell]; i < cellStarts_[cell + 1]; i++)
+		{
+			const unsigned int indexA = sortedBodies_[i];
+
+			for (unsigned int j = i + 1; j < cellStarts_[cell + 1]; j++)
+				testPair(indexA, sortedBodies_[j], contacts);
+
+			for (unsigned int n = 0; n < 4; n++)
+			{
+				const int neighbourX = cellX + NeighbourOffsets[n][0];
+				const int neighbourY = cellY + NeighbourOffsets[n][1];
+				if (neighbourX < 0 || neighbourX >= static_cast<int>(gridWidth_) || neighbourY >= static_cast<int>(gridHeight_))
+					continue;
+
+				const unsigned int neighbourCell = static_cast<unsigned int>(neighbourY) * gridWidth_ + static_cast<unsigned int>(neighbourX);
+				for (unsigned int j = cellStarts_[neighbourCell]; j < cellStarts_[neighbourCell + 1]; j++)
+					testPair(indexA, sortedBodies_[j], contacts);
+			}
+
+			// There are only a few obstacles, they are tested against every dynamic body
+			for (unsigned int j = 0; j < staticBodies_.size(); j++)
+				testPair(indexA, staticBodies_[j], contacts);
+		}
+	}
+}
+
+void ContactSolver::testPair(unsigned int indexA, unsigned int indexB, nctl::Array<Contact> &contacts) const
+{
+	const Body *bodyA = Body::All[indexA];
+	const Body *bodyB = Body::All[indexB];
+
+	Contact contact;
+	contact.pairId = pairId(indexA, indexB);
+	bool hasContact = false;
+	if (bodyA->colliderKind() == ColliderKind::CIRCLE && bodyB->colliderKind() == ColliderKind::CIRCLE)
+	{
+		// The first body of a pair of circles is the one that comes first in `Body::All`
+		contact.indexA = nctl::min(indexA, indexB);
+		contact.indexB = nctl::max(indexA, indexB);
+		hasContact = Body::circleVsCircleContact(*Body::All[contact.indexA], *Body::All[contact.indexB], contact.normal, contact.penetrationAmount);
+	}
+	else if (bodyA->colliderKind() == ColliderKind::CIRCLE && bodyB->colliderKind() == ColliderKind::AABB)
+	{
+		contact.indexA = indexA;
+		contact.indexB = indexB;
+		hasContact = Body::circleVsAabbContact(*bodyA, *bodyB, contact.normal, contact.penetrationAmount);
+	}
+	else if (bodyA->colliderKind() == ColliderKind::AABB && bodyB->colliderKind() == ColliderKind::CIRCLE)
+	{
+		contact.indexA = indexB;
+		contact.indexB = indexA;
+		hasContact = Body::circleVsAabbContact(*bodyB, *bodyA, contact.normal, contact.penetrationAmount);
+	}
+
+	if (hasContact)
+		contacts.pushBack(contact);
+}
+
+void ContactSolver::mergeContacts()
+{
+	contacts_.clear();
+	for (unsigned int i = 0; i < jobSystem_.numThreads(); i++)
+	{
+		for (const Contact &contact : threadContacts_[i])
+			contacts_.pushBack(contact);
+	}
+	numDetectedContacts_ = contacts_.size();
+
+	// Every pair is only tested once per substep, the order does not depend on which thread found a contact
+	nctl::quicksort(contacts_.begin(), contacts_.end(), [](const Contact &a, const Contact &b) { return a.pairId < b.pairId; });
+
+	const nctl::Array<uint64_t> &resolvedPairs = resolvedPairs_[currentResolvedPairs_];
+	nctl::Array<uint64_t> &mergedPairs = resolvedPairs_[currentResolvedPairs_ ^ 1];
+	mergedPairs.clear();
+
+	unsigned int resolvedIndex = 0;
+	unsigned int numNewContacts = 0;
+	for (unsigned int i = 0; i < contacts_.size(); i++)
+	{
+		const Contact &contact = contacts_[i];
+		while (resolvedIndex < resolvedPairs.size() && resolvedPairs[resolvedIndex] < contact.pairId)
+			mergedPairs.pushBack(resolvedPairs[resolvedIndex++]);
+		if (resolvedIndex < resolvedPairs.size() && resolvedPairs[resolvedIndex] == contact.pairId)
+			continue; // already resolved in an earlier substep
+
+		mergedPairs.pushBack(contact.pairId);
+		contacts_[numNewContacts++] = contact;
+	}
+	while (resolvedIndex < resolvedPairs.size())
+		mergedPairs.pushBack(resolvedPairs[resolvedIndex++]);
+
+	currentResolvedPairs_ ^= 1;
+	while (contacts_.size() > numNewContacts)
+		contacts_.popBack();
+}
+
+void ContactSolver::applyCorrections()
+{
+	corrections_.clear();
+	for (unsigned int i = 0; i < Body::All.size(); i++)
+		corrections_.pushBack(nc::Vector2f::Zero);
+
+	// Corrections are summed in pair order, so that the floating point results are the same on every run
+	for (const Contact &contact : contacts_)
+	{
+		Body *bodyA = Body::All[contact.indexA];
+		Body *bodyB = Body::All[contact.indexB];
+		const CollisionPair pair = { bodyA, bodyB, contact.normal };
+		Body::Collisions.pushBack(pair);
+
+		const bool isDynamicA = (bodyA->bodyKind() == BodyKind::DYNAMIC);
+		const bool isDynamicB = (bodyB->bodyKind() == BodyKind::DYNAMIC);
+		const float factor = (isDynamicA && isDynamicB) ? 0.5f : 1.0f;
+		if (isDynamicA)
+			corrections_[contact.indexA] += contact.normal * (contact.penetrationAmount * factor);
+		if (isDynamicB)
+			corrections_[contact.indexB] -= contact.normal * (contact.penetrationAmount * factor);
+	}
+	numResolvedContacts_ += contacts_.size();
+
+	jobSystem_.parallelFor(0, Body::All.size(), Cfg::Jobs::BodiesPerJob, [this](unsigned int first, unsigned int last) {
+		for (unsigned int i = first; i < last; i++)
+		{
+			if (corrections_[i].x != 0.0f || corrections_[i].y != 0.0f)
+				Body::All[i]->move(corrections_[i]);
+		}
+	});
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <nctl/Array.h>
+#include <nctl/UniquePtr.h>
+#include <ncine/Vector2.h>
+
+class JobSystem;
+
+namespace nc = ncine;
+
+/// Separates the overlapping bodies of `Body::All` in two phases, so that the contacts can be detected in parallel
+/*! Dynamic bodies are sorted in a uniform grid, and each job of the job system looks for contacts in a range of cells.
+ *  Positions are only read while detecting, and each thread appends to its own buffer. The buffers are then merged
+ *  and sorted by pair, and every correction is accumulated in that order before being applied at once (Jacobi).
+ *  The pair of a contact is made of `Body::All` indices, so the results depend neither on the number of threads
+ *  nor on memory addresses, and a replay from a snapshot leads to the same positions. */
+class ContactSolver
+{
+  public:
+	explicit ContactSolver(JobSystem &jobSystem);
+
+	/// Forgets the pairs resolved in the last step, as a pair of bodies is resolved at most once per step
+	void beginStep();
+	/// Detects and resolves the contacts of one substep, the new pairs are appended to `Body::Collisions`
+	void solve();
+
+	void drawGui();
+
+  private:
+	struct Contact
+	{
+		/// The lower `Body::All` index in the high bits
+		uint64_t pairId;
+		unsigned int indexA;
+		unsigned int indexB;
+		nc::Vector2f normal;
+		float penetrationAmount;
+	};
+
+	JobSystem &jobSystem_;
+
+	/// `Body::All` indices of the static bodies and of the dynamic bodies in the grid
+	nctl::Array<unsigned int> staticBodies_;
+	nctl::Array<unsigned int> dynamicBodies_;
+	nctl::Array<unsigned int> bodyCells_;
+
+	nc::Vector2f gridOrigin_;
+	/// At least the diameter of the largest dynamic body, so that only neighbour cells have to be checked
+	float cellSize_;
+	unsigned int gridWidth_;
+	unsigned int gridHeight_;
+	/// Dynamic bodies sorted by cell, the ones of cell `i` go from `cellStarts_[i]` to `cellStarts_[i + 1]`
+	nctl::Array<unsigned int> cellStarts_;
+	nctl::Array<unsigned int> sortedBodies_;
+
+	/// One contact buffer per thread of the job system, indexed by `JobSystem::threadIndex()`
+	nctl::UniquePtr<nctl::Array<Contact>[]> threadContacts_;
+	nctl::Array<Contact> contacts_;
+	/// Sorted pair ids resolved since the start of the step, one array is read while the other one is written
+	nctl::Array<uint64_t> resolvedPairs_[2];
+	unsigned int currentResolvedPairs_;
+	/// Accumulated position corrections, indexed like `Body::All`
+	nctl::Array<nc::Vector2f> corrections_;
+
+	unsigned int numDetectedContacts_;
+	unsigned int numResolvedContacts_;
+
+	void buildGrid();
+	/// Looks for contacts in a range of cells, against the neighbour cells that come after them and against static bodies
+	void detect(unsigned int firstCell, unsigned int lastCell, nctl::Array<Contact> &contacts) const;
+	void testPair(unsigned int indexA, unsigned int indexB, nctl::Array<Contact> &contacts) const;
+	/// Gathers the contacts of every thread, sorted by pair, and leaves out the pairs already resolved in this step
+	void mergeContacts();
+	void applyCorrections();
+};
@@ -0,0 +1,276 @@
+#include <ncine/config.h>
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	#include <ncine/imgui.h>
+#endif
+
+#include "FrameProfiler.h"
+#include <nctl/String.h>
+#include <ncine/Application.h>
+
+namespace {
+
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	nctl::String auxString(128);
+	float histogramValues[Cfg::FrameStats::NumBuckets];
+#endif
+
+}
+
+FrameProfiler &frameProfiler()
+{
+	static FrameProfiler instance;
+	return instance;
+}
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS AND DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+FrameProfiler::FrameProfiler()
+{
+	reset();
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+const char *FrameProfiler::zoneName(Zone zone)
+{
+	switch (zone)
+	{
+		case Zone::FRAME_START: return "Frame start";
+		case Zone::GAME_LOGIC: return "Game logic";
+		case Zone::PHYSICS: return "Physics";
+		case Zone::ENGINE: return "Engine";
+		default: return "Unknown";
+	}
+}
+
+void FrameProfiler::onFrameStart()
+{
+	const nc::TimeStamp now = nc::TimeStamp::now();
+	// A zone left open at the end of a frame is closed here
+	while (zoneStack_.isEmpty() == false)
+		endZone(zoneStack_.back());
+	zoneStart_ = now;
+
+	// The engine frame time refers to the frame that has just ended
+	const float frameTime = nc::theApplication().frameTime() * 1000.0f;
+	if (frameTime <= 0.0f)
+		return;
+
+	float measuredTime = 0.0f;
+	for (unsigned int i = 0; i < NumZones; i++)
+		measuredTime += zoneTimes_[i];
+	const unsigned int engineIndex = static_cast<unsigned int>(Zone::ENGINE);
+	zoneTimes_[engineIndex] = (frameTime > measuredTime) ? frameTime - measuredTime : 0.0f;
+
+	// The median is evaluated before the new sample enters the window
+	const bool canDetectHitches = (numSamples_ >= Cfg::FrameStats::MinSamplesForHitches);
+	const float median = canDetectHitches ? percentile(0.5f) : 0.0f;
+	const bool isHitch = canDetectHitches && (frameTime > median * Cfg::FrameStats::HitchFactor);
+
+	if (isHitch)
+	{
+		// Blame the zone that overran its moving average the most
+		unsigned int worstZone = engineIndex;
+		float worstOverrun = 0.0f;
+		for (unsigned int i = 0; i < NumZones; i++)
+		{
+			const float overrun = zoneTimes_[i] - zoneAverages_[i];
+			if (overrun > worstOverrun)
+			{
+				worstOverrun = overrun;
+				worstZone = i;
+			}
+		}
+
+		numHitches_++;
+		zoneHitches_[worstZone]++;
+		lastHitch_.frame = nc::theApplication().numFrames();
+		lastHitch_.frameTime = frameTime;
+		lastHitch_.zone = static_cast<Zone>(worstZone);
+		lastHitch_.zoneOverrun = worstOverrun;
+	}
+	else
+	{
+		// Hitches are kept out of the averages so that they don't hide the next ones
+		for (unsigned int i = 0; i < NumZones; i++)
+			zoneAverages_[i] += (zoneTimes_[i] - zoneAverages_[i]) * Cfg::FrameStats::ZoneAverageFactor;
+	}
+
+	addSample(frameTime);
+
+	for (unsigned int i = 0; i < NumZones; i++)
+	{
+		lastZoneTimes_[i] = zoneTimes_[i];
+		zoneTimes_[i] = 0.0f;
+	}
+}
+
+void FrameProfiler::beginZone(Zone zone)
+{
+	const nc::TimeStamp now = nc::TimeStamp::now();
+	accumulateCurrentZone(now);
+
+	ASSERT(zoneStack_.size() < MaxZoneDepth);
+	if (zoneStack_.size() < MaxZoneDepth)
+		zoneStack_.pushBack(zone);
+	zoneStart_ = now;
+}
+
+void FrameProfiler::endZone(Zone zone)
+{
+	const nc::TimeStamp now = nc::TimeStamp::now();
+	ASSERT(zoneStack_.isEmpty() == false && zoneStack_.back() == zone);
+	if (zoneStack_.isEmpty())
+		return;
+
+	accumulateCurrentZone(now);
+	zoneStack_.popBack();
+	// The time spent from now on is accounted to the enclosing zone, if any
+	zoneStart_ = now;
+}
+
+void FrameProfiler::reset()
+{
+	for (unsigned int i = 0; i < Cfg::FrameStats::NumSamples; i++)
+		samples_[i] = 0.0f;
+	numSamples_ = 0;
+	nextSample_ = 0;
+
+	for (unsigned int i = 0; i < Cfg::FrameStats::NumBuckets; i++)
+		histogram_[i] = 0;
+
+	for (unsigned int i = 0; i < NumZones; i++)
+	{
+		zoneTimes_[i] = 0.0f;
+		lastZoneTimes_[i] = 0.0f;
+		zoneAverages_[i] = 0.0f;
+		zoneHitches_[i] = 0;
+	}
+
+	zoneStack_.clear();
+	zoneStart_ = nc::TimeStamp::now();
+	numHitches_ = 0;
+	lastHitch_ = {};
+}
+
+FrameProfiler::Summary FrameProfiler::summary() const
+{
+	Summary summary;
+	summary.numSamples = numSamples_;
+	if (numSamples_ == 0)
+		return summary;
+
+	float sum = 0.0f;
+	for (unsigned int i = 0; i < numSamples_; i++)
+	{
+		sum += samples_[i];
+		if (samples_[i] > summary.max)
+			summary.max = samples_[i];
+	}
+	summary.average = sum / static_cast<float>(numSamples_);
+
+	// Histogram percentiles have the resolution of a bucket and cannot exceed the exact maximum
+	summary.p50 = fminf(percentile(0.5f), summary.max);
+	summary.p95 = fminf(percentile(0.95f), summary.max);
+	summary.p99 = fminf(percentile(0.99f), summary.max);
+
+	return summary;
+}
+
+void FrameProfiler::drawGui()
+{
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	if (ImGui::TreeNode("Frame Statistics"))
+	{
+		const Summary stats = summary();
+		ImGui::Text("Average: %.2f ms, Max: %.2f ms (%u frames)", stats.average, stats.max, stats.numSamples);
+		ImGui::Text("P50: %.2f ms, P95: %.2f ms, P99: %.2f ms", stats.p50, stats.p95, stats.p99);
+
+		const unsigned int plotOffset = (numSamples_ == Cfg::FrameStats::NumSamples) ? nextSample_ : 0;
+		ImGui::PlotLines("Frame times", samples_, numSamples_, plotOffset, nullptr, 0.0f, stats.max, ImVec2(0.0f, 60.0f));
+
+		float maxBucketValue = 0.0f;
+		for (unsigned int i = 0; i < Cfg::FrameStats::NumBuckets; i++)
+		{
+			histogramValues[i] = static_cast<float>(histogram_[i]);
+			maxBucketValue = fmaxf(histogramValues[i], maxBucketValue);
+		}
+		auxString.format("%.1f ms per bucket", Cfg::FrameStats::BucketWidth);
+		ImGui::PlotHistogram("Histogram", histogramValues, Cfg::FrameStats::NumBuckets, 0, auxString.data(), 0.0f, maxBucketValue, ImVec2(0.0f, 60.0f));
+
+		ImGui::Text("Hitches: %u", numHitches_);
+		for (unsigned int i = 0; i < NumZones; i++)
+		{
+			const Zone zone = static_cast<Zone>(i);
+			ImGui::BulletText("%s: %.2f ms (avg %.2f ms), %u hitches", zoneName(zone), lastZoneTimes_[i], zoneAverages_[i], zoneHitches_[i]);
+		}
+		if (numHitches_ > 0)
+		{
+			ImGui::Text("Last hitch: frame %lu, %.2f ms, %s overran by %.2f ms", lastHitch_.frame, lastHitch_.frameTime,
+			            zoneName(lastHitch_.zone), lastHitch_.zoneOverrun);
+		}
+
+		if (ImGui::Button("Reset##FrameStatistics"))
+			reset();
+
+		ImGui::TreePop();
+	}
+#endif
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void FrameProfiler::addSample(float frameTime)
+{
+	if (numSamples_ == Cfg::FrameStats::NumSamples)
+	{
+		// The window is full, the oldest sample leaves the histogram
+		const unsigned int oldBucket = bucketIndex(samples_[nextSample_]);
+		ASSERT(histogram_[oldBucket] > 0);
+		histogram_[oldBucket]--;
+	}
+	else
+		numSamples_++;
+
+	samples_[nextSample_] = frameTime;
+	histogram_[bucketIndex(frameTime)]++;
+	nextSample_ = (nextSample_ + 1) % Cfg::FrameStats::NumSamples;
+}
+
+unsigned int FrameProfiler::bucketIndex(float frameTime) const
+{
+	const unsigned int index = static_cast<unsigned int>(frameTime / Cfg::FrameStats::BucketWidth);
+	return (index < Cfg::FrameStats::NumBuckets) ? index : Cfg::FrameStats::NumBuckets - 1;
+}
+
+float FrameProfiler::percentile(float fraction) const
+{
+	if (numSamples_ == 0)
+		return 0.0f;
+
+	const unsigned int target = static_cast<unsigned int>(ceilf(fraction * numSamples_));
+	unsigned int count = 0;
+	for (unsigned int i = 0; i < Cfg::FrameStats::NumBuckets; i++)
+	{
+		count += histogram_[i];
+		if (count >= target)
+			return (static_cast<float>(i) + 0.5f) * Cfg::FrameStats::BucketWidth;
+	}
+
+	return Cfg::FrameStats::NumBuckets * Cfg::FrameStats::BucketWidth;
+}
+
+void FrameProfiler::accumulateCurrentZone(const nc::TimeStamp &now)
+{
+	if (zoneStack_.isEmpty() == false)
+	{
+		const unsigned int zoneIndex = static_cast<unsigned int>(zoneStack_.back());
+		zoneTimes_[zoneIndex] += (now - zoneStart_).seconds() * 1000.0f;
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <nctl/StaticArray.h>
+#include <ncine/TimeStamp.h>
+#include "Config.h"
+
+namespace nc = ncine;
+
+/// Collects rolling frame-time statistics, detects hitches and attributes them to a profiler zone
+class FrameProfiler
+{
+  public:
+	enum class Zone
+	{
+		FRAME_START,
+		GAME_LOGIC,
+		PHYSICS,
+		/// Everything that is not measured by another zone (scene update, drawing, buffer swap)
+		ENGINE,
+
+		COUNT
+	};
+	static const unsigned int NumZones = static_cast<unsigned int>(Zone::COUNT);
+
+	struct Summary
+	{
+		float average = 0.0f;
+		float p50 = 0.0f;
+		float p95 = 0.0f;
+		float p99 = 0.0f;
+		float max = 0.0f;
+		unsigned int numSamples = 0;
+	};
+
+	struct Hitch
+	{
+		unsigned long int frame = 0;
+		float frameTime = 0.0f;
+		Zone zone = Zone::ENGINE;
+		float zoneOverrun = 0.0f;
+	};
+
+	FrameProfiler();
+
+	static const char *zoneName(Zone zone);
+
+	/// Closes the previous frame and records its statistics
+	void onFrameStart();
+	void beginZone(Zone zone);
+	void endZone(Zone zone);
+	void reset();
+
+	/// Computes percentiles over the rolling window (times in milliseconds)
+	Summary summary() const;
+	inline unsigned int numHitches() const { return numHitches_; }
+	inline unsigned int numZoneHitches(Zone zone) const { return zoneHitches_[static_cast<unsigned int>(zone)]; }
+	inline const Hitch &lastHitch() const { return lastHitch_; }
+	/// Returns the last frame time for a zone, in milliseconds
+	inline float lastZoneTime(Zone zone) const { return lastZoneTimes_[static_cast<unsigned int>(zone)]; }
+	inline float averageZoneTime(Zone zone) const { return zoneAverages_[static_cast<unsigned int>(zone)]; }
+
+	void drawGui();
+
+  private:
+	static const unsigned int MaxZoneDepth = 8;
+
+	/// Ring buffer of frame times in milliseconds
+	float samples_[Cfg::FrameStats::NumSamples];
+	unsigned int numSamples_;
+	unsigned int nextSample_;
+	unsigned int histogram_[Cfg::FrameStats::NumBuckets];
+
+	float zoneTimes_[NumZones];
+	float lastZoneTimes_[NumZones];
+	float zoneAverages_[NumZones];
+	unsigned int zoneHitches_[NumZones];
+
+	nctl::StaticArray<Zone, MaxZoneDepth> zoneStack_;
+	nc::TimeStamp zoneStart_;
+
+	unsigned int numHitches_;
+	Hitch lastHitch_;
+
+	void addSample(float frameTime);
+	unsigned int bucketIndex(float frameTime) const;
+	float percentile(float fraction) const;
+	void accumulateCurrentZone(const nc::TimeStamp &now);
+};
+
+// Meyers' Singleton
+extern FrameProfiler &frameProfiler();
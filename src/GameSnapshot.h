@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <ncine/Vector2.h>
+#include <ncine/Random.h>
+#include "Config.h"
+#include "Statistics.h"
+
+namespace nc = ncine;
+
+/// The state of the spawn scheduler that changes during a match, waves and spawn area excluded
+struct SpawnSnapshot
+{
+	unsigned int waveIndex = 0;
+	float waveTime = 0.0f;
+	float rateAccumulator = 0.0f;
+	float burstTime = 0.0f;
+	unsigned int pendingSpawns = 0;
+	/// Spawn positions and variants only depend on this generator
+	nc::Random random;
+};
+
+struct PlayerSnapshot
+{
+	nc::Vector2f position;
+	nc::Vector2f linearVelocity;
+	/// Damping and gravity depend on the player being grounded in the previous tick
+	float linearVelocityDamping = 0.0f;
+	nc::Vector2f gravity;
+	float stamina = 0.0f;
+	int points = 0;
+	float dashEnergy = 0.0f;
+	nc::Vector2f dashDir;
+	int jumpCount = 0;
+	bool flippedX = false;
+	PlayerStatistics statistics;
+};
+
+struct BubbleSnapshot
+{
+	nc::Vector2f position;
+	nc::Vector2f linearVelocity;
+	unsigned int variant = 0;
+};
+
+/// The whole simulation state of a match, a plain structure that can be copied and sent as it is
+/*! Bubbles are stored in the order of their bodies in `Body::All`, the positions of the other bodies in the same array
+ *  are stored as well, so that the collisions are resolved in the same order after a restore.
+ *  Pause, end of match and presentation state other than the player facing are not part of the snapshot. */
+struct GameSnapshot
+{
+	static const unsigned int InvalidIndex = ~0u;
+	/// The two players followed by the three obstacles
+	static const unsigned int NumFixedBodies = 5;
+
+	/// Seconds elapsed since the start of the match, pauses excluded
+	float matchTime = 0.0f;
+	unsigned int numPlayers = 0;
+	/// Number of bodies in `Body::All`, fixed ones included
+	unsigned int numBodies = 0;
+	/// Position of every fixed body in `Body::All`, `InvalidIndex` if it is not there
+	unsigned int fixedBodyIndices[NumFixedBodies] = {};
+	Statistics statistics;
+	SpawnSnapshot spawn;
+	PlayerSnapshot players[2];
+
+	unsigned int numBubbles = 0;
+	/// The last member, so that only the used part has to be copied or sent
+	BubbleSnapshot bubbles[Cfg::Game::BubblePoolMaxSize];
+
+	/// Returns the number of bytes from the start of the snapshot to the last used bubble
+	inline unsigned int usedBytes() const { return static_cast<unsigned int>(offsetof(GameSnapshot, bubbles) + numBubbles * sizeof(BubbleSnapshot)); }
+};
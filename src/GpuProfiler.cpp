@@ -0,0 +1,166 @@
+#include <ncine/config.h>
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	#include <ncine/imgui.h>
+#endif
+
+#include "GpuProfiler.h"
+#include <cstring>
+
+#if WITH_GL_TIMER_QUERIES
+	#include <GL/glew.h>
+#endif
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS AND DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+GpuProfiler::GpuProfiler()
+    : available_(false), currentFrame_(0), passOpen_(false), lastTotalTime_(0.0f), numDroppedFrames_(0)
+{
+#if WITH_GL_TIMER_QUERIES
+	// The entry points are loaded by the engine, they are missing if the context does not support timer queries
+	available_ = (glGenQueries != nullptr && glBeginQuery != nullptr && glGetQueryObjectui64v != nullptr);
+	if (available_ == false)
+		return;
+
+	static_assert(sizeof(GLuint) == sizeof(unsigned int), "Query names are stored as unsigned integers");
+	for (FrameQueries &frame : frames_)
+		glGenQueries(MaxPasses, frame.queries);
+#endif
+}
+
+GpuProfiler::~GpuProfiler()
+{
+#if WITH_GL_TIMER_QUERIES
+	if (available_ == false)
+		return;
+
+	endPass();
+	for (FrameQueries &frame : frames_)
+		glDeleteQueries(MaxPasses, frame.queries);
+#endif
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void GpuProfiler::onFrameStart()
+{
+	if (available_ == false)
+		return;
+
+	// The screen pass is only closed here, it also measures the debug interface
+	endPass();
+
+	// The queries of the oldest frame are reused by the new one
+	currentFrame_ = (currentFrame_ + 1) % Cfg::GpuProfiler::NumBufferedFrames;
+	FrameQueries &frame = frames_[currentFrame_];
+	if (frame.numPasses > 0)
+		readBack(frame);
+	frame.numPasses = 0;
+}
+
+void GpuProfiler::beginPass(const char *name)
+{
+	if (available_ == false)
+		return;
+
+	endPass();
+	FrameQueries &frame = frames_[currentFrame_];
+	if (frame.numPasses >= MaxPasses)
+		return;
+
+#if WITH_GL_TIMER_QUERIES
+	glBeginQuery(GL_TIME_ELAPSED, frame.queries[frame.numPasses]);
+#endif
+	frame.names[frame.numPasses] = name;
+	frame.numPasses++;
+	passOpen_ = true;
+}
+
+float GpuProfiler::lastPassTime(const char *name) const
+{
+	float time = 0.0f;
+	for (const PassTime &passTime : passTimes_)
+	{
+		if (strcmp(passTime.name, name) == 0)
+			time += passTime.time;
+	}
+	return time;
+}
+
+void GpuProfiler::drawGui()
+{
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	if (ImGui::TreeNode("GPU Passes"))
+	{
+		if (available_ == false)
+			ImGui::TextUnformatted("Timer queries are not available");
+		else
+		{
+			ImGui::Text("Total: %.3f ms (%u dropped frames)", lastTotalTime_, numDroppedFrames_);
+			for (const PassTime &passTime : passTimes_)
+				ImGui::BulletText("%s: %.3f ms (avg %.3f ms)", passTime.name, passTime.time, passTime.average);
+		}
+		ImGui::TreePop();
+	}
+#endif
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void GpuProfiler::endPass()
+{
+	if (passOpen_ == false)
+		return;
+
+#if WITH_GL_TIMER_QUERIES
+	glEndQuery(GL_TIME_ELAPSED);
+#endif
+	passOpen_ = false;
+}
+
+void GpuProfiler::readBack(const FrameQueries &frame)
+{
+#if WITH_GL_TIMER_QUERIES
+	// Queries complete in order, if the last one is not available the whole frame is dropped instead of stalling
+	GLint lastAvailable = GL_FALSE;
+	glGetQueryObjectiv(frame.queries[frame.numPasses - 1], GL_QUERY_RESULT_AVAILABLE, &lastAvailable);
+	if (lastAvailable == GL_FALSE)
+	{
+		numDroppedFrames_++;
+		return;
+	}
+
+	// A different sequence of passes restarts the averages
+	bool samePasses = (passTimes_.size() == frame.numPasses);
+	for (unsigned int i = 0; samePasses && i < frame.numPasses; i++)
+		samePasses = (strcmp(passTimes_[i].name, frame.names[i]) == 0);
+	if (samePasses == false)
+	{
+		passTimes_.clear();
+		for (unsigned int i = 0; i < frame.numPasses; i++)
+		{
+			PassTime passTime;
+			passTime.name = frame.names[i];
+			passTimes_.pushBack(passTime);
+		}
+	}
+
+	lastTotalTime_ = 0.0f;
+	for (unsigned int i = 0; i < frame.numPasses; i++)
+	{
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &elapsed);
+		const float time = static_cast<float>(elapsed) / 1000000.0f;
+
+		PassTime &passTime = passTimes_[i];
+		passTime.time = time;
+		passTime.average = samePasses ? passTime.average + (time - passTime.average) * Cfg::GpuProfiler::AverageFactor : time;
+		lastTotalTime_ += time;
+	}
+#endif
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <nctl/StaticArray.h>
+#include "Config.h"
+
+/// Measures the GPU time of every viewport drawn in a frame with timer queries
+/*! Results are read back some frames later and only if they are already available, the CPU never waits for the GPU.
+ *  Timer queries need desktop OpenGL, the profiler is not available when the game is built for OpenGL ES. */
+class GpuProfiler
+{
+  public:
+	struct PassTime
+	{
+		/// The name of the pass, as passed to `beginPass()`
+		const char *name = nullptr;
+		/// Last read back time, in milliseconds
+		float time = 0.0f;
+		float average = 0.0f;
+	};
+
+	GpuProfiler();
+	~GpuProfiler();
+
+	inline bool isAvailable() const { return available_; }
+
+	/// Closes the last pass of the previous frame and reads back the oldest one
+	void onFrameStart();
+	/// Closes the previous pass and starts measuring a new one, the name must outlive the profiler
+	void beginPass(const char *name);
+
+	inline unsigned int numPasses() const { return passTimes_.size(); }
+	inline const PassTime &passTime(unsigned int index) const { return passTimes_[index]; }
+	/// Returns the sum of the last times of all the passes with the specified name, in milliseconds
+	float lastPassTime(const char *name) const;
+	inline float lastTotalTime() const { return lastTotalTime_; }
+	/// Frames whose results were not available when their queries had to be reused
+	inline unsigned int numDroppedFrames() const { return numDroppedFrames_; }
+
+	void drawGui();
+
+  private:
+	static const unsigned int MaxPasses = Cfg::GpuProfiler::MaxPasses;
+
+	struct FrameQueries
+	{
+		/// OpenGL query object names
+		unsigned int queries[MaxPasses];
+		const char *names[MaxPasses];
+		unsigned int numPasses = 0;
+	};
+
+	bool available_;
+	FrameQueries frames_[Cfg::GpuProfiler::NumBufferedFrames];
+	unsigned int currentFrame_;
+	bool passOpen_;
+
+	nctl::StaticArray<PassTime, MaxPasses> passTimes_;
+	float lastTotalTime_;
+	unsigned int numDroppedFrames_;
+
+	void endPass();
+	void readBack(const FrameQueries &frame);
+};
@@ -0,0 +1,223 @@
+#include <ncine/config.h>
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	#include <ncine/imgui.h>
+#endif
+
+#include "JobSystem.h"
+#include <nctl/algorithms.h>
+
+namespace {
+#ifndef __EMSCRIPTEN__
+	/// Set by the workers, so that a job can queue the halves of a range on the queue of its own thread
+	thread_local const JobSystem *currentJobSystem = nullptr;
+	thread_local unsigned int currentThreadIndex = 0;
+#endif
+}
+
+JobSystem &jobSystem()
+{
+	static JobSystem instance(Cfg::Jobs::NumThreads);
+	return instance;
+}
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS AND DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+JobSystem::JobSystem(unsigned int numThreads)
+    : numThreads_(numThreads)
+{
+#ifndef __EMSCRIPTEN__
+	numQueuedJobs_.store(0, std::memory_order_relaxed);
+	numSleepingWorkers_.store(0, std::memory_order_relaxed);
+	quit_.store(false, std::memory_order_relaxed);
+	numJobs_.store(0, std::memory_order_relaxed);
+	numStolenJobs_.store(0, std::memory_order_relaxed);
+
+	if (numThreads_ == 0)
+		numThreads_ = nctl::max(std::thread::hardware_concurrency(), 1u);
+
+	queues_ = nctl::makeUnique<Queue[]>(numThreads_);
+	if (numThreads_ > 1)
+	{
+		workers_ = nctl::makeUnique<std::thread[]>(numThreads_ - 1);
+		for (unsigned int i = 1; i < numThreads_; i++)
+			workers_[i - 1] = std::thread(&JobSystem::workerLoop, this, i);
+	}
+#else
+	// There are no threads without the pthreads support of Emscripten
+	numThreads_ = 1;
+#endif
+}
+
+JobSystem::~JobSystem()
+{
+#ifndef __EMSCRIPTEN__
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex_);
+		quit_.store(true);
+	}
+	sleepCondition_.notify_all();
+
+	for (unsigned int i = 0; i + 1 < numThreads_; i++)
+		workers_[i].join();
+#endif
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+unsigned int JobSystem::threadIndex() const
+{
+#ifndef __EMSCRIPTEN__
+	return (currentJobSystem == this) ? currentThreadIndex : 0;
+#else
+	return 0;
+#endif
+}
+
+void JobSystem::drawGui()
+{
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	if (ImGui::TreeNode("Job System"))
+	{
+		ImGui::Text("Threads: %u", numThreads_);
+	#ifndef __EMSCRIPTEN__
+		const unsigned long int numJobs = numJobs_.load(std::memory_order_relaxed);
+		const unsigned long int numStolenJobs = numStolenJobs_.load(std::memory_order_relaxed);
+		ImGui::Text("Jobs: %lu, stolen: %lu (%.1f%%)", numJobs, numStolenJobs,
+		            (numJobs > 0) ? (numStolenJobs * 100.0f) / static_cast<float>(numJobs) : 0.0f);
+	#endif
+		ImGui::TreePop();
+	}
+#endif
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+#ifndef __EMSCRIPTEN__
+void JobSystem::run(const Job &job)
+{
+	const unsigned int index = threadIndex();
+	unsigned int begin = job.begin;
+	unsigned int end = job.end;
+
+	// The first half is kept and the second one is queued, until the range is small enough
+	while (end - begin > job.grainSize)
+	{
+		const unsigned int middle = begin + (end - begin) / 2;
+		Job secondHalf = job;
+		secondHalf.begin = middle;
+		secondHalf.end = end;
+		if (push(index, secondHalf) == false)
+			break;
+		end = middle;
+	}
+
+	job.func(job.context, begin, end);
+	numJobs_.fetch_add(1, std::memory_order_relaxed);
+	// Releases the writes of the loop body to the thread waiting for the batch
+	job.batch->numPending.fetch_sub(end - begin, std::memory_order_acq_rel);
+}
+
+bool JobSystem::push(unsigned int threadIndex, const Job &job)
+{
+	Queue &queue = queues_[threadIndex];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.bottom - queue.top == Cfg::Jobs::QueueCapacity)
+			return false;
+		// Counted before it is published, or a thief could take it and decrement the counter first
+		numQueuedJobs_.fetch_add(1);
+		queue.jobs[queue.bottom % Cfg::Jobs::QueueCapacity] = job;
+		queue.bottom++;
+	}
+
+	if (numSleepingWorkers_.load() > 0)
+	{
+		// Taking the lock makes sure that a worker about to sleep has either seen the job or is already waiting
+		std::lock_guard<std::mutex> lock(sleepMutex_);
+		sleepCondition_.notify_one();
+	}
+	return true;
+}
+
+bool JobSystem::pop(unsigned int threadIndex, Job &job)
+{
+	Queue &queue = queues_[threadIndex];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.bottom == queue.top)
+		return false;
+
+	queue.bottom--;
+	job = queue.jobs[queue.bottom % Cfg::Jobs::QueueCapacity];
+	numQueuedJobs_.fetch_sub(1);
+	return true;
+}
+
+bool JobSystem::steal(unsigned int threadIndex, Job &job)
+{
+	// The oldest job of a queue is the largest range, stealing it moves the most work at once
+	for (unsigned int i = 1; i < numThreads_; i++)
+	{
+		Queue &queue = queues_[(threadIndex + i) % numThreads_];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.bottom == queue.top)
+			continue;
+
+		job = queue.jobs[queue.top % Cfg::Jobs::QueueCapacity];
+		queue.top++;
+		numQueuedJobs_.fetch_sub(1);
+		numStolenJobs_.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+	return false;
+}
+
+void JobSystem::waitForBatch(const Batch &batch)
+{
+	const unsigned int index = threadIndex();
+	while (batch.numPending.load(std::memory_order_acquire) > 0)
+	{
+		Job job;
+		if (pop(index, job) || steal(index, job))
+			run(job);
+		else
+			std::this_thread::yield();
+	}
+}
+
+void JobSystem::workerLoop(unsigned int threadIndex)
+{
+	currentJobSystem = this;
+	currentThreadIndex = threadIndex;
+
+	unsigned int numSpins = 0;
+	while (quit_.load(std::memory_order_relaxed) == false)
+	{
+		Job job;
+		if (pop(threadIndex, job) || steal(threadIndex, job))
+		{
+			run(job);
+			numSpins = 0;
+			continue;
+		}
+
+		if (numSpins < Cfg::Jobs::NumSpinsBeforeSleep)
+		{
+			numSpins++;
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex_);
+		numSleepingWorkers_.fetch_add(1);
+		sleepCondition_.wait(lock, [this] { return quit_.load() || numQueuedJobs_.load() > 0; });
+		numSleepingWorkers_.fetch_sub(1);
+		numSpins = 0;
+	}
+}
+#endif
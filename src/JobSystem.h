@@ -0,0 +1,129 @@
+#pragma once
+
+#include <nctl/UniquePtr.h>
+#include "Config.h"
+
+#ifndef __EMSCRIPTEN__
+	#include <atomic>
+	#include <condition_variable>
+	#include <mutex>
+	#include <thread>
+#endif
+
+/// Runs loops over index ranges on a pool of worker threads, the calling thread included
+/*! Every thread has its own queue of jobs. A range is split in halves until it reaches the grain size, the thread
+ *  keeps working on one half and queues the other one, where an idle thread can steal it.
+ *  The loop body must only write to the elements of its range, results do not depend on the number of threads. */
+class JobSystem
+{
+  public:
+	/// Zero threads uses every hardware thread, one thread runs every loop on the calling thread
+	explicit JobSystem(unsigned int numThreads);
+	~JobSystem();
+
+	inline unsigned int numThreads() const { return numThreads_; }
+	/// The index of the current thread, from zero to `numThreads() - 1`, to select a per thread buffer inside a job
+	/*! The thread that created the job system, or any other thread that is not one of its workers, has index zero */
+	unsigned int threadIndex() const;
+
+	/// Calls `func(first, last)` on ranges covering `[begin, end)`, and returns once all of them have been run
+	/*! It has to be called from the thread that created the job system, or from inside a job */
+	template <class Func>
+	void parallelFor(unsigned int begin, unsigned int end, unsigned int grainSize, const Func &func);
+
+	void drawGui();
+
+  private:
+	using RangeFunc = void (*)(const void *context, unsigned int first, unsigned int last);
+
+	/// Counts the elements of a loop that have not been run yet
+	struct Batch
+	{
+#ifndef __EMSCRIPTEN__
+		std::atomic<unsigned int> numPending;
+#endif
+	};
+
+	struct Job
+	{
+		RangeFunc func = nullptr;
+		const void *context = nullptr;
+		unsigned int begin = 0;
+		unsigned int end = 0;
+		unsigned int grainSize = 1;
+		Batch *batch = nullptr;
+	};
+
+	unsigned int numThreads_;
+
+#ifndef __EMSCRIPTEN__
+	/// A ring buffer, the owner pushes and pops at the bottom while the other threads steal from the top
+	struct Queue
+	{
+		std::mutex mutex;
+		Job jobs[Cfg::Jobs::QueueCapacity];
+		unsigned int top = 0;
+		unsigned int bottom = 0;
+	};
+
+	/// The calling thread uses the first queue, it has no worker
+	nctl::UniquePtr<Queue[]> queues_;
+	nctl::UniquePtr<std::thread[]> workers_;
+
+	std::mutex sleepMutex_;
+	std::condition_variable sleepCondition_;
+	std::atomic<unsigned int> numQueuedJobs_;
+	std::atomic<unsigned int> numSleepingWorkers_;
+	std::atomic<bool> quit_;
+
+	std::atomic<unsigned long int> numJobs_;
+	std::atomic<unsigned long int> numStolenJobs_;
+
+	void run(const Job &job);
+	/// Returns false if the queue is full
+	bool push(unsigned int threadIndex, const Job &job);
+	bool pop(unsigned int threadIndex, Job &job);
+	bool steal(unsigned int threadIndex, Job &job);
+	/// Runs the queued jobs until the batch is done, taking them from any queue
+	void waitForBatch(const Batch &batch);
+	void workerLoop(unsigned int threadIndex);
+#endif
+
+	template <class Func>
+	static void invoke(const void *context, unsigned int first, unsigned int last)
+	{
+		(*static_cast<const Func *>(context))(first, last);
+	}
+};
+
+template <class Func>
+void JobSystem::parallelFor(unsigned int begin, unsigned int end, unsigned int grainSize, const Func &func)
+{
+	if (begin >= end)
+		return;
+
+#ifndef __EMSCRIPTEN__
+	if (numThreads_ > 1 && end - begin > grainSize)
+	{
+		Batch batch;
+		batch.numPending.store(end - begin, std::memory_order_relaxed);
+
+		Job job;
+		job.func = &invoke<Func>;
+		job.context = &func;
+		job.begin = begin;
+		job.end = end;
+		job.grainSize = (grainSize > 0) ? grainSize : 1;
+		job.batch = &batch;
+
+		run(job);
+		waitForBatch(batch);
+		return;
+	}
+#endif
+
+	func(begin, end);
+}
+
+/// The job system shared by the game, its threads are created on first use
+extern JobSystem &jobSystem();
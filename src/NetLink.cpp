@@ -0,0 +1,228 @@
+#include "NetLink.h"
+
+#include <cstring>
+#include <nctl/algorithms.h>
+#include <ncine/Random.h>
+
+#if defined(_WIN32)
+	#include <winsock2.h>
+	#include <ws2tcpip.h>
+#elif !defined(__EMSCRIPTEN__)
+	#include <sys/socket.h>
+	#include <netinet/in.h>
+	#include <arpa/inet.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace {
+
+#if !defined(__EMSCRIPTEN__)
+	template <class SocketT>
+	void closeSocket(SocketT socket)
+	{
+	#if defined(_WIN32)
+		closesocket(socket);
+	#else
+		::close(socket);
+	#endif
+	}
+#endif
+
+}
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS AND DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+NetLink::NetLink()
+    : socket_(InvalidSocket), hasPeer_(false), peerAddress_(0), peerPort_(0),
+      latency_(0.0f), jitter_(0.0f), packetLoss_(0.0f), queue_(64),
+      numSentPackets_(0), numDroppedPackets_(0), numReceivedPackets_(0)
+{
+}
+
+NetLink::~NetLink()
+{
+	close();
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+bool NetLink::open(bool isHost, unsigned short port)
+{
+#if defined(__EMSCRIPTEN__)
+	LOGW("UDP sockets are not available on this platform");
+	return false;
+#else
+	close();
+
+	#if defined(_WIN32)
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+	{
+		LOGW("Cannot initialize Winsock");
+		return false;
+	}
+	#endif
+
+	const SocketT newSocket = static_cast<SocketT>(::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP));
+	if (newSocket == InvalidSocket)
+	{
+		LOGW("Cannot create the UDP socket");
+		return false;
+	}
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = htons(isHost ? port : 0);
+	if (::bind(newSocket, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0)
+	{
+		LOGW_X("Cannot bind the UDP socket to the loopback port %u", isHost ? port : 0);
+		closeSocket(newSocket);
+		return false;
+	}
+
+	#if defined(_WIN32)
+	u_long nonBlocking = 1;
+	const bool nonBlockingSet = (ioctlsocket(newSocket, FIONBIO, &nonBlocking) == 0);
+	#else
+	const bool nonBlockingSet = (fcntl(newSocket, F_SETFL, fcntl(newSocket, F_GETFL, 0) | O_NONBLOCK) == 0);
+	#endif
+	if (nonBlockingSet == false)
+	{
+		LOGW("Cannot make the UDP socket non-blocking");
+		closeSocket(newSocket);
+		return false;
+	}
+
+	socket_ = newSocket;
+	startTime_ = nc::TimeStamp::now();
+	hasPeer_ = (isHost == false);
+	peerAddress_ = htonl(INADDR_LOOPBACK);
+	peerPort_ = htons(port);
+	LOGI_X("Network link opened as %s on loopback port %u", isHost ? "host" : "client", port);
+	return true;
+#endif
+}
+
+void NetLink::close()
+{
+#if !defined(__EMSCRIPTEN__)
+	if (socket_ == InvalidSocket)
+		return;
+
+	closeSocket(socket_);
+	#if defined(_WIN32)
+	WSACleanup();
+	#endif
+#endif
+	socket_ = InvalidSocket;
+	hasPeer_ = false;
+	queue_.clear();
+}
+
+void NetLink::setConditions(float latency, float jitter, float packetLoss)
+{
+	latency_ = nctl::max(latency, 0.0f);
+	jitter_ = nctl::clamp(jitter, 0.0f, latency_);
+	packetLoss_ = nctl::clamp(packetLoss, 0.0f, 1.0f);
+}
+
+void NetLink::send(const uint8_t *data, unsigned int size)
+{
+	ASSERT(size <= MaxPacketSize);
+	if (isOpen() == false || hasPeer_ == false)
+		return;
+
+	if (packetLoss_ > 0.0f && nc::random().fastReal(0.0f, 1.0f) < packetLoss_)
+	{
+		numDroppedPackets_++;
+		return;
+	}
+
+	if (latency_ <= 0.0f)
+	{
+		sendNow(data, size);
+		return;
+	}
+
+	const float delay = latency_ + nc::random().fastReal(-jitter_, jitter_);
+	QueuedPacket &packet = queue_.emplaceBack();
+	packet.sendTime = startTime_.secondsSince() + delay;
+	packet.size = size;
+	memcpy(packet.data, data, size);
+}
+
+void NetLink::flush()
+{
+	// Every packet leaves when its own delay has elapsed, a jittered packet can overtake an earlier one
+	const float now = startTime_.secondsSince();
+	unsigned int i = 0;
+	while (i < queue_.size())
+	{
+		if (queue_[i].sendTime <= now)
+		{
+			sendNow(queue_[i].data, queue_[i].size);
+			queue_.removeAt(i);
+		}
+		else
+			i++;
+	}
+}
+
+unsigned int NetLink::receive(uint8_t *data, unsigned int maxSize)
+{
+#if defined(__EMSCRIPTEN__)
+	return 0;
+#else
+	if (isOpen() == false)
+		return 0;
+
+	sockaddr_in from;
+	while (true)
+	{
+		socklen_t fromLength = sizeof(from);
+		const int received = static_cast<int>(::recvfrom(socket_, reinterpret_cast<char *>(data), maxSize, 0,
+		                                                 reinterpret_cast<sockaddr *>(&from), &fromLength));
+		if (received <= 0)
+			return 0;
+
+		if (hasPeer_ == false)
+		{
+			// The host talks to the first peer that contacts it
+			hasPeer_ = true;
+			peerAddress_ = from.sin_addr.s_addr;
+			peerPort_ = from.sin_port;
+		}
+
+		// Packets from other senders are ignored
+		if (from.sin_addr.s_addr == peerAddress_ && from.sin_port == peerPort_)
+		{
+			numReceivedPackets_++;
+			return static_cast<unsigned int>(received);
+		}
+	}
+#endif
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void NetLink::sendNow(const uint8_t *data, unsigned int size)
+{
+#if !defined(__EMSCRIPTEN__)
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = peerAddress_;
+	address.sin_port = peerPort_;
+	::sendto(socket_, reinterpret_cast<const char *>(data), size, 0, reinterpret_cast<const sockaddr *>(&address), sizeof(address));
+	numSentPackets_++;
+#endif
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <nctl/Array.h>
+#include <ncine/TimeStamp.h>
+
+namespace nc = ncine;
+
+/// A non-blocking UDP link between two peers on the loopback interface
+/*! It doubles as a test harness: outgoing packets can be delayed by a latency with some jitter, or dropped,
+ *  before reaching the socket. Jitter can reorder packets, as it would happen on a real network.
+ *  Sockets are not available on Emscripten, where the link never opens. */
+class NetLink
+{
+  public:
+	static const unsigned int MaxPacketSize = 256;
+
+	NetLink();
+	~NetLink();
+
+	/// The host listens on the port, the client sends to it from an ephemeral port
+	bool open(bool isHost, unsigned short port);
+	void close();
+	inline bool isOpen() const { return socket_ != InvalidSocket; }
+	/// The client knows the host address from the start, the host learns it from the first packet received
+	inline bool hasPeer() const { return hasPeer_; }
+
+	/// One way latency and jitter in seconds, loss as a probability between zero and one
+	void setConditions(float latency, float jitter, float packetLoss);
+	inline float latency() const { return latency_; }
+	inline float jitter() const { return jitter_; }
+	inline float packetLoss() const { return packetLoss_; }
+
+	/// Queues a packet for the peer, it is sent when its simulated delay has elapsed
+	void send(const uint8_t *data, unsigned int size);
+	/// Sends the queued packets whose delay has elapsed
+	void flush();
+	/// Returns the size of the next packet from the peer, zero if there are none
+	unsigned int receive(uint8_t *data, unsigned int maxSize);
+
+	inline unsigned int numSentPackets() const { return numSentPackets_; }
+	inline unsigned int numDroppedPackets() const { return numDroppedPackets_; }
+	inline unsigned int numReceivedPackets() const { return numReceivedPackets_; }
+
+  private:
+#if defined(_WIN32) && defined(_WIN64)
+	using SocketT = uint64_t;
+#elif defined(_WIN32)
+	using SocketT = uint32_t;
+#else
+	using SocketT = int;
+#endif
+	static const SocketT InvalidSocket = static_cast<SocketT>(~0);
+
+	struct QueuedPacket
+	{
+		/// Seconds since the link has been opened
+		float sendTime = 0.0f;
+		unsigned int size = 0;
+		uint8_t data[MaxPacketSize];
+	};
+
+	SocketT socket_;
+	nc::TimeStamp startTime_;
+	bool hasPeer_;
+	/// Peer address and port in network byte order
+	uint32_t peerAddress_;
+	uint16_t peerPort_;
+
+	float latency_;
+	float jitter_;
+	float packetLoss_;
+	nctl::Array<QueuedPacket> queue_;
+
+	unsigned int numSentPackets_;
+	unsigned int numDroppedPackets_;
+	unsigned int numReceivedPackets_;
+
+	void sendNow(const uint8_t *data, unsigned int size);
+};
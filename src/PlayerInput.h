@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+/// The actions of a player for one simulation step, from the bound inputs, the autopilot or the network
+struct PlayerInput
+{
+	bool left = false;
+	bool right = false;
+	bool jump = false;
+	bool dash = false;
+
+	/// The bits of the actions triggered on press, they must reach exactly one simulation step
+	static const uint8_t PressedBits = 4 | 8;
+
+	/// Packs the actions in one byte, to be stored in the input history or sent over the network
+	inline uint8_t toBits() const
+	{
+		return static_cast<uint8_t>((left ? 1 : 0) | (right ? 2 : 0) | (jump ? 4 : 0) | (dash ? 8 : 0));
+	}
+
+	static inline PlayerInput fromBits(uint8_t bits)
+	{
+		PlayerInput input;
+		input.left = (bits & 1) != 0;
+		input.right = (bits & 2) != 0;
+		input.jump = (bits & 4) != 0;
+		input.dash = (bits & 8) != 0;
+		return input;
+	}
+};
@@ -0,0 +1,113 @@
+#include <cmath>
+#include "PlayerMovement.h"
+#include "Statistics.h"
+#include "Config.h"
+
+void movePlayer(PlayerMotion &motion, bool grounded, const PlayerInput &input, float deltaTime, PlayerStatistics *statistics)
+{
+	nc::Vector2f &velocity = motion.velocity;
+
+	if (grounded)
+	{
+		if (velocity.y < 0.0f)
+		{
+			// We're going down and touching the floor, let's reset the jump count
+			motion.jumpCount = 0;
+		}
+
+		motion.damping = Cfg::Player::GroundDamping; // drag active
+		motion.gravity = nc::Vector2f::Zero; // no gravity
+
+		if (input.left)
+		{
+			if (velocity.x > 0.0f)
+				velocity.x *= Cfg::Player::TurnVelocityFactor;
+
+			velocity += nc::Vector2f(-1.0f, 0.0f) * Cfg::Player::MaxGroundMoveSpeed;
+		}
+
+		if (input.right)
+		{
+			if (velocity.x < 0.0f)
+				velocity.x *= Cfg::Player::TurnVelocityFactor;
+
+			velocity += nc::Vector2f(1.0f, 0.0f) * Cfg::Player::MaxGroundMoveSpeed;
+		}
+
+		if (input.jump)
+		{
+			motion.jumpCount++;
+			if (statistics)
+				statistics->numJumps++;
+
+			velocity.y = 0.0f; // removing the Y component
+			velocity += nc::Vector2f(0.0f, 1.0f) * Cfg::Player::JumpVelocity;
+		}
+	}
+	else
+	{
+		motion.damping = Cfg::Player::AirDamping; // no drag
+		motion.gravity = nc::Vector2f(0.0f, Cfg::Player::AirGravity); // normal gravity
+
+		if (input.left)
+		{
+			if (velocity.x > 0.0f)
+				velocity.x *= Cfg::Player::TurnVelocityFactor;
+
+			velocity += nc::Vector2f(-1.0f, 0.0f) * Cfg::Player::MaxAirMoveSpeed;
+		}
+
+		if (input.right)
+		{
+			if (velocity.x < 0.0f)
+				velocity.x *= Cfg::Player::TurnVelocityFactor;
+
+			velocity += nc::Vector2f(1.0f, 0.0f) * Cfg::Player::MaxAirMoveSpeed;
+		}
+
+		if (input.jump && motion.jumpCount < Cfg::Player::MaxJumpCount)
+		{
+			motion.jumpCount++;
+			if (statistics)
+				statistics->numDoubleJumps++;
+
+			velocity.y = 0.0f; // removing the Y component
+			velocity += nc::Vector2f(0.0f, 1.0f) * Cfg::Player::JumpVelocity;
+		}
+	}
+
+	if (input.dash && motion.stamina >= Cfg::Player::DashStaminaCost)
+	{
+		motion.stamina -= Cfg::Player::DashStaminaCost;
+		motion.dashEnergy = Cfg::Player::DashDuration;
+		if (statistics)
+			statistics->numDashes++;
+
+		if (input.left)
+		{
+			motion.dashDir = nc::Vector2f(-1.0f, 0.0f);
+			if (velocity.x > 0)
+				velocity.x *= Cfg::Player::DashTurnVelocityFactor;
+		}
+		else if (input.right)
+		{
+			motion.dashDir = nc::Vector2f(1.0f, 0.0f);
+			if (velocity.x < 0)
+				velocity.x *= Cfg::Player::DashTurnVelocityFactor;
+		}
+		else
+		{
+			// no explicit direction, let's use current velocity
+			motion.dashDir = nc::Vector2f((velocity.x <= 0.0f) ? -1.0f : 1.0f, 0.0f);
+		}
+	}
+
+	if (motion.dashEnergy > 0.0f)
+	{
+		motion.dashEnergy -= deltaTime;
+		velocity += motion.dashDir * Cfg::Player::MaxDashVelocity;
+	}
+
+	const float regen = (Cfg::Player::MaxStamina / Cfg::Player::StaminaRegenTime) * deltaTime;
+	motion.stamina = fminf(motion.stamina + regen, Cfg::Player::MaxStamina);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <ncine/Vector2.h>
+#include "PlayerInput.h"
+
+struct PlayerStatistics;
+
+namespace nc = ncine;
+
+/// The state of a player changed by its movement, held by a `Player` node and its body or by a headless arena
+struct PlayerMotion
+{
+	nc::Vector2f velocity;
+	float damping = 0.0f;
+	nc::Vector2f gravity;
+	/// Normalised (0..1)
+	float stamina = 0.0f;
+	float dashEnergy = 0.0f;
+	nc::Vector2f dashDir;
+	int jumpCount = 0;
+};
+
+/// Applies the actions of one simulation step to a player, after the physics bodies have been integrated
+/*! The rule is shared by the game and the headless arenas, the statistics are optional */
+void movePlayer(PlayerMotion &motion, bool grounded, const PlayerInput &input, float deltaTime, PlayerStatistics *statistics);
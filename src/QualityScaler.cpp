@@ -0,0 +1,159 @@
+#include <ncine/config.h>
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	#include <ncine/imgui.h>
+#endif
+
+#include "QualityScaler.h"
+#include "Config.h"
+#include "ShaderEffects.h"
+#include "GpuProfiler.h"
+#include "main.h"
+
+#include <nctl/algorithms.h>
+#include <ncine/Application.h>
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS AND DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+QualityScaler::QualityScaler(MyEventHandler *eventHandler)
+    : eventHandler_(eventHandler), enabled_(false), level_(Level::FULL),
+      averageFrameTime_(Cfg::Quality::TargetFrameTime), overBudgetTime_(0.0f), withinBudgetTime_(0.0f),
+      stepUpTime_(Cfg::Quality::StepUpTime), raisedLevel_(false)
+{
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+const char *QualityScaler::levelName(Level level)
+{
+	switch (level)
+	{
+		case Level::FULL: return "Full";
+		case Level::FEWER_BLUR_PASSES: return "Fewer blur passes";
+		case Level::HALF_BLUR: return "Half resolution blur";
+		case Level::NO_DISPERSION: return "No dispersion";
+		case Level::NO_SHADERS: return "No shaders";
+		default: return "Unknown";
+	}
+}
+
+void QualityScaler::setEnabled(bool enabled)
+{
+	if (enabled_ == enabled)
+		return;
+
+	enabled_ = enabled;
+	stepUpTime_ = Cfg::Quality::StepUpTime;
+	setLevel(Level::FULL);
+}
+
+void QualityScaler::onFrameStart()
+{
+	if (enabled_ == false)
+		return;
+
+	const float frameTime = nc::theApplication().frameTime();
+	const float sample = nctl::min(frameTime * 1000.0f, Cfg::Quality::TargetFrameTime * Cfg::Quality::MaxSampleFactor);
+	averageFrameTime_ += (sample - averageFrameTime_) * Cfg::Quality::AverageFactor;
+
+	if (levelTimer_.secondsSince() < Cfg::Quality::CooldownTime)
+		return;
+
+	if (averageFrameTime_ > Cfg::Quality::TargetFrameTime * Cfg::Quality::StepDownFactor)
+	{
+		overBudgetTime_ += frameTime;
+		withinBudgetTime_ = 0.0f;
+	}
+	else if (averageFrameTime_ <= Cfg::Quality::TargetFrameTime * Cfg::Quality::WithinBudgetFactor && hasGpuHeadroom())
+	{
+		withinBudgetTime_ += frameTime;
+		overBudgetTime_ = 0.0f;
+	}
+	else
+	{
+		// Close to the target, the current level is fine
+		overBudgetTime_ = 0.0f;
+		withinBudgetTime_ = 0.0f;
+	}
+
+	const unsigned int levelIndex = static_cast<unsigned int>(level_);
+	if (overBudgetTime_ >= Cfg::Quality::StepDownTime && level_ != Level::NO_SHADERS)
+	{
+		// Falling back right after raising the quality means that the higher level cannot hold the target
+		if (raisedLevel_ && levelTimer_.secondsSince() < Cfg::Quality::ProbeTime)
+			stepUpTime_ = nctl::min(stepUpTime_ * 2.0f, Cfg::Quality::MaxStepUpTime);
+		raisedLevel_ = false;
+		setLevel(static_cast<Level>(levelIndex + 1));
+	}
+	else if (withinBudgetTime_ >= stepUpTime_ && level_ != Level::FULL)
+	{
+		raisedLevel_ = true;
+		setLevel(static_cast<Level>(levelIndex - 1));
+	}
+}
+
+void QualityScaler::drawGui()
+{
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	if (ImGui::TreeNode("Quality Scaler"))
+	{
+		bool enabled = enabled_;
+		if (ImGui::Checkbox("Enabled", &enabled))
+		{
+			eventHandler_->settingsMut().autoQuality = enabled;
+			setEnabled(enabled);
+		}
+
+		ImGui::Text("Level: %s", levelName(level_));
+		ImGui::Text("Average frame time: %.2f ms (target %.2f ms)", averageFrameTime_, Cfg::Quality::TargetFrameTime);
+		ImGui::Text("Over budget: %.1f s, within budget: %.1f / %.1f s", overBudgetTime_, withinBudgetTime_, stepUpTime_);
+
+		const unsigned int levelIndex = static_cast<unsigned int>(level_);
+		if (ImGui::Button("Lower") && level_ != Level::NO_SHADERS)
+			setLevel(static_cast<Level>(levelIndex + 1));
+		ImGui::SameLine();
+		if (ImGui::Button("Raise") && level_ != Level::FULL)
+			setLevel(static_cast<Level>(levelIndex - 1));
+
+		ImGui::TreePop();
+	}
+#endif
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+bool QualityScaler::hasGpuHeadroom() const
+{
+	// With vertical sync the frame time alone cannot tell how much work the GPU could still do
+	const GpuProfiler &gpuProfiler = eventHandler_->gpuProfiler();
+	if (gpuProfiler.isAvailable() == false || gpuProfiler.numPasses() == 0)
+		return true;
+
+	return gpuProfiler.lastTotalTime() < Cfg::Quality::TargetFrameTime * Cfg::Quality::GpuHeadroomFactor;
+}
+
+void QualityScaler::setLevel(Level level)
+{
+	const bool allowedShaders = allowsShaders();
+	if (level != level_)
+		LOGI_X("Quality level changed from \"%s\" to \"%s\"", levelName(level_), levelName(level));
+
+	level_ = level;
+	levelTimer_.toNow();
+	averageFrameTime_ = Cfg::Quality::TargetFrameTime;
+	overBudgetTime_ = 0.0f;
+	withinBudgetTime_ = 0.0f;
+
+	ShaderEffects &shaderEffects = eventHandler_->shaderEffects();
+	shaderEffects.setFewerBlurPasses(level_ >= Level::FEWER_BLUR_PASSES);
+	shaderEffects.setMinBlurQuality(level_ >= Level::HALF_BLUR ? ShaderEffects::BlurQuality::HALF : ShaderEffects::BlurQuality::FULL);
+	shaderEffects.setDispersionEnabled(level_ < Level::NO_DISPERSION);
+
+	if (allowsShaders() != allowedShaders)
+		eventHandler_->requestShaderEffectsChange();
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <ncine/TimeStamp.h>
+
+class MyEventHandler;
+
+namespace nc = ncine;
+
+/// Lowers the shader effects quality when the frame time is over budget and raises it back when there is headroom
+/*! The scaler only reduces the quality selected by the player, it never enables effects that have been turned off. */
+class QualityScaler
+{
+  public:
+	/// Ordered from the highest quality, every level also applies the reductions of the previous ones
+	enum class Level
+	{
+		FULL,
+		FEWER_BLUR_PASSES,
+		HALF_BLUR,
+		NO_DISPERSION,
+		NO_SHADERS,
+
+		COUNT
+	};
+	static const unsigned int NumLevels = static_cast<unsigned int>(Level::COUNT);
+
+	explicit QualityScaler(MyEventHandler *eventHandler);
+
+	static const char *levelName(Level level);
+
+	inline bool isEnabled() const { return enabled_; }
+	/// Disabling the scaler restores the full quality
+	void setEnabled(bool enabled);
+	inline Level level() const { return level_; }
+	/// Returns false when the current level disables all shader effects
+	inline bool allowsShaders() const { return level_ != Level::NO_SHADERS; }
+
+	void onFrameStart();
+	void drawGui();
+
+  private:
+	MyEventHandler *eventHandler_;
+	bool enabled_;
+	Level level_;
+
+	/// Moving average of the frame time, in milliseconds
+	float averageFrameTime_;
+	float overBudgetTime_;
+	float withinBudgetTime_;
+	/// Seconds within budget before raising the quality, it grows every time the higher level cannot hold the target
+	float stepUpTime_;
+	/// The last change raised the quality
+	bool raisedLevel_;
+	nc::TimeStamp levelTimer_;
+
+	bool hasGpuHeadroom() const;
+	void setLevel(Level level);
+};
@@ -0,0 +1,355 @@
+#include <ncine/config.h>
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	#include <ncine/imgui.h>
+#endif
+
+#include "RenderGraph.h"
+#include <ncine/Application.h>
+#include <ncine/Viewport.h>
+#include <ncine/Sprite.h>
+#include <ncine/Camera.h>
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS AND DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+RenderGraph::RenderGraph()
+    : numCulledPasses_(0), camera_(nctl::makeUnique<nc::Camera>())
+{
+}
+
+RenderGraph::~RenderGraph() = default;
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void RenderGraph::reset()
+{
+	resources_.clear();
+	passes_.clear();
+	numCulledPasses_ = 0;
+}
+
+RenderGraph::ResourceId RenderGraph::createTexture(const char *name, nc::Texture::Format format, const nc::Vector2i &size)
+{
+	Resource resource;
+	resource.name = name;
+	resource.format = format;
+	resource.size = size;
+	resources_.pushBack(resource);
+	return resources_.size() - 1;
+}
+
+RenderGraph::ResourceId RenderGraph::importTexture(const char *name, nc::Texture *texture)
+{
+	ASSERT(texture != nullptr);
+	Resource resource;
+	resource.name = name;
+	resource.format = texture->format();
+	resource.size = nc::Vector2i(texture->width(), texture->height());
+	resource.imported = true;
+	resource.texture = texture;
+	resources_.pushBack(resource);
+	return resources_.size() - 1;
+}
+
+void RenderGraph::setPersistent(ResourceId resource)
+{
+	ASSERT(resource < resources_.size());
+	resources_[resource].persistent = true;
+}
+
+RenderGraph::PassId RenderGraph::addPass(const char *name, nc::Viewport *viewport, ResourceId output, LoadOp loadOp)
+{
+	ASSERT(viewport != nullptr);
+	ASSERT(output == InvalidId || output < resources_.size());
+	Pass pass;
+	pass.name = name;
+	pass.viewport = viewport;
+	pass.output = output;
+	pass.loadOp = loadOp;
+	passes_.pushBack(nctl::move(pass));
+	return passes_.size() - 1;
+}
+
+void RenderGraph::addInput(PassId pass, ResourceId resource, nc::Sprite *sprite)
+{
+	ASSERT(pass < passes_.size());
+	ASSERT(resource < resources_.size());
+	Input input;
+	input.resource = resource;
+	input.sprite = sprite;
+	passes_[pass].inputs.pushBack(input);
+}
+
+void RenderGraph::compile()
+{
+	cullPasses();
+	computeLifetimes();
+	allocateTextures();
+	bindPasses();
+}
+
+void RenderGraph::releaseUnusedTextures()
+{
+	for (int i = static_cast<int>(pool_.size()) - 1; i >= 0; i--)
+	{
+		if (pool_[i].used == false)
+			pool_.removeAt(i);
+	}
+
+	// Removing pool entries shifts the indices of the following ones
+	for (unsigned int i = 0; i < resources_.size(); i++)
+		resources_[i].poolIndex = InvalidId;
+	for (unsigned int i = 0; i < pool_.size(); i++)
+	{
+		for (unsigned int j = 0; j < resources_.size(); j++)
+		{
+			if (resources_[j].imported == false && resources_[j].texture == pool_[i].texture.get())
+				resources_[j].poolIndex = i;
+		}
+	}
+}
+
+nc::Texture *RenderGraph::texture(ResourceId resource) const
+{
+	ASSERT(resource < resources_.size());
+	return resources_[resource].texture;
+}
+
+const char *RenderGraph::passName(const nc::Viewport *viewport) const
+{
+	for (const Pass &pass : passes_)
+	{
+		if (pass.viewport == viewport && pass.culled == false)
+			return pass.name;
+	}
+	return nullptr;
+}
+
+unsigned long int RenderGraph::pooledBytes() const
+{
+	unsigned long int bytes = 0;
+	for (const PooledTexture &pooled : pool_)
+	{
+		const nc::Texture &texture = *pooled.texture;
+		bytes += textureBytes(nc::Vector2i(texture.width(), texture.height()));
+	}
+	return bytes;
+}
+
+unsigned long int RenderGraph::unaliasedBytes() const
+{
+	unsigned long int bytes = 0;
+	for (const Resource &resource : resources_)
+	{
+		if (resource.imported == false && resource.firstPass != InvalidId)
+			bytes += textureBytes(resource.size);
+	}
+	return bytes;
+}
+
+void RenderGraph::drawGui()
+{
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	if (ImGui::TreeNode("Render Graph"))
+	{
+		ImGui::Text("Passes: %u (%u culled)", passes_.size(), numCulledPasses_);
+		for (unsigned int i = 0; i < passes_.size(); i++)
+		{
+			const Pass &pass = passes_[i];
+			const char *outputName = (pass.output != InvalidId) ? resources_[pass.output].name : "Screen";
+			if (pass.culled)
+				ImGui::BulletText("#%u %s -> %s (culled)", i, pass.name, outputName);
+			else
+				ImGui::BulletText("#%u %s -> %s", i, pass.name, outputName);
+		}
+
+		ImGui::Text("Pooled textures: %u, %.2f MiB (%.2f MiB without aliasing)", pool_.size(),
+		            pooledBytes() / (1024.0f * 1024.0f), unaliasedBytes() / (1024.0f * 1024.0f));
+		for (unsigned int i = 0; i < resources_.size(); i++)
+		{
+			const Resource &resource = resources_[i];
+			if (resource.imported)
+				ImGui::BulletText("%s: %dx%d, imported", resource.name, resource.size.x, resource.size.y);
+			else if (resource.firstPass == InvalidId)
+				ImGui::BulletText("%s: %dx%d, unused", resource.name, resource.size.x, resource.size.y);
+			else
+			{
+				ImGui::BulletText("%s: %dx%d, texture #%u, passes %u-%u%s", resource.name, resource.size.x, resource.size.y,
+				                  resource.poolIndex, resource.firstPass, resource.lastPass, resource.persistent ? ", persistent" : "");
+			}
+		}
+
+		ImGui::TreePop();
+	}
+#endif
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void RenderGraph::cullPasses()
+{
+	// Walking backwards from the screen, a pass is needed if a later needed pass reads its target
+	nctl::Array<bool> needed(resources_.size());
+	for (unsigned int i = 0; i < resources_.size(); i++)
+		needed.pushBack(false);
+
+	numCulledPasses_ = 0;
+	for (int i = static_cast<int>(passes_.size()) - 1; i >= 0; i--)
+	{
+		Pass &pass = passes_[i];
+		const bool toScreen = (pass.output == InvalidId);
+		pass.culled = (toScreen == false && needed[pass.output] == false);
+		if (pass.culled)
+		{
+			numCulledPasses_++;
+			continue;
+		}
+
+		// A pass that draws on top of its target also needs the previous content
+		if (toScreen == false && pass.loadOp != LoadOp::LOAD)
+			needed[pass.output] = false;
+		for (const Input &input : pass.inputs)
+			needed[input.resource] = true;
+	}
+}
+
+void RenderGraph::computeLifetimes()
+{
+	for (Resource &resource : resources_)
+	{
+		resource.firstPass = InvalidId;
+		resource.lastPass = InvalidId;
+	}
+
+	for (unsigned int i = 0; i < passes_.size(); i++)
+	{
+		const Pass &pass = passes_[i];
+		if (pass.culled)
+			continue;
+
+		if (pass.output != InvalidId)
+		{
+			Resource &output = resources_[pass.output];
+			if (output.firstPass == InvalidId)
+				output.firstPass = i;
+			output.lastPass = i;
+		}
+		for (const Input &input : pass.inputs)
+		{
+			Resource &resource = resources_[input.resource];
+			if (resource.firstPass == InvalidId)
+				resource.firstPass = i;
+			resource.lastPass = i;
+		}
+	}
+}
+
+void RenderGraph::allocateTextures()
+{
+	for (PooledTexture &pooled : pool_)
+	{
+		pooled.busyUntil = InvalidId;
+		pooled.used = false;
+	}
+
+	// Passes are visited in drawing order, so targets are assigned in the order they come alive
+	for (unsigned int i = 0; i < passes_.size(); i++)
+	{
+		if (passes_[i].culled)
+			continue;
+
+		for (Resource &resource : resources_)
+		{
+			if (resource.imported || resource.firstPass != i)
+				continue;
+
+			resource.poolIndex = acquirePooledTexture(resource);
+			resource.texture = pool_[resource.poolIndex].texture.get();
+		}
+	}
+
+	for (Resource &resource : resources_)
+	{
+		if (resource.imported == false && resource.firstPass == InvalidId)
+		{
+			resource.poolIndex = InvalidId;
+			resource.texture = nullptr;
+		}
+	}
+}
+
+unsigned int RenderGraph::acquirePooledTexture(const Resource &resource)
+{
+	// A persistent target is read by the screen in later frames, nothing else can write to its texture
+	const unsigned int busyUntil = resource.persistent ? InvalidId - 1 : resource.lastPass;
+
+	for (unsigned int i = 0; i < pool_.size(); i++)
+	{
+		PooledTexture &pooled = pool_[i];
+		// The texture must be free before the first pass, a pass cannot read and write the same texture
+		const bool isFree = (pooled.used == false || pooled.busyUntil < resource.firstPass);
+		if (isFree && pooled.texture->format() == resource.format &&
+		    pooled.texture->width() == resource.size.x && pooled.texture->height() == resource.size.y)
+		{
+			pooled.busyUntil = busyUntil;
+			pooled.used = true;
+			return i;
+		}
+	}
+
+	PooledTexture pooled;
+	pooled.texture = nctl::makeUnique<nc::Texture>(resource.name, resource.format, resource.size);
+	pooled.busyUntil = busyUntil;
+	pooled.used = true;
+	pool_.pushBack(nctl::move(pooled));
+	return pool_.size() - 1;
+}
+
+void RenderGraph::bindPasses()
+{
+	nctl::Array<nc::Viewport *> &chain = nc::Viewport::chain();
+	chain.clear();
+
+	const nc::Vector2i resolution = nc::theApplication().resolutionInt();
+	camera_->setOrthoProjection(0.0f, static_cast<float>(resolution.x), 0.0f, static_cast<float>(resolution.y));
+
+	// The last viewport in the chain is the first one to be drawn
+	for (int i = static_cast<int>(passes_.size()) - 1; i >= 0; i--)
+	{
+		const Pass &pass = passes_[i];
+		if (pass.culled)
+			continue;
+
+		for (const Input &input : pass.inputs)
+		{
+			if (input.sprite == nullptr)
+				continue;
+
+			nc::Texture *texture = resources_[input.resource].texture;
+			input.sprite->setTexture(texture);
+			input.sprite->setTexRect(nc::Recti(0, 0, texture->width(), texture->height()));
+			input.sprite->setSize(nc::Vector2f(static_cast<float>(resolution.x), static_cast<float>(resolution.y)));
+			input.sprite->setPosition(resolution.x * 0.5f, resolution.y * 0.5f);
+		}
+
+		// The screen viewport is drawn by the application after the chain
+		if (pass.output == InvalidId)
+			continue;
+
+		pass.viewport->setTexture(resources_[pass.output].texture);
+		pass.viewport->setCamera(camera_.get());
+		pass.viewport->setClearMode(pass.loadOp == LoadOp::CLEAR ? nc::Viewport::ClearMode::EVERY_DRAW : nc::Viewport::ClearMode::NEVER);
+		chain.pushBack(pass.viewport);
+	}
+}
+
+unsigned long int RenderGraph::textureBytes(const nc::Vector2i &size)
+{
+	// Drivers usually pad three channel formats to four bytes per texel
+	return static_cast<unsigned long int>(size.x) * static_cast<unsigned long int>(size.y) * 4;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <nctl/Array.h>
+#include <nctl/UniquePtr.h>
+#include <ncine/Vector2.h>
+#include <ncine/Texture.h>
+
+namespace ncine {
+	class Viewport;
+	class Sprite;
+	class Camera;
+}
+
+namespace nc = ncine;
+
+/// Describes the viewport passes of a frame together with the render targets they read and write
+/*! Passes are declared in drawing order. When the graph is compiled the passes that do not contribute to the screen
+ *  are culled, transient targets that are never alive at the same time share a texture and the viewport chain is filled.
+ *  Every pass draws in window coordinates, whatever the size of its target. */
+class RenderGraph
+{
+  public:
+	using ResourceId = unsigned int;
+	using PassId = unsigned int;
+	static const unsigned int InvalidId = ~0u;
+
+	/// What a pass does with the previous content of its target
+	enum class LoadOp
+	{
+		/// The target is cleared with the viewport clear color
+		CLEAR,
+		/// The pass draws on top of the previous content
+		LOAD,
+		/// The pass covers the whole target, the previous content is neither needed nor cleared
+		DONT_CARE
+	};
+
+	RenderGraph();
+	~RenderGraph();
+
+	/// Removes all passes and resources, pooled textures are kept for the next compilation
+	void reset();
+
+	/// Declares a transient render target, its texture is assigned by the compilation
+	ResourceId createTexture(const char *name, nc::Texture::Format format, const nc::Vector2i &size);
+	/// Declares a render target with a texture owned elsewhere, it is never aliased
+	ResourceId importTexture(const char *name, nc::Texture *texture);
+	/// A persistent target keeps its content between frames, it is never aliased
+	void setPersistent(ResourceId resource);
+
+	/// Adds a pass that draws a viewport to a target, the screen viewport has an invalid output
+	PassId addPass(const char *name, nc::Viewport *viewport, ResourceId output, LoadOp loadOp);
+	/// Declares that a pass reads a target, the sprite is then textured with it and covers the whole window
+	void addInput(PassId pass, ResourceId resource, nc::Sprite *sprite = nullptr);
+
+	/// Culls the passes, assigns and binds the textures, then fills the viewport chain
+	void compile();
+	/// Destroys the pooled textures that have not been assigned by the last compilation
+	void releaseUnusedTextures();
+
+	/// Returns the texture assigned to a target, `nullptr` if it is not used by any pass
+	nc::Texture *texture(ResourceId resource) const;
+	/// Returns the name of the first compiled pass drawing a viewport, `nullptr` if there is none
+	const char *passName(const nc::Viewport *viewport) const;
+	inline unsigned int numPasses() const { return passes_.size(); }
+	inline unsigned int numCulledPasses() const { return numCulledPasses_; }
+	/// Video memory of the pooled textures, in bytes
+	unsigned long int pooledBytes() const;
+	/// Video memory that the used transient targets would need without aliasing, in bytes
+	unsigned long int unaliasedBytes() const;
+
+	void drawGui();
+
+  private:
+	struct Resource
+	{
+		const char *name = nullptr;
+		nc::Texture::Format format = nc::Texture::Format::RGBA8;
+		nc::Vector2i size;
+		bool imported = false;
+		bool persistent = false;
+		nc::Texture *texture = nullptr;
+		/// Pool index of the assigned texture, if transient
+		unsigned int poolIndex = InvalidId;
+		/// First and last non-culled pass that use the target
+		unsigned int firstPass = InvalidId;
+		unsigned int lastPass = InvalidId;
+	};
+
+	struct Input
+	{
+		ResourceId resource = InvalidId;
+		nc::Sprite *sprite = nullptr;
+	};
+
+	struct Pass
+	{
+		const char *name = nullptr;
+		nc::Viewport *viewport = nullptr;
+		ResourceId output = InvalidId;
+		LoadOp loadOp = LoadOp::CLEAR;
+		nctl::Array<Input> inputs;
+		bool culled = false;
+	};
+
+	struct PooledTexture
+	{
+		nctl::UniquePtr<nc::Texture> texture;
+		/// Last pass reading or writing the texture in the compiled graph
+		unsigned int busyUntil = InvalidId;
+		bool used = false;
+	};
+
+	nctl::Array<Resource> resources_;
+	nctl::Array<Pass> passes_;
+	nctl::Array<PooledTexture> pool_;
+	unsigned int numCulledPasses_;
+	/// Projects window coordinates to the target of every pass, scaling them when the target is smaller
+	nctl::UniquePtr<nc::Camera> camera_;
+
+	void cullPasses();
+	void computeLifetimes();
+	void allocateTextures();
+	unsigned int acquirePooledTexture(const Resource &resource);
+	void bindPasses();
+
+	static unsigned long int textureBytes(const nc::Vector2i &size);
+};
@@ -0,0 +1,75 @@
+#include <ncine/config.h>
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	#include <ncine/imgui.h>
+#endif
+
+#include "RenderStats.h"
+
+#include <ncine/Application.h>
+#include <ncine/Viewport.h>
+#include <ncine/SceneNode.h>
+#include <ncine/TextNode.h>
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+RenderStats RenderStats::collect()
+{
+	RenderStats stats;
+
+	nc::Viewport &screenViewport = nc::theApplication().screenViewport();
+	if (screenViewport.rootNode() != nullptr)
+		stats.visit(*screenViewport.rootNode());
+	stats.numViewports++;
+
+	for (nc::Viewport *viewport : nc::Viewport::chain())
+	{
+		if (viewport->rootNode() != nullptr)
+			stats.visit(*viewport->rootNode());
+		stats.numViewports++;
+	}
+
+	return stats;
+}
+
+void RenderStats::visit(const nc::SceneNode &node)
+{
+	if (node.isDrawEnabled() == false)
+		return;
+
+	switch (node.type())
+	{
+		case nc::Object::ObjectType::SPRITE:
+		case nc::Object::ObjectType::MESH_SPRITE:
+		case nc::Object::ObjectType::ANIMATED_SPRITE:
+			numSprites++;
+			break;
+		case nc::Object::ObjectType::TEXTNODE:
+			numTextNodes++;
+			numGlyphs += static_cast<const nc::TextNode &>(node).string().length();
+			break;
+		case nc::Object::ObjectType::PARTICLE_SYSTEM:
+			numOtherDrawables++;
+			break;
+		default:
+			break;
+	}
+
+	for (const nc::SceneNode *child : node.children())
+		visit(*child);
+}
+
+void RenderStats::drawGui() const
+{
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	if (ImGui::TreeNode("Render Commands", "Render commands: %u", numCommands()))
+	{
+		ImGui::Text("Sprites: %u, Text nodes: %u (%u glyphs), Others: %u", numSprites, numTextNodes, numGlyphs, numOtherDrawables);
+		ImGui::Text("Viewports: %u", numViewports);
+		ImGui::Text("With a sprite per glyph: %u, With a mesh per text node: %u", numCommandsWithGlyphSprites(), numCommands());
+		ImGui::TextUnformatted("Commands sharing a material can be further batched by the renderer");
+		ImGui::TreePop();
+	}
+#endif
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+namespace ncine {
+	class SceneNode;
+}
+
+namespace nc = ncine;
+
+/// Estimates the render commands of a frame by visiting the scene graph of every viewport
+struct RenderStats
+{
+	unsigned int numSprites = 0;
+	unsigned int numTextNodes = 0;
+	/// Characters of all text nodes, each one would be a command if glyphs were drawn as sprites
+	unsigned int numGlyphs = 0;
+	unsigned int numOtherDrawables = 0;
+	/// Offscreen viewports in the chain plus the screen one
+	unsigned int numViewports = 0;
+
+	/// Every drawable is a render command before batching, every viewport adds a clear and a pass
+	inline unsigned int numCommands() const { return numSprites + numTextNodes + numOtherDrawables + numViewports; }
+
+	/// Every text node is a single mesh, only rebuilt when its string changes
+	inline unsigned int numCommandsWithGlyphSprites() const { return numCommands() - numTextNodes + numGlyphs; }
+
+	static RenderStats collect();
+	void visit(const nc::SceneNode &node);
+
+	void drawGui() const;
+};
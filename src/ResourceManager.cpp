@@ -1,7 +1,14 @@
 #include "ResourceManager.h"
+#include "Config.h"
 #include <ncine/FileSystem.h>
 #include <ncine/Texture.h>
 #include <ncine/AudioBuffer.h>
+#include <ncine/Font.h>
+
+namespace {
+	char const * const bitmapFontFntPaths[ResourceManager::NumFontSizes] = { Cfg::Fonts::Modak200Fnt, Cfg::Fonts::Modak50Fnt, Cfg::Fonts::Modak20Fnt };
+	char const * const bitmapFontPngPaths[ResourceManager::NumFontSizes] = { Cfg::Fonts::Modak200Png, Cfg::Fonts::Modak50Png, Cfg::Fonts::Modak20Png };
+}
 
 ResourceManager &resourceManager()
 {
@@ -29,6 +36,10 @@ ResourceManager::~ResourceManager()
 
 void ResourceManager::releaseAll()
 {
+	// Fonts reference textures and must be released first
+	for (unsigned int i = 0; i < NumFontSizes; i++)
+		bitmapFonts_[i].reset(nullptr);
+
 	textures_.clear();
 	audioBuffers_.clear();
 }
@@ -92,3 +103,15 @@ nc::AudioBuffer *ResourceManager::retrieveAudioBuffer(const char *path)
 
 	return retrievedAudioBuffer;
 }
+
+nc::Font *ResourceManager::retrieveFont(FontSize size)
+{
+	const unsigned int index = static_cast<unsigned int>(size);
+	if (bitmapFonts_[index] == nullptr)
+	{
+		const nctl::String fntPath = nc::fs::joinPath(nc::fs::dataPath(), bitmapFontFntPaths[index]);
+		bitmapFonts_[index] = nctl::makeUnique<nc::Font>(fntPath.data(), retrieveTexture(bitmapFontPngPaths[index]));
+	}
+
+	return bitmapFonts_[index].get();
+}
@@ -7,6 +7,7 @@
 namespace ncine {
 	class Texture;
 	class AudioBuffer;
+	class Font;
 }
 
 namespace nc = ncine;
@@ -22,9 +23,23 @@ class ResourceManager
 	nc::Texture *retrieveTexture(const char *path);
 	nc::AudioBuffer *retrieveAudioBuffer(const char *path);
 
+	enum class FontSize
+	{
+		TITLE,
+		MENU,
+		SMALL,
+
+		COUNT
+	};
+	static const unsigned int NumFontSizes = static_cast<unsigned int>(FontSize::COUNT);
+
+	/// Returns the bitmap font of the specified size, loaded the first time and shared by every node
+	nc::Font *retrieveFont(FontSize size);
+
   private:
 	nctl::HashMap<nctl::String, nctl::UniquePtr<nc::Texture>> textures_;
 	nctl::HashMap<nctl::String, nctl::UniquePtr<nc::AudioBuffer>> audioBuffers_;
+	nctl::UniquePtr<nc::Font> bitmapFonts_[NumFontSizes];
 };
 
 // Meyers' Singleton
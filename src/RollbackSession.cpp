@@ -0,0 +1,475 @@
+#include <ncine/config.h>
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	#include <ncine/imgui.h>
+#endif
+
+#include "RollbackSession.h"
+#include "GameSnapshot.h"
+#include "nodes/Game.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <nctl/algorithms.h>
+#include <ncine/AppConfiguration.h>
+#include <ncine/Random.h>
+
+namespace {
+	const uint8_t PacketMagic[2] = { 'W', 'P' };
+	const uint8_t ProtocolVersion = 1;
+	const unsigned int HeaderSize = 4;
+
+	enum PacketType : uint8_t
+	{
+		HELLO,
+		START,
+		INPUTS
+	};
+
+	const float TickLength = 1.0f / static_cast<float>(Cfg::Netplay::TickRate);
+	const int NoRollback = 0x7fffffff;
+
+	// Integers are written in little endian order, whatever the platform
+	void writeUint32(uint8_t *data, uint32_t value)
+	{
+		for (unsigned int i = 0; i < 4; i++)
+			data[i] = static_cast<uint8_t>(value >> (i * 8));
+	}
+
+	uint32_t readUint32(const uint8_t *data)
+	{
+		uint32_t value = 0;
+		for (unsigned int i = 0; i < 4; i++)
+			value |= static_cast<uint32_t>(data[i]) << (i * 8);
+		return value;
+	}
+
+	void writeHeader(uint8_t *data, PacketType type)
+	{
+		data[0] = PacketMagic[0];
+		data[1] = PacketMagic[1];
+		data[2] = ProtocolVersion;
+		data[3] = type;
+	}
+
+	bool readNumberArgument(const nc::AppConfiguration &appConfig, int index, int &value)
+	{
+		if (index >= appConfig.argc())
+			return false;
+
+		char *end = nullptr;
+		const long number = strtol(appConfig.argv(index), &end, 10);
+		if (end == appConfig.argv(index) || *end != '\0' || number < 0)
+			return false;
+
+		value = static_cast<int>(number);
+		return true;
+	}
+}
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS AND DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+RollbackSession::RollbackSession(Game &game, const NetplayConfig &config)
+    : game_(game), config_(config), state_(State::CONNECTING), seed_(0), matchDuration_(0),
+      currentFrame_(0), lastFrame_(NoRollback), timeAccumulator_(0.0f), pendingPressedInputs_(0), lastLocalFrame_(-1),
+      lastAckedFrame_(-1), lastConfirmedFrame_(-1), rollbackFrame_(NoRollback), remoteFrame_(0),
+      snapshots_(nctl::makeUnique<GameSnapshot[]>(NumSnapshots)),
+      numRollbacks_(0), numResimulatedFrames_(0), maxRollbackDepth_(0), numStalls_(0),
+      lastResimulationTime_(0.0f), maxResimulationTime_(0.0f), roundTripTime_(0.0f)
+{
+	ASSERT_MSG(testPrediction(), "The predicted remote inputs repeat a confirmed press");
+	config_.inputDelay = nctl::min(config_.inputDelay, Cfg::Netplay::MaxInputDelay);
+	lastLocalFrame_ = static_cast<int>(config_.inputDelay) - 1;
+
+	// The first frames of the local player have no input, as they are within the delay
+	memset(localInputs_, 0, sizeof(localInputs_));
+	memset(remoteInputs_, 0, sizeof(remoteInputs_));
+	memset(usedRemoteInputs_, 0, sizeof(usedRemoteInputs_));
+	memset(localInputSendTimes_, 0, sizeof(localInputSendTimes_));
+
+	if (link_.open(config_.isHost, config_.port))
+	{
+		link_.setConditions(config_.latency, config_.jitter, config_.packetLoss);
+		LOGI_X("Netplay %s on port %u, input delay of %u frames, simulated latency %.0f ms, jitter %.0f ms, loss %.0f%%",
+		       config_.isHost ? "hosting" : "joining", config_.port, config_.inputDelay,
+		       config_.latency * 1000.0f, config_.jitter * 1000.0f, config_.packetLoss * 100.0f);
+	}
+	else
+		state_ = State::DISCONNECTED;
+}
+
+RollbackSession::~RollbackSession() = default;
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+bool RollbackSession::parseArguments(const nc::AppConfiguration &appConfig, NetplayConfig &config)
+{
+	bool requested = false;
+	for (int i = 1; i < appConfig.argc(); i++)
+	{
+		const char *arg = appConfig.argv(i);
+		int value = 0;
+
+		if (strcmp(arg, Cfg::Netplay::HostArg) == 0 || strcmp(arg, Cfg::Netplay::JoinArg) == 0)
+		{
+			requested = true;
+			config.isHost = (strcmp(arg, Cfg::Netplay::HostArg) == 0);
+			if (readNumberArgument(appConfig, i + 1, value) && value > 0 && value <= 0xffff)
+			{
+				config.port = static_cast<unsigned short>(value);
+				i++;
+			}
+		}
+		else if (strcmp(arg, Cfg::Netplay::InputDelayArg) == 0 && readNumberArgument(appConfig, i + 1, value))
+		{
+			config.inputDelay = static_cast<unsigned int>(value);
+			i++;
+		}
+		else if (strcmp(arg, Cfg::Netplay::LatencyArg) == 0 && readNumberArgument(appConfig, i + 1, value))
+		{
+			config.latency = static_cast<float>(value) / 1000.0f;
+			i++;
+		}
+		else if (strcmp(arg, Cfg::Netplay::JitterArg) == 0 && readNumberArgument(appConfig, i + 1, value))
+		{
+			config.jitter = static_cast<float>(value) / 1000.0f;
+			i++;
+		}
+		else if (strcmp(arg, Cfg::Netplay::PacketLossArg) == 0 && readNumberArgument(appConfig, i + 1, value))
+		{
+			config.packetLoss = static_cast<float>(value) / 100.0f;
+			i++;
+		}
+	}
+
+	return requested;
+}
+
+bool RollbackSession::hasReachedFrame(int frame) const
+{
+	return (currentFrame_ >= frame && lastConfirmedFrame_ >= frame - 1 && rollbackFrame_ == NoRollback);
+}
+
+void RollbackSession::update(float frameTime)
+{
+	receivePackets();
+
+	if (state_ == State::CONNECTING)
+	{
+		if (config_.isHost == false && lastHandshakeTime_.secondsSince() >= Cfg::Netplay::HandshakeInterval)
+			sendHandshake();
+		link_.flush();
+		return;
+	}
+	else if (state_ == State::DISCONNECTED)
+		return;
+
+	if (lastReceiveTime_.secondsSince() > Cfg::Netplay::TimeoutTime)
+	{
+		LOGW_X("No packets from the remote peer for %.1f seconds, disconnecting", Cfg::Netplay::TimeoutTime);
+		state_ = State::DISCONNECTED;
+		link_.close();
+		return;
+	}
+
+	rollback();
+
+	// Polled once per frame, as a press is only seen in the frame it happens, even when no frame is simulated
+	const uint8_t frameInput = game_.pollInput(localPlayer()).toBits();
+	pendingPressedInputs_ |= (frameInput & PlayerInput::PressedBits);
+
+	// The accumulator does not build up while stalling, the simulation slows down instead
+	timeAccumulator_ = nctl::min(timeAccumulator_ + frameTime, TickLength * Cfg::Netplay::MaxStepsPerFrame);
+	unsigned int numSteps = 0;
+	while (timeAccumulator_ >= TickLength && numSteps < Cfg::Netplay::MaxStepsPerFrame)
+	{
+		if (currentFrame_ >= lastFrame_)
+		{
+			timeAccumulator_ = 0.0f;
+			break;
+		}
+
+		// Never predict further than a snapshot can be restored
+		if (currentFrame_ - (lastConfirmedFrame_ + 1) >= static_cast<int>(Cfg::Netplay::MaxRollbackFrames))
+		{
+			numStalls_++;
+			timeAccumulator_ = 0.0f;
+			break;
+		}
+
+		// Let the remote peer catch up when this one runs ahead, half of the round trip is the age of its last frame
+		const int remoteFrameEstimate = remoteFrame_ + static_cast<int>(roundTripTime_ * 0.5f / TickLength);
+		if (numSteps == 0 && currentFrame_ - remoteFrameEstimate > Cfg::Netplay::MaxFrameAdvantage)
+		{
+			numStalls_++;
+			timeAccumulator_ -= TickLength;
+			break;
+		}
+
+		lastLocalFrame_++;
+		localInputs_[historyIndex(lastLocalFrame_)] = static_cast<uint8_t>((frameInput & ~PlayerInput::PressedBits) | pendingPressedInputs_);
+		pendingPressedInputs_ = 0;
+		localInputSendTimes_[historyIndex(lastLocalFrame_)] = startTime_.secondsSince();
+
+		advanceFrame(false);
+		timeAccumulator_ -= TickLength;
+		numSteps++;
+	}
+
+	sendInputs();
+	link_.flush();
+}
+
+void RollbackSession::drawGui()
+{
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	if (ImGui::TreeNodeEx("Netplay", ImGuiTreeNodeFlags_DefaultOpen))
+	{
+		const char *stateNames[] = { "Connecting", "Running", "Disconnected" };
+		ImGui::Text("%s on port %u, player %u, state: %s", config_.isHost ? "Host" : "Client", config_.port,
+		            localPlayer() + 1, stateNames[static_cast<int>(state_)]);
+		ImGui::Text("Frame: %d, remote: %d, confirmed: %d, acked: %d", currentFrame_, remoteFrame_, lastConfirmedFrame_, lastAckedFrame_);
+		ImGui::Text("Input delay: %u frames, round trip: %.1f ms", config_.inputDelay, roundTripTime_ * 1000.0f);
+		ImGui::Text("Rollbacks: %u, resimulated frames: %u, deepest: %u frames", numRollbacks_, numResimulatedFrames_, maxRollbackDepth_);
+		ImGui::Text("Resimulation: last %.2f ms, max %.2f ms, stalls: %u", lastResimulationTime_, maxResimulationTime_, numStalls_);
+		ImGui::Text("Packets sent: %u, dropped: %u, received: %u", link_.numSentPackets(), link_.numDroppedPackets(), link_.numReceivedPackets());
+
+		float latency = link_.latency() * 1000.0f;
+		float jitter = link_.jitter() * 1000.0f;
+		float packetLoss = link_.packetLoss() * 100.0f;
+		bool conditionsChanged = ImGui::SliderFloat("Latency", &latency, 0.0f, 250.0f, "%.0f ms");
+		conditionsChanged |= ImGui::SliderFloat("Jitter", &jitter, 0.0f, 100.0f, "%.0f ms");
+		conditionsChanged |= ImGui::SliderFloat("Packet loss", &packetLoss, 0.0f, 50.0f, "%.0f%%");
+		if (conditionsChanged)
+			link_.setConditions(latency / 1000.0f, jitter / 1000.0f, packetLoss / 100.0f);
+
+		ImGui::TreePop();
+	}
+#endif
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void RollbackSession::receivePackets()
+{
+	uint8_t data[NetLink::MaxPacketSize];
+	unsigned int size = 0;
+	while ((size = link_.receive(data, sizeof(data))) > 0)
+	{
+		if (size < HeaderSize || data[0] != PacketMagic[0] || data[1] != PacketMagic[1] || data[2] != ProtocolVersion)
+			continue;
+		lastReceiveTime_ = nc::TimeStamp::now();
+
+		switch (data[3])
+		{
+			case PacketType::HELLO:
+				if (config_.isHost)
+				{
+					if (state_ == State::CONNECTING)
+					{
+						seed_ = (static_cast<uint64_t>(nc::random().integer()) << 32) | nc::random().integer();
+						matchDuration_ = game_.matchDuration();
+						game_.startNetplayMatch(seed_, matchDuration_);
+						startTime_ = nc::TimeStamp::now();
+						state_ = State::RUNNING;
+						LOGI("Netplay peer connected, the match starts");
+					}
+					// The handshake is answered again if the previous answer has been lost
+					sendHandshake();
+				}
+				break;
+			case PacketType::START:
+				if (config_.isHost == false && state_ == State::CONNECTING && size >= HeaderSize + 12)
+				{
+					seed_ = static_cast<uint64_t>(readUint32(data + HeaderSize)) | (static_cast<uint64_t>(readUint32(data + HeaderSize + 4)) << 32);
+					matchDuration_ = readUint32(data + HeaderSize + 8);
+					game_.startNetplayMatch(seed_, matchDuration_);
+					startTime_ = nc::TimeStamp::now();
+					state_ = State::RUNNING;
+					LOGI("Netplay connected to the host, the match starts");
+				}
+				break;
+			case PacketType::INPUTS:
+				if (state_ == State::RUNNING)
+					onInputPacket(data, size);
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+void RollbackSession::onInputPacket(const uint8_t *data, unsigned int size)
+{
+	const unsigned int InputsOffset = HeaderSize + 13;
+	if (size < InputsOffset)
+		return;
+
+	const int remoteFrame = static_cast<int>(readUint32(data + HeaderSize));
+	const int ackedFrame = static_cast<int>(readUint32(data + HeaderSize + 4));
+	const int firstFrame = static_cast<int>(readUint32(data + HeaderSize + 8));
+	const unsigned int numInputs = data[HeaderSize + 12];
+	if (size < InputsOffset + numInputs)
+		return;
+
+	remoteFrame_ = nctl::max(remoteFrame_, remoteFrame);
+
+	if (ackedFrame > lastAckedFrame_ && ackedFrame <= lastLocalFrame_)
+	{
+		// The inputs within the initial delay are not polled, they have no send time to measure from
+		if (ackedFrame >= static_cast<int>(config_.inputDelay))
+		{
+			const float roundTripSample = startTime_.secondsSince() - localInputSendTimes_[historyIndex(ackedFrame)];
+			roundTripTime_ = (roundTripTime_ <= 0.0f) ? roundTripSample : roundTripTime_ + (roundTripSample - roundTripTime_) * 0.1f;
+		}
+		lastAckedFrame_ = ackedFrame;
+	}
+
+	// Inputs start from the first one not acknowledged yet, a range past a gap belongs to a packet from the future
+	if (firstFrame > lastConfirmedFrame_ + 1)
+		return;
+
+	for (unsigned int i = 0; i < numInputs; i++)
+	{
+		const int frame = firstFrame + static_cast<int>(i);
+		if (frame <= lastConfirmedFrame_)
+			continue;
+		if (frame >= currentFrame_ + static_cast<int>(Cfg::Netplay::InputHistorySize / 2))
+			break;
+
+		const uint8_t input = data[InputsOffset + i];
+		remoteInputs_[historyIndex(frame)] = input;
+		lastConfirmedFrame_ = frame;
+
+		if (frame < currentFrame_ && usedRemoteInputs_[historyIndex(frame)] != input)
+			rollbackFrame_ = nctl::min(rollbackFrame_, frame);
+	}
+}
+
+void RollbackSession::sendHandshake()
+{
+	uint8_t data[HeaderSize + 12];
+	if (config_.isHost)
+	{
+		writeHeader(data, PacketType::START);
+		writeUint32(data + HeaderSize, static_cast<uint32_t>(seed_));
+		writeUint32(data + HeaderSize + 4, static_cast<uint32_t>(seed_ >> 32));
+		writeUint32(data + HeaderSize + 8, matchDuration_);
+		link_.send(data, HeaderSize + 12);
+	}
+	else
+	{
+		writeHeader(data, PacketType::HELLO);
+		link_.send(data, HeaderSize);
+	}
+	lastHandshakeTime_ = nc::TimeStamp::now();
+}
+
+void RollbackSession::sendInputs()
+{
+	const int firstFrame = lastAckedFrame_ + 1;
+	const int lastFrame = nctl::min(lastLocalFrame_, firstFrame + static_cast<int>(Cfg::Netplay::MaxInputsPerPacket) - 1);
+	const unsigned int numInputs = (lastFrame >= firstFrame) ? static_cast<unsigned int>(lastFrame - firstFrame + 1) : 0;
+
+	// Packets are also sent without inputs, to acknowledge the remote ones and report the current frame
+	uint8_t data[HeaderSize + 13 + Cfg::Netplay::MaxInputsPerPacket];
+	writeHeader(data, PacketType::INPUTS);
+	writeUint32(data + HeaderSize, static_cast<uint32_t>(currentFrame_));
+	writeUint32(data + HeaderSize + 4, static_cast<uint32_t>(lastConfirmedFrame_));
+	writeUint32(data + HeaderSize + 8, static_cast<uint32_t>(firstFrame));
+	data[HeaderSize + 12] = static_cast<uint8_t>(numInputs);
+	for (unsigned int i = 0; i < numInputs; i++)
+		data[HeaderSize + 13 + i] = localInputs_[historyIndex(firstFrame + static_cast<int>(i))];
+
+	link_.send(data, HeaderSize + 13 + numInputs);
+}
+
+void RollbackSession::rollback()
+{
+	if (rollbackFrame_ >= currentFrame_)
+	{
+		rollbackFrame_ = NoRollback;
+		return;
+	}
+
+	const int targetFrame = currentFrame_;
+	const unsigned int depth = static_cast<unsigned int>(targetFrame - rollbackFrame_);
+	ASSERT(depth <= Cfg::Netplay::MaxRollbackFrames);
+
+	const nc::TimeStamp resimulationStart = nc::TimeStamp::now();
+	game_.restoreSnapshot(snapshots_[snapshotIndex(rollbackFrame_)]);
+	currentFrame_ = rollbackFrame_;
+	while (currentFrame_ < targetFrame)
+		advanceFrame(true);
+
+	lastResimulationTime_ = resimulationStart.secondsSince() * 1000.0f;
+	maxResimulationTime_ = nctl::max(maxResimulationTime_, lastResimulationTime_);
+	maxRollbackDepth_ = nctl::max(maxRollbackDepth_, depth);
+	numResimulatedFrames_ += depth;
+	numRollbacks_++;
+	rollbackFrame_ = NoRollback;
+}
+
+void RollbackSession::advanceFrame(bool resimulation)
+{
+	const int frame = currentFrame_;
+	game_.saveSnapshot(snapshots_[snapshotIndex(frame)]);
+
+	const PlayerInput remote = remoteInput(frame);
+	usedRemoteInputs_[historyIndex(frame)] = remote.toBits();
+
+	PlayerInput inputs[2];
+	inputs[localPlayer()] = PlayerInput::fromBits(localInputs_[historyIndex(frame)]);
+	inputs[1 - localPlayer()] = remote;
+	game_.step(TickLength, inputs, resimulation);
+
+	currentFrame_++;
+}
+
+PlayerInput RollbackSession::remoteInput(int frame) const
+{
+	return predictInput(remoteInputs_, lastConfirmedFrame_, frame);
+}
+
+PlayerInput RollbackSession::predictInput(const uint8_t *inputs, int lastConfirmedFrame, int frame)
+{
+	// The remote player is predicted to keep holding what it held in the last confirmed frame,
+	// a jump or a dash is a single press and it is not repeated
+	if (frame <= lastConfirmedFrame)
+		return PlayerInput::fromBits(inputs[historyIndex(frame)]);
+	else if (lastConfirmedFrame >= 0)
+		return PlayerInput::fromBits(inputs[historyIndex(lastConfirmedFrame)] & ~PlayerInput::PressedBits);
+	else
+		return PlayerInput();
+}
+
+bool RollbackSession::testPrediction()
+{
+	uint8_t inputs[Cfg::Netplay::InputHistorySize];
+	memset(inputs, 0, sizeof(inputs));
+
+	PlayerInput pressed;
+	pressed.left = true;
+	pressed.jump = true;
+	pressed.dash = true;
+	const int lastConfirmedFrame = 3;
+	inputs[historyIndex(lastConfirmedFrame)] = pressed.toBits();
+
+	// The confirmed frame keeps its presses, the predicted ones only keep the held direction
+	const PlayerInput confirmed = predictInput(inputs, lastConfirmedFrame, lastConfirmedFrame);
+	if (confirmed.toBits() != pressed.toBits())
+		return false;
+
+	for (int frame = lastConfirmedFrame + 1; frame <= lastConfirmedFrame + static_cast<int>(Cfg::Netplay::MaxRollbackFrames); frame++)
+	{
+		const PlayerInput predicted = predictInput(inputs, lastConfirmedFrame, frame);
+		if (predicted.left == false || predicted.right || predicted.jump || predicted.dash)
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <nctl/UniquePtr.h>
+#include <ncine/TimeStamp.h>
+#include "Config.h"
+#include "NetLink.h"
+#include "PlayerInput.h"
+
+namespace ncine {
+	class AppConfiguration;
+}
+class Game;
+struct GameSnapshot;
+
+namespace nc = ncine;
+
+/// How a network match is started, usually from the command line
+struct NetplayConfig
+{
+	bool isHost = true;
+	unsigned short port = Cfg::Netplay::DefaultPort;
+	unsigned int inputDelay = Cfg::Netplay::DefaultInputDelay;
+	/// Conditions simulated by the loopback harness, in seconds and as a probability
+	float latency = 0.0f;
+	float jitter = 0.0f;
+	float packetLoss = 0.0f;
+};
+
+/// Runs a two players match with a remote peer, rolling back the simulation when the remote inputs arrive
+/*! The simulation advances at a fixed rate. Local inputs are applied a few frames after they are polled, and
+ *  the remote ones are predicted by repeating the last confirmed input. When a confirmed input differs from the
+ *  predicted one, the snapshot of that frame is restored and the following frames are simulated again.
+ *  The host is the first player, it chooses the spawn seed and the match duration. */
+class RollbackSession
+{
+  public:
+	enum class State
+	{
+		CONNECTING,
+		RUNNING,
+		DISCONNECTED
+	};
+
+	RollbackSession(Game &game, const NetplayConfig &config);
+	~RollbackSession();
+
+	/// Returns true and fills the configuration if a netplay argument has been passed on the command line
+	static bool parseArguments(const nc::AppConfiguration &appConfig, NetplayConfig &config);
+
+	inline bool isOpen() const { return link_.isOpen(); }
+	inline State state() const { return state_; }
+	/// The index of the player controlled by this peer
+	inline unsigned int localPlayer() const { return config_.isHost ? 0 : 1; }
+	inline int currentFrame() const { return currentFrame_; }
+	/// The frame count is reached once every remote input up to it has been confirmed, the simulation stops there
+	bool hasReachedFrame(int frame) const;
+	/// The simulation does not advance past this frame, it is set to the end of the match
+	inline void setLastFrame(int frame) { lastFrame_ = frame; }
+
+	/// Exchanges packets, rolls back if needed and advances the simulation by the elapsed time
+	void update(float frameTime);
+
+	void drawGui();
+
+  private:
+	static const unsigned int NumSnapshots = Cfg::Netplay::MaxRollbackFrames + 1;
+
+	Game &game_;
+	NetplayConfig config_;
+	NetLink link_;
+	State state_;
+	uint64_t seed_;
+	/// Match duration in seconds, chosen by the host
+	unsigned int matchDuration_;
+
+	int currentFrame_;
+	int lastFrame_;
+	float timeAccumulator_;
+	/// Jump and dash presses polled since the last simulated frame, applied to the next one only
+	uint8_t pendingPressedInputs_;
+	/// The last frame with a local input, `currentFrame_ + inputDelay - 1` once running
+	int lastLocalFrame_;
+	/// The last local frame the remote peer has confirmed receiving
+	int lastAckedFrame_;
+	/// The last remote frame such that every input up to it has been received
+	int lastConfirmedFrame_;
+	/// The earliest frame whose predicted remote input turned out wrong, past any frame if there is none
+	int rollbackFrame_;
+	/// The last frame simulated by the remote peer, as reported in its packets
+	int remoteFrame_;
+
+	uint8_t localInputs_[Cfg::Netplay::InputHistorySize];
+	uint8_t remoteInputs_[Cfg::Netplay::InputHistorySize];
+	/// The remote inputs used when the frame was simulated, predicted or confirmed
+	uint8_t usedRemoteInputs_[Cfg::Netplay::InputHistorySize];
+	/// When each local input was sent for the first time, to measure the round trip time
+	float localInputSendTimes_[Cfg::Netplay::InputHistorySize];
+	/// The snapshot taken before simulating each of the last frames
+	nctl::UniquePtr<GameSnapshot[]> snapshots_;
+
+	nc::TimeStamp startTime_;
+	nc::TimeStamp lastReceiveTime_;
+	nc::TimeStamp lastHandshakeTime_;
+
+	unsigned int numRollbacks_;
+	unsigned int numResimulatedFrames_;
+	unsigned int maxRollbackDepth_;
+	unsigned int numStalls_;
+	/// In milliseconds
+	float lastResimulationTime_;
+	float maxResimulationTime_;
+	float roundTripTime_;
+
+	void receivePackets();
+	void onInputPacket(const uint8_t *data, unsigned int size);
+	void sendHandshake();
+	void sendInputs();
+	void rollback();
+	/// Saves the snapshot of the current frame, simulates it and advances to the next one
+	void advanceFrame(bool resimulation);
+	PlayerInput remoteInput(int frame) const;
+	/// Returns the input of a frame from a history, predicted from the last confirmed frame if it comes after it
+	static PlayerInput predictInput(const uint8_t *inputs, int lastConfirmedFrame, int frame);
+	/// Checks that a confirmed jump or dash is not repeated on the predicted frames, asserted when a session starts
+	static bool testPrediction();
+
+	static inline unsigned int historyIndex(int frame) { return static_cast<unsigned int>(frame) & (Cfg::Netplay::InputHistorySize - 1); }
+	static inline unsigned int snapshotIndex(int frame) { return static_cast<unsigned int>(frame) % NumSnapshots; }
+};
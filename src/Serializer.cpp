@@ -16,6 +16,10 @@ namespace {
 	char const *const SettingsNumPlayersString = "numPlayers";
 	char const *const SettingsMatchTimeString = "matchTime";
 	char const *const SettingsWithShadersString = "withShaders";
+	char const *const SettingsBlurQualityString = "blurQuality";
+	char const *const SettingsAutoQualityString = "autoQuality";
+	char const *const SettingsRenderScaleString = "renderScale";
+	char const *const SettingsSharpenUpscaleString = "sharpenUpscale";
 	char const *const SettingsWithVibrationString = "withVibration";
 	char const *const SettingsWindowStateString = "windowState";
 
@@ -30,6 +34,14 @@ namespace {
 	char const *const StatisticsPlayerAString = "PlayerA";
 	char const *const StatisticsPlayerBString = "PlayerB";
 
+	char const *const SpawnWavesString = "waves";
+	char const *const SpawnWaveDurationString = "duration";
+	char const *const SpawnWaveRateString = "rate";
+	char const *const SpawnWaveBurstSizeString = "burstSize";
+	char const *const SpawnWaveBurstIntervalString = "burstInterval";
+	char const *const SpawnWaveMaxAlivePerPlayerString = "maxAlivePerPlayer";
+	char const *const SpawnWaveVariantWeightsString = "variantWeights";
+
 	toml::value serializeRect(const nc::Recti &rect)
 	{
 		return toml::value(toml::table {
@@ -100,6 +112,10 @@ bool Serializer::loadSettings(Settings &settings)
 		settings.numPlayers = toml::find_or<unsigned int>(data, SettingsNumPlayersString, defaultSettings.numPlayers);
 		settings.matchTime = toml::find_or<unsigned int>(data, SettingsMatchTimeString, defaultSettings.matchTime);
 		settings.withShaders = toml::find_or<bool>(data, SettingsWithShadersString, defaultSettings.withShaders);
+		settings.blurQuality = toml::find_or<unsigned int>(data, SettingsBlurQualityString, defaultSettings.blurQuality);
+		settings.autoQuality = toml::find_or<bool>(data, SettingsAutoQualityString, defaultSettings.autoQuality);
+		settings.renderScale = toml::find_or<float>(data, SettingsRenderScaleString, defaultSettings.renderScale);
+		settings.sharpenUpscale = toml::find_or<bool>(data, SettingsSharpenUpscaleString, defaultSettings.sharpenUpscale);
 		settings.withVibration = toml::find_or<bool>(data, SettingsWithVibrationString, defaultSettings.withVibration);
 
 		if (data.contains(SettingsWindowStateString) && data.at(SettingsWindowStateString).is_table())
@@ -126,6 +142,10 @@ bool Serializer::saveSettings(const Settings &settings)
 		{ SettingsNumPlayersString, settings.numPlayers },
 		{ SettingsMatchTimeString, settings.matchTime },
 		{ SettingsWithShadersString, settings.withShaders },
+		{ SettingsBlurQualityString, settings.blurQuality },
+		{ SettingsAutoQualityString, settings.autoQuality },
+		{ SettingsRenderScaleString, settings.renderScale },
+		{ SettingsSharpenUpscaleString, settings.sharpenUpscale },
 		{ SettingsWithVibrationString, settings.withVibration }
 	});
 
@@ -246,6 +266,69 @@ bool Serializer::saveStatistics(const Statistics &statistics)
 	file->close();
 	return true;
 }
+
+bool Serializer::loadSpawnWaves(nctl::Array<SpawnWave> &waves)
+{
+	const nctl::String wavesFilepath = nc::fs::joinPath(nc::fs::dataPath(), Cfg::SpawnWavesFilename);
+
+	nctl::UniquePtr<nc::IFile> file = nc::IFile::createFileHandle(wavesFilepath.data());
+	file->open(nc::IFile::OpenMode::READ | nc::IFile::OpenMode::BINARY);
+	if (file->isOpened() == false)
+	{
+		LOGW_X("Cannot open spawn waves file for reading: %s", wavesFilepath.data());
+		return false;
+	}
+
+	const unsigned long fileSize = file->size();
+	nctl::UniquePtr<char[]> fileBuffer = nctl::makeUnique<char[]>(fileSize + 1);
+	file->read(fileBuffer.get(), fileSize);
+	fileBuffer[fileSize] = '\0';
+	file->close();
+
+	std::string fileString(fileBuffer.get(), fileSize);
+	std::istringstream stream(fileString);
+	const auto result = toml::try_parse(stream, Cfg::SpawnWavesFilename, toml::spec::v(1, 1, 0));
+
+	if (result.is_ok())
+	{
+		const toml::value &data = result.unwrap();
+		if (data.contains(SpawnWavesString) == false || data.at(SpawnWavesString).is_array() == false)
+		{
+			LOGW_X("No array of tables named \"%s\" in the spawn waves file", SpawnWavesString);
+			return false;
+		}
+
+		waves.clear();
+		const SpawnWave defaultWave;
+		for (const toml::value &waveData : data.at(SpawnWavesString).as_array())
+		{
+			if (waveData.is_table() == false)
+				continue;
+
+			SpawnWave wave;
+			wave.duration = toml::find_or<float>(waveData, SpawnWaveDurationString, defaultWave.duration);
+			wave.rate = toml::find_or<float>(waveData, SpawnWaveRateString, defaultWave.rate);
+			wave.burstSize = toml::find_or<unsigned int>(waveData, SpawnWaveBurstSizeString, defaultWave.burstSize);
+			wave.burstInterval = toml::find_or<float>(waveData, SpawnWaveBurstIntervalString, defaultWave.burstInterval);
+			wave.maxAlivePerPlayer = toml::find_or<unsigned int>(waveData, SpawnWaveMaxAlivePerPlayerString, defaultWave.maxAlivePerPlayer);
+
+			const std::vector<float> weights = toml::find_or<std::vector<float>>(waveData, SpawnWaveVariantWeightsString, std::vector<float>());
+			for (unsigned int i = 0; i < weights.size() && i < Cfg::Textures::NumBubbleVariants; i++)
+				wave.variantWeights[i] = weights[i];
+
+			validateSpawnWave(wave);
+			waves.pushBack(wave);
+		}
+
+		return (waves.isEmpty() == false);
+	}
+	else
+	{
+		const auto &err = result.unwrap_err();
+		LOGW_X("TOML parse error when loading spawn waves file: \"%s\"", err.at(0).title().data());
+		return false;
+	}
+}
 #else
 bool Serializer::loadSettings(Settings &settings)
 {
@@ -266,6 +349,11 @@ bool Serializer::saveStatistics(const Statistics &statistics)
 {
 	return false;
 }
+
+bool Serializer::loadSpawnWaves(nctl::Array<SpawnWave> &waves)
+{
+	return false;
+}
 #endif
 
 ///////////////////////////////////////////////////////////
@@ -284,6 +372,17 @@ void Serializer::validateSettings(Settings &settings)
 	else if (settings.numPlayers > 2)
 		settings.numPlayers = 2;
 
+	if (settings.blurQuality >= Cfg::Settings::NumBlurQualities)
+		settings.blurQuality = Cfg::Settings::NumBlurQualities - 1;
+
+	if (settings.renderScale > Cfg::Settings::RenderScaleMax)
+		settings.renderScale = Cfg::Settings::RenderScaleMax;
+	else if (settings.renderScale < Cfg::Settings::RenderScaleMin)
+		settings.renderScale = Cfg::Settings::RenderScaleMin;
+	// Only the scales reachable with the step are valid
+	const int numRenderScaleSteps = static_cast<int>((settings.renderScale - Cfg::Settings::RenderScaleMin) / Cfg::Settings::RenderScaleStep + 0.5f);
+	settings.renderScale = Cfg::Settings::RenderScaleMin + numRenderScaleSteps * Cfg::Settings::RenderScaleStep;
+
 	unsigned int targetMatchTime = Cfg::Settings::MatchTimeMax;
 	while (targetMatchTime >= Cfg::Settings::MatchTimeMin)
 	{
@@ -296,3 +395,30 @@ void Serializer::validateSettings(Settings &settings)
 			targetMatchTime -= Cfg::Settings::MatchTimeStep;
 	}
 }
+
+void Serializer::validateSpawnWave(SpawnWave &wave)
+{
+	if (wave.duration < 0.0f)
+		wave.duration = 0.0f;
+	if (wave.rate < 0.0f)
+		wave.rate = 0.0f;
+	if (wave.burstInterval <= 0.0f)
+		wave.burstSize = 0;
+	if (wave.maxAlivePerPlayer > Cfg::Game::BubblePoolMaxSize / 2)
+		wave.maxAlivePerPlayer = Cfg::Game::BubblePoolMaxSize / 2;
+
+	float weightsSum = 0.0f;
+	for (unsigned int i = 0; i < Cfg::Textures::NumBubbleVariants; i++)
+	{
+		if (wave.variantWeights[i] < 0.0f)
+			wave.variantWeights[i] = 0.0f;
+		weightsSum += wave.variantWeights[i];
+	}
+
+	// At least one variant should be possible
+	if (weightsSum <= 0.0f)
+	{
+		for (unsigned int i = 0; i < Cfg::Textures::NumBubbleVariants; i++)
+			wave.variantWeights[i] = 1.0f;
+	}
+}
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <nctl/Array.h>
 #include "Settings.h"
 #include "Statistics.h"
+#include "SpawnWave.h"
 
 class Serializer
 {
@@ -12,8 +14,12 @@ class Serializer
 	static bool loadStatistics(Statistics &statistics);
 	static bool saveStatistics(const Statistics &statistics);
 
+	/// Spawn waves are read-only game data, loaded from the data path
+	static bool loadSpawnWaves(nctl::Array<SpawnWave> &waves);
+
   private:
 	static void validateSettings(Settings &settings);
+	static void validateSpawnWave(SpawnWave &wave);
 };
 
 // Meyers' Singleton
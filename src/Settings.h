@@ -10,6 +10,14 @@ struct Settings
 	unsigned int numPlayers = 1;
 	unsigned int matchTime = 60;
 	bool withShaders = true;
+	/// Pause blur resolution: 0 for full, 1 for half, 2 for quarter
+	unsigned int blurQuality = 1;
+	/// Lowers the shader effects quality when the frame rate drops, and raises it back when there is headroom
+	bool autoQuality = true;
+	/// Fraction of the window resolution at which the game scene is rendered before being upscaled
+	float renderScale = 1.0f;
+	/// Sharpens the upscaled scene when the render scale is lower than one
+	bool sharpenUpscale = true;
 	bool withVibration = true;
 
 	ncine::Recti windowState;
@@ -1,23 +1,64 @@
 #include "ShaderEffects.h"
 #include "nodes/Menu.h"
 #include "nodes/Game.h"
+#include "ResourceManager.h"
+#include <nctl/algorithms.h>
 #include <ncine/Application.h>
 #include <ncine/Viewport.h>
 #include <ncine/Shader.h>
 #include <ncine/ShaderState.h>
 #include <ncine/Texture.h>
 #include <ncine/Sprite.h>
+#include <ncine/Camera.h>
+#include <ncine/TimeStamp.h>
 
 #include "shader_sources.h"
 
+#include <ncine/config.h>
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	#include <ncine/imgui.h>
+#endif
+
+namespace {
+
+/// Creates a sprite that covers a render target of the specified size with the specified texture
+nctl::UniquePtr<nc::Sprite> createTargetSprite(nc::Texture *texture, const nc::Vector2i &targetSize)
+{
+	nctl::UniquePtr<nc::Sprite> sprite = nctl::makeUnique<nc::Sprite>(nullptr, texture, targetSize.x * 0.5f, targetSize.y * 0.5f);
+	sprite->setSize(nc::Vector2f(static_cast<float>(targetSize.x), static_cast<float>(targetSize.y)));
+	return sprite;
+}
+
+/// Dispersion shader states sample the scene texture on the second unit, its size is the resolution of the shader
+void setDispersionUniforms(nc::ShaderState &shaderState, nc::Texture *sceneTexture, const nc::Vector2i &resolution)
+{
+	shaderState.setUniformFloat(nullptr, "winResolution", static_cast<float>(resolution.x), static_cast<float>(resolution.y));
+
+	shaderState.setUniformInt(nullptr, "uTexture", 0); // GL_TEXTURE0
+	shaderState.setTexture(1, sceneTexture); // GL_TEXTURE1
+	shaderState.setUniformInt(nullptr, "uSceneTexture", 1); // GL_TEXTURE1
+}
+
+/// Blur shader states share the same program, their uniforms are dirtied before each pass
+void dirtyBlurUniforms(nc::ShaderState &shaderState, const nc::Vector2i &targetSize, float directionX, float directionY)
+{
+	shaderState.setUniformFloat(nullptr, "uResolution", static_cast<float>(targetSize.x), static_cast<float>(targetSize.y));
+	shaderState.setUniformFloat(nullptr, "uDirection", directionX, directionY);
+}
+
+}
+
 ///////////////////////////////////////////////////////////
 // CONSTRUCTORS AND DESTRUCTOR
 ///////////////////////////////////////////////////////////
 
 ShaderEffects::ShaderEffects()
-    : initialized_(false), currentViewportSetup_(ViewportSetup::NONE),
-      numBlurPasses_(2), updateNode_(nullptr)
+    : initialized_(false), shaderLoadTime_(0.0f), currentViewportSetup_(ViewportSetup::NONE),
+      blurQuality_(BlurQuality::HALF), minBlurQuality_(BlurQuality::FULL), fewerBlurPasses_(false),
+      dispersionEnabled_(true), blurEnabled_(false), blurCaptured_(false),
+      blurCached_(false), renderScale_(1.0f), sharpenUpscale_(true), bubbleAtlasRendered_(false), updateNode_(nullptr)
 {
+	updateResolutions();
 	initialized_ = initialize();
 }
 
@@ -31,19 +72,64 @@ ShaderEffects::~ShaderEffects()
 // PUBLIC FUNCTIONS
 ///////////////////////////////////////////////////////////
 
+void ShaderEffects::onFrameStart()
+{
+	if (initialized_ == false)
+		return;
+
+	if (warmUp_ != nullptr && warmUp_->isReleased() == false && warmUp_->isFinished())
+	{
+		for (unsigned int i = 0; i < warmUp_->numPasses(); i++)
+			LOGI_X("Shader warm-up pass \"%s\": %.2f ms", warmUp_->passTime(i).name, warmUp_->passTime(i).time);
+		LOGI_X("Shader warm-up finished in %.2f ms", warmUp_->totalTime());
+		warmUp_->release();
+	}
+
+	// The bubble atlas is rendered only once, then its viewport leaves the chain
+	nctl::Array<nc::Viewport *> &chain = nc::Viewport::chain();
+	if (bubbleAtlasRendered_ && chain.isEmpty() == false && chain.back() == bubbleAtlasViewport_.get())
+		chain.popBack();
+
+	if (blurEnabled_ == false || blurCached_ || blurCaptured_ == false)
+		return;
+
+	// The scene behind the pause menu is frozen, its blurred image is reused until the blur is invalidated
+	nc::Viewport::chain().clear();
+	nc::Viewport::chain().pushBack(frontViewport_.get());
+	blurCached_ = true;
+}
+
 void ShaderEffects::onDrawViewport(nc::Viewport &viewport)
 {
 	if (initialized_ == false)
 		return;
 
+	// Every viewport is passed to the warm-up, the one drawn after a warm-up pass ends its measurement
+	if (warmUp_ != nullptr && warmUp_->onDrawViewport(viewport))
+		return;
+
 	// Dirtying the uniform cache value at each blur pass
 	if (&viewport == pingViewport_.get())
 	{
-		vpPingSpriteShaderState_->setUniformFloat(nullptr, "uDirection", 1.0f, 0.0f);
-		vpPongSpriteShaderState_->setUniformFloat(nullptr, "uDirection", 0.0f, 1.0f);
+		dirtyBlurUniforms(*vpPingSpriteShaderState_, sceneResolution_, 1.0f, 0.0f);
+		dirtyBlurUniforms(*vpPongSpriteShaderState_, sceneResolution_, 0.0f, 1.0f);
 	}
+	else if (&viewport == blurFirstViewport_.get() || &viewport == blurPingViewport_.get())
+	{
+		dirtyBlurUniforms(*vpBlurFirstShaderState_, blurResolution_, 1.0f, 0.0f);
+		dirtyBlurUniforms(*vpBlurPingShaderState_, blurResolution_, 1.0f, 0.0f);
+		dirtyBlurUniforms(*vpBlurPongShaderState_, blurResolution_, 0.0f, 1.0f);
+	}
+
+	if (&viewport == bubbleAtlasViewport_.get())
+		bubbleAtlasRendered_ = true;
+
+	// When the blur is cached the back viewport is not drawn anymore
+	nc::Viewport *updateViewport = blurCached_ ? frontViewport_.get() : backViewport_.get();
+	if (&viewport == backViewport_.get() && blurEnabled_)
+		blurCaptured_ = true;
 
-	if (&viewport == backViewport_.get() && updateNode_ != nullptr)
+	if (&viewport == updateViewport && updateNode_ != nullptr)
 	{
 
 		if (currentViewportSetup_ == ViewportSetup::MENU)
@@ -59,6 +145,48 @@ void ShaderEffects::onDrawViewport(nc::Viewport &viewport)
 	}
 }
 
+const char *ShaderEffects::viewportName(const nc::Viewport &viewport) const
+{
+	if (&viewport == &nc::theApplication().screenViewport())
+		return "Screen";
+	else if (initialized_ == false)
+		return "Unknown";
+	else if (&viewport == bubbleAtlasViewport_.get())
+		return "Bubble atlas";
+
+	const char *name = renderGraph_.passName(&viewport);
+	if (name == nullptr && warmUp_ != nullptr)
+		name = warmUp_->passName(viewport);
+	return (name != nullptr) ? name : "Unknown";
+}
+
+void ShaderEffects::warmUpShaders()
+{
+	if (initialized_ == false || warmUp_ != nullptr)
+		return;
+
+	// The bubble atlas is sampled by every pass, its content does not matter
+	warmUp_ = nctl::makeUnique<ShaderWarmUp>(bubbleAtlas_.get());
+	const nc::Vector2i targetSize(warmUp_->targetSize(), warmUp_->targetSize());
+
+	const unsigned int blurPass = warmUp_->addPass("Warm-up blur", vpBlurShader_.get(), 1);
+	dirtyBlurUniforms(warmUp_->shaderState(blurPass, 0), targetSize, 1.0f, 0.0f);
+
+	const unsigned int sharpenPass = warmUp_->addPass("Warm-up sharpen", vpSharpenShader_.get(), 1);
+	warmUp_->shaderState(sharpenPass, 0).setUniformFloat(nullptr, "uTexelSize", 1.0f / targetSize.x, 1.0f / targetSize.y);
+	warmUp_->shaderState(sharpenPass, 0).setUniformFloat(nullptr, "uSharpness", Cfg::Upscale::Sharpness);
+
+	const unsigned int dispersionPass = warmUp_->addPass("Warm-up dispersion", vpDispersionShader_.get(), 1);
+	setDispersionUniforms(warmUp_->shaderState(dispersionPass, 0), bubbleAtlas_.get(), targetSize);
+
+	// Enough sprites with the same shader are drawn with the batched program
+	const unsigned int batchedPass = warmUp_->addPass("Warm-up batched dispersion", vpDispersionShader_.get(), Cfg::WarmUp::NumBatchedSprites);
+	for (unsigned int i = 0; i < Cfg::WarmUp::NumBatchedSprites; i++)
+		setDispersionUniforms(warmUp_->shaderState(batchedPass, i), bubbleAtlas_.get(), targetSize);
+
+	warmUp_->pushViewports();
+}
+
 void ShaderEffects::setupMenuViewports(nc::SceneNode *menuNode, nc::SceneNode *backgroundNode, nc::SceneNode *sceneNode, nc::SceneNode *foregroundNode)
 {
 	if (initialized_ == false || currentViewportSetup_ == ViewportSetup::MENU)
@@ -78,16 +206,8 @@ void ShaderEffects::setupMenuViewports(nc::SceneNode *menuNode, nc::SceneNode *b
 	frontViewport_->setRootNode(foregroundNode);
 
 	currentViewportSetup_ = ViewportSetup::MENU;
-	nc::Viewport::chain().clear();
-
-	nc::theApplication().screenViewport().setRootNode(screenSprite_.get());
-
-	nc::Viewport::chain().pushBack(blendingViewportFront_.get());
-	nc::Viewport::chain().pushBack(frontViewport_.get());
-
-	nc::Viewport::chain().pushBack(blendingViewportBack_.get());
-	nc::Viewport::chain().pushBack(sceneViewport_.get());
-	nc::Viewport::chain().pushBack(backViewport_.get());
+	nc::theApplication().screenViewport().setRootNode(compositeRoot_.get());
+	buildRenderGraph(false);
 }
 
 void ShaderEffects::setupGameViewports(nc::SceneNode *gameNode, nc::SceneNode *backgroundNode, nc::SceneNode *sceneNode, nc::SceneNode *foregroundNode)
@@ -118,26 +238,12 @@ void ShaderEffects::setupGameViewportsPause(bool paused)
 	if (initialized_ == false || currentViewportSetup_ != ViewportSetup::GAME)
 		return;
 
-	nc::Viewport::chain().clear();
+	blurEnabled_ = paused;
+	blurCaptured_ = false;
+	blurCached_ = false;
 
-	nc::theApplication().screenViewport().setRootNode(screenSprite_.get());
-
-	nc::Viewport::chain().pushBack(blendingViewportFront_.get());
-	nc::Viewport::chain().pushBack(frontViewport_.get());
-
-	if (paused)
-	{
-		// Ping-pong passes of the separable blur shader
-		for (unsigned int i = 0; i < numBlurPasses_; i++)
-		{
-			nc::Viewport::chain().pushBack(pongViewport_.get());
-			nc::Viewport::chain().pushBack(pingViewport_.get());
-		}
-	}
-
-	nc::Viewport::chain().pushBack(blendingViewportBack_.get());
-	nc::Viewport::chain().pushBack(sceneViewport_.get());
-	nc::Viewport::chain().pushBack(backViewport_.get());
+	nc::theApplication().screenViewport().setRootNode(compositeRoot_.get());
+	buildRenderGraph(paused);
 }
 
 void ShaderEffects::resetViewports()
@@ -146,45 +252,175 @@ void ShaderEffects::resetViewports()
 		return;
 
 	currentViewportSetup_ = ViewportSetup::NONE;
+	blurEnabled_ = false;
+	blurCaptured_ = false;
+	blurCached_ = false;
 	nc::Viewport::chain().clear();
+	updateSharpening();
 
 	nc::theApplication().screenViewport().setRootNode(&nc::theApplication().rootNode());
 	updateNode_ = nullptr;
 }
 
-void ShaderEffects::setBubbleShader(nc::Sprite *sprite, unsigned int index)
+void ShaderEffects::setBubbleShader(nc::Sprite *sprite, unsigned int index, unsigned int variant)
 {
-	if (initialized_ == false || index >= Cfg::Game::BubblePoolSize)
+	if (initialized_ == false)
 		return;
 
-	// Set a node first with `setNode()`, then its shader with `setShader()`
-	vpDispersionShaderState_[index]->setNode(sprite);
-	vpDispersionShaderState_[index]->setShader(vpDispersionShader_.get());
-	vpDispersionShaderState_[index]->setUniformFloat(nullptr, "winResolution", static_cast<float>(nc::theApplication().width()), static_cast<float>(nc::theApplication().height()));
-
-	// Storing old values before altering the sprite
-	const nc::Texture *spriteTexture = sprite->texture();
-	const nc::Vector2f spriteSize = sprite->absSize();
+	while (index >= vpDispersionShaderState_.size())
+	{
+		vpDispersionShaderState_.pushBack(nctl::makeUnique<nc::ShaderState>(nullptr, vpDispersionShader_.get()));
+		bubbleSprites_.pushBack(nullptr);
+	}
 
-	// Set the sprite texture, then the texture rectangle, then its size
-	sprite->setTexture(texture0_.get());
-	sprite->setTexRect(nc::Recti(0, 0, texture0_->width(), texture0_->height()));
-	sprite->setSize(spriteSize * 1.0f / sprite->absScale().x);
+	// The sprite texture is the atlas, the variant is selected by the texture rectangle only
+	sprite->setTexture(bubbleAtlas_.get());
+	sprite->setTexRect(bubbleAtlasRects_[variant]);
 
-	vpDispersionShaderState_[index]->setTexture(0, texture0_.get()); // GL_TEXTURE0
-	vpDispersionShaderState_[index]->setUniformInt(nullptr, "uTexture", 0); // GL_TEXTURE0
-	vpDispersionShaderState_[index]->setTexture(1, spriteTexture); // GL_TEXTURE1
-	vpDispersionShaderState_[index]->setUniformInt(nullptr, "uTexture1", 1); // GL_TEXTURE1
+	bubbleSprites_[index] = sprite;
+	if (dispersionEnabled_)
+		attachDispersionShader(index);
 }
 
 void ShaderEffects::clearBubbleShader(unsigned int index)
 {
-	if (initialized_ == false || index >= Cfg::Game::BubblePoolSize)
+	if (initialized_ == false || index >= vpDispersionShaderState_.size())
 		return;
 
-	// Remove a shader first with `setShader(nullptr)`, then the node with `setNode(nullptr)`
-	vpDispersionShaderState_[index]->setShader(nullptr);
-	vpDispersionShaderState_[index]->setNode(nullptr);
+	detachDispersionShader(index);
+	bubbleSprites_[index] = nullptr;
+}
+
+void ShaderEffects::setBubbleVariant(nc::Sprite *sprite, unsigned int variant)
+{
+	if (initialized_ == false)
+		return;
+
+	ASSERT(variant < Cfg::Textures::NumBubbleVariants);
+	sprite->setTexRect(bubbleAtlasRects_[variant]);
+}
+
+void ShaderEffects::setBlurQuality(BlurQuality quality)
+{
+	if (blurQuality_ == quality)
+		return;
+
+	blurQuality_ = quality;
+	onBlurChanged();
+}
+
+ShaderEffects::BlurQuality ShaderEffects::effectiveBlurQuality() const
+{
+	// Lower qualities have higher values
+	return (minBlurQuality_ > blurQuality_) ? minBlurQuality_ : blurQuality_;
+}
+
+void ShaderEffects::setMinBlurQuality(BlurQuality quality)
+{
+	if (minBlurQuality_ == quality)
+		return;
+
+	minBlurQuality_ = quality;
+	onBlurChanged();
+}
+
+void ShaderEffects::setFewerBlurPasses(bool enabled)
+{
+	if (fewerBlurPasses_ == enabled)
+		return;
+
+	fewerBlurPasses_ = enabled;
+	onBlurChanged();
+}
+
+void ShaderEffects::setDispersionEnabled(bool enabled)
+{
+	if (dispersionEnabled_ == enabled)
+		return;
+
+	dispersionEnabled_ = enabled;
+	if (initialized_ == false)
+		return;
+
+	for (unsigned int i = 0; i < bubbleSprites_.size(); i++)
+	{
+		if (bubbleSprites_[i] == nullptr)
+			continue;
+
+		if (enabled)
+			attachDispersionShader(i);
+		else
+			detachDispersionShader(i);
+	}
+}
+
+void ShaderEffects::setRenderScale(float scale)
+{
+	scale = nctl::clamp(scale, Cfg::Settings::RenderScaleMin, Cfg::Settings::RenderScaleMax);
+	if (renderScale_ == scale)
+		return;
+
+	renderScale_ = scale;
+	updateResolutions();
+	if (initialized_ == false)
+		return;
+
+	createSceneTexture();
+	// Bubbles sample the new scene texture, whose size is also the dispersion resolution
+	for (unsigned int i = 0; i < bubbleSprites_.size(); i++)
+	{
+		if (bubbleSprites_[i] != nullptr && dispersionEnabled_)
+			attachDispersionShader(i);
+	}
+
+	if (currentViewportSetup_ == ViewportSetup::MENU)
+		buildRenderGraph(false);
+	else if (currentViewportSetup_ == ViewportSetup::GAME)
+		setupGameViewportsPause(blurEnabled_);
+	// The targets of the previous scale are not needed until the scale changes again
+	renderGraph_.releaseUnusedTextures();
+}
+
+void ShaderEffects::setSharpenUpscale(bool enabled)
+{
+	if (sharpenUpscale_ == enabled)
+		return;
+
+	sharpenUpscale_ = enabled;
+	if (initialized_)
+		updateSharpening();
+}
+
+void ShaderEffects::invalidateBlurCache()
+{
+	if (initialized_ == false || currentViewportSetup_ != ViewportSetup::GAME || blurEnabled_ == false)
+		return;
+
+	setupGameViewportsPause(true);
+}
+
+void ShaderEffects::drawGui()
+{
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	if (initialized_ == false)
+		return;
+
+	ImGui::Text("Shader programs loaded in %.2f ms", shaderLoadTime_);
+	if (warmUp_ != nullptr)
+		warmUp_->drawGui();
+	if (ImGui::TreeNode("Render Scale"))
+	{
+		float renderScale = renderScale_;
+		if (ImGui::SliderFloat("Scale", &renderScale, Cfg::Settings::RenderScaleMin, Cfg::Settings::RenderScaleMax, "%.2f"))
+			setRenderScale(renderScale);
+		bool sharpenUpscale = sharpenUpscale_;
+		if (ImGui::Checkbox("Sharpen upscale", &sharpenUpscale))
+			setSharpenUpscale(sharpenUpscale);
+		ImGui::Text("Scene resolution: %d x %d", sceneResolution_.x, sceneResolution_.y);
+		ImGui::TreePop();
+	}
+	renderGraph_.drawGui();
+#endif
 }
 
 ///////////////////////////////////////////////////////////
@@ -193,53 +429,63 @@ void ShaderEffects::clearBubbleShader(unsigned int index)
 
 bool ShaderEffects::initialize()
 {
+	// Programs found in the binary shader cache are not compiled again
+	const nc::TimeStamp compileStart = nc::TimeStamp::now();
 	const bool compiled = compileShaders();
+	shaderLoadTime_ = compileStart.secondsSince() * 1000.0f;
+	LOGI_X("Shader effects programs ready in %.2f ms", shaderLoadTime_);
 	if (compiled == false)
 		return false;
 
-	texture0_ = nctl::makeUnique<nc::Texture>("Ping texture", nc::Texture::Format::RGB8, nc::theApplication().resolutionInt());
-	texture1_ = nctl::makeUnique<nc::Texture>("Pong texture", nc::Texture::Format::RGB8, nc::theApplication().resolutionInt());
-	textureFront_ = nctl::makeUnique<nc::Texture>("Front texture", nc::Texture::Format::RGBA8, nc::theApplication().resolutionInt());
-	textureExtra_ = nctl::makeUnique<nc::Texture>("Extra texture", nc::Texture::Format::RGBA8, nc::theApplication().resolutionInt());
+	const nc::Vector2i resolution = nc::theApplication().resolutionInt();
+	createSceneTexture();
 
-	screenSprite_ = nctl::makeUnique<nc::Sprite>(nullptr, texture0_.get(), nc::theApplication().width() * 0.5f, nc::theApplication().height() * 0.5f);
+	// Every viewport and sprite starts with the scene texture, the render graph binds their targets when compiled
 
 	backViewport_ = nctl::makeUnique<nc::Viewport>(texture0_.get());
-	sceneViewport_ = nctl::makeUnique<nc::Viewport>(textureExtra_.get());
+	sceneViewport_ = nctl::makeUnique<nc::Viewport>(texture0_.get());
 	blendingViewportBack_ = nctl::makeUnique<nc::Viewport>(texture0_.get());
-	pingViewport_ = nctl::makeUnique<nc::Viewport>(texture1_.get());
+	pingViewport_ = nctl::makeUnique<nc::Viewport>(texture0_.get());
 	pongViewport_ = nctl::makeUnique<nc::Viewport>(texture0_.get());
-	frontViewport_ = nctl::makeUnique<nc::Viewport>(textureFront_.get());
-	blendingViewportFront_ = nctl::makeUnique<nc::Viewport>(textureExtra_.get());
+	frontViewport_ = nctl::makeUnique<nc::Viewport>(texture0_.get());
 
 	sceneViewport_->setRootNode(&nc::theApplication().rootNode());
 	sceneViewport_->setClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 
-	vpBlendingSpriteBack_ = nctl::makeUnique<nc::Sprite>(nullptr, textureExtra_.get(), nc::theApplication().width() * 0.5f, nc::theApplication().height() * 0.5f);
-	blendingViewportBack_->setTexture(texture0_.get());
+	vpBlendingSpriteBack_ = createTargetSprite(texture0_.get(), resolution);
 	blendingViewportBack_->setRootNode(vpBlendingSpriteBack_.get());
-	blendingViewportBack_->setClearMode(nc::Viewport::ClearMode::NEVER);
 
-	vpPingSprite_ = nctl::makeUnique<nc::Sprite>(nullptr, texture0_.get(), nc::theApplication().width() * 0.5f, nc::theApplication().height() * 0.5f);
+	vpPingSprite_ = createTargetSprite(texture0_.get(), resolution);
 	pingViewport_->setRootNode(vpPingSprite_.get());
 	vpPingSpriteShaderState_ = nctl::makeUnique<nc::ShaderState>(vpPingSprite_.get(), vpBlurShader_.get());
-	vpPingSpriteShaderState_->setUniformFloat(nullptr, "uResolution", static_cast<float>(texture0_->width()), static_cast<float>(texture0_->height()));
+	dirtyBlurUniforms(*vpPingSpriteShaderState_, resolution, 1.0f, 0.0f);
 
-	vpPongSprite_ = nctl::makeUnique<nc::Sprite>(nullptr, texture1_.get(), nc::theApplication().width() * 0.5f, nc::theApplication().height() * 0.5f);
+	vpPongSprite_ = createTargetSprite(texture0_.get(), resolution);
 	pongViewport_->setRootNode(vpPongSprite_.get());
 	vpPongSpriteShaderState_ = nctl::makeUnique<nc::ShaderState>(vpPongSprite_.get(), vpBlurShader_.get());
-	vpPongSpriteShaderState_->setUniformFloat(nullptr, "uResolution", static_cast<float>(texture1_->width()), static_cast<float>(texture1_->height()));
+	dirtyBlurUniforms(*vpPongSpriteShaderState_, resolution, 0.0f, 1.0f);
 
 	frontViewport_->setRootNode(&nc::theApplication().rootNode());
 	frontViewport_->setClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 
-	vpBlendingSpriteFront_ = nctl::makeUnique<nc::Sprite>(nullptr, textureFront_.get(), nc::theApplication().width() * 0.5f, nc::theApplication().height() * 0.5f);
-	blendingViewportFront_->setTexture(texture0_.get());
-	blendingViewportFront_->setRootNode(vpBlendingSpriteFront_.get());
-	blendingViewportFront_->setClearMode(nc::Viewport::ClearMode::NEVER);
+	compositeRoot_ = nctl::makeUnique<nc::SceneNode>();
+	vpCompositeSceneSprite_ = createTargetSprite(texture0_.get(), resolution);
+	vpCompositeSceneSprite_->setParent(compositeRoot_.get());
+	vpCompositeFrontSprite_ = createTargetSprite(texture0_.get(), resolution);
+	vpCompositeFrontSprite_->setParent(compositeRoot_.get());
+	vpCompositeFrontSprite_->setLayer(1);
+	vpSharpenShaderState_ = nctl::makeUnique<nc::ShaderState>(nullptr, vpSharpenShader_.get());
 
-	for (unsigned int i = 0; i < Cfg::Game::BubblePoolSize; i++)
-		vpDispersionShaderState_[i] = nctl::makeUnique<nc::ShaderState>(nullptr, vpDispersionShader_.get());
+	createDownsampledBlur();
+	createBubbleAtlas();
+
+	vpDispersionShaderState_.setCapacity(Cfg::Game::BubblePoolChunkSize);
+	bubbleSprites_.setCapacity(Cfg::Game::BubblePoolChunkSize);
+	for (unsigned int i = 0; i < Cfg::Game::BubblePoolChunkSize; i++)
+	{
+		vpDispersionShaderState_.pushBack(nctl::makeUnique<nc::ShaderState>(nullptr, vpDispersionShader_.get()));
+		bubbleSprites_.pushBack(nullptr);
+	}
 
 	return true;
 }
@@ -255,6 +501,13 @@ bool ShaderEffects::compileShaders()
 		compiled &= vpBlurShader_->isLinked();
 	}
 
+	if (compiled == true)
+	{
+		vpSharpenShader_ = nctl::makeUnique<nc::Shader>("Sharpen_Shader", nc::Shader::LoadMode::STRING, nc::Shader::DefaultVertex::SPRITE, sprite_sharpen_fs);
+		ASSERT(vpSharpenShader_->isLinked());
+		compiled &= vpSharpenShader_->isLinked();
+	}
+
 	if (compiled == true)
 	{
 		vpDispersionShader_ = nctl::makeUnique<nc::Shader>("Dispersion_Shader", nc::Shader::LoadMode::STRING, sprite_dispersion_vs, sprite_dispersion_fs);
@@ -271,3 +524,239 @@ bool ShaderEffects::compileShaders()
 
 	return compiled;
 }
+
+void ShaderEffects::createDownsampledBlur()
+{
+	const nc::Vector2i resolution = nc::theApplication().resolutionInt();
+
+	vpDownsampleSprite_ = createTargetSprite(texture0_.get(), resolution);
+	downsampleViewport_ = nctl::makeUnique<nc::Viewport>(texture0_.get());
+	downsampleViewport_->setRootNode(vpDownsampleSprite_.get());
+
+	// The first horizontal pass also downsamples, as the shader samples the source at the target resolution
+	vpBlurFirstSprite_ = createTargetSprite(texture0_.get(), resolution);
+	vpBlurFirstShaderState_ = nctl::makeUnique<nc::ShaderState>(vpBlurFirstSprite_.get(), vpBlurShader_.get());
+	blurFirstViewport_ = nctl::makeUnique<nc::Viewport>(texture0_.get());
+	blurFirstViewport_->setRootNode(vpBlurFirstSprite_.get());
+
+	vpBlurPingSprite_ = createTargetSprite(texture0_.get(), resolution);
+	vpBlurPingShaderState_ = nctl::makeUnique<nc::ShaderState>(vpBlurPingSprite_.get(), vpBlurShader_.get());
+	blurPingViewport_ = nctl::makeUnique<nc::Viewport>(texture0_.get());
+	blurPingViewport_->setRootNode(vpBlurPingSprite_.get());
+
+	vpBlurPongSprite_ = createTargetSprite(texture0_.get(), resolution);
+	vpBlurPongShaderState_ = nctl::makeUnique<nc::ShaderState>(vpBlurPongSprite_.get(), vpBlurShader_.get());
+	blurPongViewport_ = nctl::makeUnique<nc::Viewport>(texture0_.get());
+	blurPongViewport_->setRootNode(vpBlurPongSprite_.get());
+
+	dirtyBlurUniforms(*vpBlurFirstShaderState_, blurResolution_, 1.0f, 0.0f);
+	dirtyBlurUniforms(*vpBlurPingShaderState_, blurResolution_, 1.0f, 0.0f);
+	dirtyBlurUniforms(*vpBlurPongShaderState_, blurResolution_, 0.0f, 1.0f);
+}
+
+void ShaderEffects::buildRenderGraph(bool paused)
+{
+	using LoadOp = RenderGraph::LoadOp;
+	const nc::Vector2i resolution = nc::theApplication().resolutionInt();
+
+	// The window might have been resized since the last compilation
+	updateResolutions();
+	renderGraph_.reset();
+	const RenderGraph::ResourceId scene = renderGraph_.importTexture("Scene", texture0_.get());
+	// The foreground is drawn after the scene layer has been blended, the two layers share the same texture
+	const RenderGraph::ResourceId sceneLayer = renderGraph_.createTexture("Scene layer", nc::Texture::Format::RGBA8, sceneResolution_);
+	// The foreground is never scaled, text and menus stay sharp
+	const RenderGraph::ResourceId frontLayer = renderGraph_.createTexture("Foreground layer", nc::Texture::Format::RGBA8, resolution);
+
+	renderGraph_.addPass("Background", backViewport_.get(), scene, LoadOp::CLEAR);
+	// Bubbles sample the background with the dispersion shader
+	const RenderGraph::PassId scenePass = renderGraph_.addPass("Scene", sceneViewport_.get(), sceneLayer, LoadOp::CLEAR);
+	renderGraph_.addInput(scenePass, scene);
+	const RenderGraph::PassId blendBackPass = renderGraph_.addPass("Scene blending", blendingViewportBack_.get(), scene, LoadOp::LOAD);
+	renderGraph_.addInput(blendBackPass, sceneLayer, vpBlendingSpriteBack_.get());
+
+	const RenderGraph::ResourceId blurResult = paused ? addBlurPasses(scene) : RenderGraph::InvalidId;
+	renderGraph_.addPass("Foreground", frontViewport_.get(), frontLayer, LoadOp::CLEAR);
+
+	// The screen viewport upscales the scene, or its blur, and blends the foreground on top of it.
+	// The blur result is left untouched, so that it can be reused for the next frames.
+	const RenderGraph::PassId screenPass = renderGraph_.addPass("Screen", &nc::theApplication().screenViewport(), RenderGraph::InvalidId, LoadOp::CLEAR);
+	renderGraph_.addInput(screenPass, paused ? blurResult : scene, vpCompositeSceneSprite_.get());
+	renderGraph_.addInput(screenPass, frontLayer, vpCompositeFrontSprite_.get());
+
+	renderGraph_.compile();
+	updateSharpening();
+	pushOneShotViewports();
+}
+
+RenderGraph::ResourceId ShaderEffects::addBlurPasses(RenderGraph::ResourceId scene)
+{
+	using LoadOp = RenderGraph::LoadOp;
+	const BlurQuality blurQuality = effectiveBlurQuality();
+	unsigned int numPasses = Cfg::Blur::NumPasses[static_cast<unsigned int>(blurQuality)];
+	if (fewerBlurPasses_ && numPasses > 1)
+		numPasses--;
+	// Every blur pass covers its whole target, there is nothing to clear
+
+	if (blurQuality == BlurQuality::FULL)
+	{
+		// Ping-pong passes of the separable blur shader, the result is back in the scene texture
+		const RenderGraph::ResourceId ping = renderGraph_.createTexture("Blur ping", nc::Texture::Format::RGB8, blurResolution_);
+		for (unsigned int i = 0; i < numPasses; i++)
+		{
+			const RenderGraph::PassId pingPass = renderGraph_.addPass("Blur horizontal", pingViewport_.get(), ping, LoadOp::DONT_CARE);
+			renderGraph_.addInput(pingPass, scene, vpPingSprite_.get());
+			const RenderGraph::PassId pongPass = renderGraph_.addPass("Blur vertical", pongViewport_.get(), scene, LoadOp::DONT_CARE);
+			renderGraph_.addInput(pongPass, ping, vpPongSprite_.get());
+		}
+		return scene;
+	}
+
+	RenderGraph::ResourceId blurSource = scene;
+	if (blurQuality == BlurQuality::QUARTER)
+	{
+		// Bilinear filtering averages four texels, halving twice avoids skipping scene pixels
+		const nc::Vector2i halfResolution(nctl::max(sceneResolution_.x / 2, 1), nctl::max(sceneResolution_.y / 2, 1));
+		blurSource = renderGraph_.createTexture("Downsample", nc::Texture::Format::RGB8, halfResolution);
+		const RenderGraph::PassId downsamplePass = renderGraph_.addPass("Downsample", downsampleViewport_.get(), blurSource, LoadOp::DONT_CARE);
+		renderGraph_.addInput(downsamplePass, scene, vpDownsampleSprite_.get());
+	}
+
+	const RenderGraph::ResourceId ping = renderGraph_.createTexture("Blur ping", nc::Texture::Format::RGB8, blurResolution_);
+	const RenderGraph::ResourceId pong = renderGraph_.createTexture("Blur pong", nc::Texture::Format::RGB8, blurResolution_);
+	// The low resolution result is upsampled by the screen viewport, also when the blur is cached
+	renderGraph_.setPersistent(pong);
+
+	const RenderGraph::PassId firstPass = renderGraph_.addPass("Blur horizontal", blurFirstViewport_.get(), ping, LoadOp::DONT_CARE);
+	renderGraph_.addInput(firstPass, blurSource, vpBlurFirstSprite_.get());
+	for (unsigned int i = 0; i < numPasses; i++)
+	{
+		if (i > 0)
+		{
+			const RenderGraph::PassId pingPass = renderGraph_.addPass("Blur horizontal", blurPingViewport_.get(), ping, LoadOp::DONT_CARE);
+			renderGraph_.addInput(pingPass, pong, vpBlurPingSprite_.get());
+		}
+		const RenderGraph::PassId pongPass = renderGraph_.addPass("Blur vertical", blurPongViewport_.get(), pong, LoadOp::DONT_CARE);
+		renderGraph_.addInput(pongPass, ping, vpBlurPongSprite_.get());
+	}
+
+	return pong;
+}
+
+void ShaderEffects::updateResolutions()
+{
+	const nc::Vector2i resolution = nc::theApplication().resolutionInt();
+	sceneResolution_.set(nctl::max(static_cast<int>(resolution.x * renderScale_), 1), nctl::max(static_cast<int>(resolution.y * renderScale_), 1));
+
+	const BlurQuality blurQuality = effectiveBlurQuality();
+	const int divisor = (blurQuality == BlurQuality::QUARTER) ? 4 : ((blurQuality == BlurQuality::HALF) ? 2 : 1);
+	blurResolution_.set(nctl::max(sceneResolution_.x / divisor, 1), nctl::max(sceneResolution_.y / divisor, 1));
+}
+
+void ShaderEffects::createSceneTexture()
+{
+	texture0_ = nctl::makeUnique<nc::Texture>("Scene texture", nc::Texture::Format::RGB8, sceneResolution_);
+}
+
+void ShaderEffects::updateSharpening()
+{
+	const nc::Vector2i resolution = nc::theApplication().resolutionInt();
+	const bool upscaled = (sceneResolution_.x < resolution.x || sceneResolution_.y < resolution.y);
+	// The blur would smooth out the sharpening anyway
+	const bool sharpen = sharpenUpscale_ && upscaled && blurEnabled_ == false && currentViewportSetup_ != ViewportSetup::NONE;
+
+	if (sharpen)
+	{
+		// Set a node first with `setNode()`, then its shader with `setShader()`
+		vpSharpenShaderState_->setNode(vpCompositeSceneSprite_.get());
+		vpSharpenShaderState_->setShader(vpSharpenShader_.get());
+		vpSharpenShaderState_->setUniformFloat(nullptr, "uTexelSize", 1.0f / sceneResolution_.x, 1.0f / sceneResolution_.y);
+		vpSharpenShaderState_->setUniformFloat(nullptr, "uSharpness", Cfg::Upscale::Sharpness);
+	}
+	else
+	{
+		// Remove a shader first with `setShader(nullptr)`, then the node with `setNode(nullptr)`
+		vpSharpenShaderState_->setShader(nullptr);
+		vpSharpenShaderState_->setNode(nullptr);
+	}
+}
+
+void ShaderEffects::onBlurChanged()
+{
+	updateResolutions();
+	if (initialized_ == false)
+		return;
+
+	if (currentViewportSetup_ == ViewportSetup::GAME && blurEnabled_)
+		setupGameViewportsPause(true);
+	// The targets of the previous quality are not needed until the quality changes again
+	renderGraph_.releaseUnusedTextures();
+}
+
+void ShaderEffects::attachDispersionShader(unsigned int index)
+{
+	nc::ShaderState &shaderState = *vpDispersionShaderState_[index];
+
+	// Set a node first with `setNode()`, then its shader with `setShader()`
+	shaderState.setNode(bubbleSprites_[index]);
+	shaderState.setShader(vpDispersionShader_.get());
+	// The scene texture is sampled with window coordinates scaled to its resolution
+	setDispersionUniforms(shaderState, texture0_.get(), sceneResolution_);
+}
+
+void ShaderEffects::detachDispersionShader(unsigned int index)
+{
+	// Remove a shader first with `setShader(nullptr)`, then the node with `setNode(nullptr)`
+	vpDispersionShaderState_[index]->setShader(nullptr);
+	vpDispersionShaderState_[index]->setNode(nullptr);
+}
+
+void ShaderEffects::createBubbleAtlas()
+{
+	nc::Vector2i cellSize(0, 0);
+	nc::Texture *bubbleTextures[Cfg::Textures::NumBubbleVariants];
+	for (unsigned int i = 0; i < Cfg::Textures::NumBubbleVariants; i++)
+	{
+		bubbleTextures[i] = resourceManager().retrieveTexture(Cfg::Textures::Bubbles[i]);
+		cellSize.x = nctl::max(cellSize.x, bubbleTextures[i]->width());
+		cellSize.y = nctl::max(cellSize.y, bubbleTextures[i]->height());
+	}
+
+	const nc::Vector2i atlasSize(cellSize.x * Cfg::Textures::NumBubbleVariants, cellSize.y);
+	bubbleAtlas_ = nctl::makeUnique<nc::Texture>("Bubble atlas", nc::Texture::Format::RGBA8, atlasSize);
+	bubbleAtlasRoot_ = nctl::makeUnique<nc::SceneNode>();
+
+	for (unsigned int i = 0; i < Cfg::Textures::NumBubbleVariants; i++)
+	{
+		// Variants are vertically centered in their cell, the region does not depend on the render target orientation
+		const int width = bubbleTextures[i]->width();
+		const int height = bubbleTextures[i]->height();
+		const nc::Vector2i cellOrigin(cellSize.x * i, 0);
+		bubbleAtlasRects_[i] = nc::Recti(cellOrigin.x + (cellSize.x - width) / 2, (cellSize.y - height) / 2, width, height);
+
+		nctl::UniquePtr<nc::Sprite> sprite = nctl::makeUnique<nc::Sprite>(bubbleAtlasRoot_.get(), bubbleTextures[i],
+		                                                                  cellOrigin.x + cellSize.x * 0.5f, cellSize.y * 0.5f);
+		// Texels are copied as they are, alpha included, and flipped like any other sprite drawn to a render target
+		sprite->setBlendingEnabled(false);
+		sprite->setFlippedY(true);
+		bubbleAtlasSprites_.pushBack(nctl::move(sprite));
+	}
+
+	bubbleAtlasViewport_ = nctl::makeUnique<nc::Viewport>(bubbleAtlas_.get());
+	bubbleAtlasViewport_->setRootNode(bubbleAtlasRoot_.get());
+	// The atlas is not drawn in window coordinates like the render graph passes
+	bubbleAtlasCamera_ = nctl::makeUnique<nc::Camera>();
+	bubbleAtlasCamera_->setOrthoProjection(0.0f, static_cast<float>(atlasSize.x), 0.0f, static_cast<float>(atlasSize.y));
+	bubbleAtlasViewport_->setCamera(bubbleAtlasCamera_.get());
+	bubbleAtlasViewport_->setClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	bubbleAtlasRendered_ = false;
+}
+
+void ShaderEffects::pushOneShotViewports()
+{
+	if (warmUp_ != nullptr)
+		warmUp_->pushViewports();
+	// The last viewport in the chain is the first one to be drawn
+	if (bubbleAtlasRendered_ == false)
+		nc::Viewport::chain().pushBack(bubbleAtlasViewport_.get());
+}
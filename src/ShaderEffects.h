@@ -1,7 +1,12 @@
 #pragma once
 
+#include <nctl/Array.h>
+#include <nctl/StaticArray.h>
 #include <nctl/UniquePtr.h>
+#include <ncine/Rect.h>
 #include "Config.h"
+#include "RenderGraph.h"
+#include "ShaderWarmUp.h"
 
 namespace ncine {
 	class Viewport;
@@ -10,6 +15,7 @@ namespace ncine {
 	class Shader;
 	class ShaderState;
 	class Sprite;
+	class Camera;
 }
 
 namespace nc = ncine;
@@ -24,28 +30,95 @@ class ShaderEffects
 		GAME
 	};
 
+	/// Resolution of the pause blur, lower resolutions are downsampled before blurring and upsampled when composited
+	enum class BlurQuality
+	{
+		FULL,
+		HALF,
+		QUARTER
+	};
+
 	ShaderEffects();
 	~ShaderEffects();
 
 	inline bool isInitialized() const { return initialized_; }
+	/// Time spent loading or compiling the shader programs at startup, in milliseconds
+	inline float shaderLoadTime() const { return shaderLoadTime_; }
+	/// Draws every program once to a small target within the next frames, ahead of its first real use
+	void warmUpShaders();
+	inline bool isWarmUpFinished() const { return warmUp_ != nullptr && warmUp_->isReleased(); }
+	/// Drops the blur passes from the chain once the paused scene has been blurred
+	void onFrameStart();
 	void onDrawViewport(nc::Viewport &viewport);
+	/// Returns the render graph pass name of a viewport, used to label its GPU time
+	const char *viewportName(const nc::Viewport &viewport) const;
 
 	void setupMenuViewports(nc::SceneNode *menuNode, nc::SceneNode *backgroundNode, nc::SceneNode *sceneNode, nc::SceneNode *foregroundNode);
 	void setupGameViewports(nc::SceneNode *gameNode, nc::SceneNode *backgroundNode, nc::SceneNode *sceneNode, nc::SceneNode *foregroundNode);
 	void setupGameViewportsPause(bool paused);
 	void resetViewports();
-	void setBubbleShader(nc::Sprite *sprite, unsigned int index);
+	/// Sets the dispersion shader to a bubble sprite, which then samples the variant region of the bubble atlas
+	void setBubbleShader(nc::Sprite *sprite, unsigned int index, unsigned int variant);
 	void clearBubbleShader(unsigned int index);
+	/// Changes the bubble atlas region of a sprite with the dispersion shader
+	void setBubbleVariant(nc::Sprite *sprite, unsigned int variant);
+
+	inline BlurQuality blurQuality() const { return blurQuality_; }
+	/// Recompiles the render graph if the game is paused, then releases the render targets of the previous quality
+	void setBlurQuality(BlurQuality quality);
+	/// The blur quality used for rendering, the lowest between the selected one and the minimum one
+	BlurQuality effectiveBlurQuality() const;
+	/// Limits the blur quality regardless of the selected one, used by the quality scaler
+	void setMinBlurQuality(BlurQuality quality);
+	/// Blurs with one pass less, when there is more than one
+	void setFewerBlurPasses(bool enabled);
+	inline bool isDispersionEnabled() const { return dispersionEnabled_; }
+	/// Bubbles keep sampling the atlas when the dispersion shader is disabled, without reading the scene texture
+	void setDispersionEnabled(bool enabled);
+	inline float renderScale() const { return renderScale_; }
+	/// Renders the background and the scene at a fraction of the window resolution, the foreground stays at full resolution
+	void setRenderScale(float scale);
+	inline bool isSharpenUpscaleEnabled() const { return sharpenUpscale_; }
+	/// Sharpens the scene when it is upscaled to the window, instead of only filtering it bilinearly
+	void setSharpenUpscale(bool enabled);
+	inline const nc::Vector2i &sceneResolution() const { return sceneResolution_; }
+
+	/// Blurs the paused scene again on the next frame, when something behind the pause menu has changed
+	void invalidateBlurCache();
+	inline bool isBlurCached() const { return blurCached_; }
+
+	void drawGui();
 
   private:
 	bool initialized_;
-	int numBlurPasses_;
+	float shaderLoadTime_;
 	ViewportSetup currentViewportSetup_;
+	BlurQuality blurQuality_;
+	BlurQuality minBlurQuality_;
+	bool fewerBlurPasses_;
+	bool dispersionEnabled_;
+	bool blurEnabled_;
+	/// The paused scene has been drawn and blurred at least once since the blur was enabled
+	bool blurCaptured_;
+	/// Only the foreground is drawn, composited over the last blur result
+	bool blurCached_;
+	float renderScale_;
+	bool sharpenUpscale_;
 
+	/// The composited scene, sampled by the bubbles, it is the only render target not owned by the render graph
 	nctl::UniquePtr<nc::Texture> texture0_;
-	nctl::UniquePtr<nc::Texture> texture1_;
-	nctl::UniquePtr<nc::Texture> textureFront_;
-	nctl::UniquePtr<nc::Texture> textureExtra_;
+	/// Declares the passes of the current viewport setup, it owns and aliases the other render targets
+	RenderGraph renderGraph_;
+	/// Size of the scene targets for the current render scale
+	nc::Vector2i sceneResolution_;
+	/// Size of the downsampled blur targets for the current quality
+	nc::Vector2i blurResolution_;
+	/// All bubble variants side by side, so that every bubble shares the same textures and can be batched
+	nctl::UniquePtr<nc::Texture> bubbleAtlas_;
+	nc::Recti bubbleAtlasRects_[Cfg::Textures::NumBubbleVariants];
+	bool bubbleAtlasRendered_;
+	/// Released once every program has been drawn, only the timings are kept
+	nctl::UniquePtr<ShaderWarmUp> warmUp_;
 
 	nctl::UniquePtr<nc::Viewport> backViewport_;
 	nctl::UniquePtr<nc::Viewport> sceneViewport_;
@@ -53,24 +126,70 @@ class ShaderEffects
 	nctl::UniquePtr<nc::Viewport> pingViewport_;
 	nctl::UniquePtr<nc::Viewport> pongViewport_;
 	nctl::UniquePtr<nc::Viewport> frontViewport_;
-	nctl::UniquePtr<nc::Viewport> blendingViewportFront_;
 
-	nctl::UniquePtr<nc::Sprite> screenSprite_;
+	/// Halves the scene resolution before blurring at quarter quality
+	nctl::UniquePtr<nc::Viewport> downsampleViewport_;
+	/// The first downsampled blur pass reads from the scene, the following ones ping-pong between the blur targets
+	nctl::UniquePtr<nc::Viewport> blurFirstViewport_;
+	nctl::UniquePtr<nc::Viewport> blurPingViewport_;
+	nctl::UniquePtr<nc::Viewport> blurPongViewport_;
+	/// Renders the bubble atlas once, before any other viewport
+	nctl::UniquePtr<nc::Viewport> bubbleAtlasViewport_;
+	nctl::UniquePtr<nc::Camera> bubbleAtlasCamera_;
+
 	nctl::UniquePtr<nc::Sprite> vpBlendingSpriteBack_;
 	nctl::UniquePtr<nc::Sprite> vpPingSprite_;
 	nctl::UniquePtr<nc::Sprite> vpPongSprite_;
-	nctl::UniquePtr<nc::Sprite> vpBlendingSpriteFront_;
+	nctl::UniquePtr<nc::Sprite> vpDownsampleSprite_;
+	nctl::UniquePtr<nc::Sprite> vpBlurFirstSprite_;
+	nctl::UniquePtr<nc::Sprite> vpBlurPingSprite_;
+	nctl::UniquePtr<nc::Sprite> vpBlurPongSprite_;
+	/// The screen viewport composites the scene, or its blur while paused, and the foreground, upscaling the former
+	nctl::UniquePtr<nc::SceneNode> compositeRoot_;
+	nctl::UniquePtr<nc::Sprite> vpCompositeSceneSprite_;
+	nctl::UniquePtr<nc::Sprite> vpCompositeFrontSprite_;
+	nctl::UniquePtr<nc::SceneNode> bubbleAtlasRoot_;
+	nctl::StaticArray<nctl::UniquePtr<nc::Sprite>, Cfg::Textures::NumBubbleVariants> bubbleAtlasSprites_;
 
 	nctl::UniquePtr<nc::Shader> vpBlurShader_;
 	nctl::UniquePtr<nc::ShaderState> vpPingSpriteShaderState_;
 	nctl::UniquePtr<nc::ShaderState> vpPongSpriteShaderState_;
+	nctl::UniquePtr<nc::ShaderState> vpBlurFirstShaderState_;
+	nctl::UniquePtr<nc::ShaderState> vpBlurPingShaderState_;
+	nctl::UniquePtr<nc::ShaderState> vpBlurPongShaderState_;
+
+	nctl::UniquePtr<nc::Shader> vpSharpenShader_;
+	/// Only attached to the composite scene sprite when the scene is upscaled and not blurred
+	nctl::UniquePtr<nc::ShaderState> vpSharpenShaderState_;
 
 	nctl::UniquePtr<nc::Shader> vpDispersionShader_;
 	nctl::UniquePtr<nc::Shader> vpBatchedDispersionShader_;
-	nctl::UniquePtr<nc::ShaderState> vpDispersionShaderState_[Cfg::Game::BubblePoolSize];
+	/// One shader state per bubble, it grows together with the bubble pool.
+	/// All states have the same textures and uniform values, the batcher draws bubbles with instancing.
+	nctl::Array<nctl::UniquePtr<nc::ShaderState>> vpDispersionShaderState_;
+	/// The bubble sprite of every dispersion shader state, `nullptr` if the state is not in use
+	nctl::Array<nc::Sprite *> bubbleSprites_;
 
 	nc::SceneNode *updateNode_;
 
 	bool initialize();
 	bool compileShaders();
+	/// Creates the sprites and viewports of the downsampled blur, their targets are assigned by the render graph
+	void createDownsampledBlur();
+	/// Declares the passes of the menu or of the game, and compiles them into the viewport chain
+	void buildRenderGraph(bool paused);
+	/// Declares the blur passes for the current quality and returns the target with the blurred scene
+	RenderGraph::ResourceId addBlurPasses(RenderGraph::ResourceId scene);
+	/// Computes the scene and the blur target sizes from the window resolution, the render scale and the blur quality
+	void updateResolutions();
+	/// Creates the scene texture at the resolution of the current render scale
+	void createSceneTexture();
+	void updateSharpening();
+	/// Applies a change of the blur quality or of the number of passes
+	void onBlurChanged();
+	void attachDispersionShader(unsigned int index);
+	void detachDispersionShader(unsigned int index);
+	void createBubbleAtlas();
+	/// Adds the viewports that are drawn only once at the end of the chain, if they have not been drawn yet
+	void pushOneShotViewports();
 };
@@ -0,0 +1,192 @@
+#include <ncine/config.h>
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	#include <ncine/imgui.h>
+#endif
+
+#include "ShaderWarmUp.h"
+#include "Config.h"
+#include <ncine/Viewport.h>
+#include <ncine/Camera.h>
+#include <ncine/Texture.h>
+#include <ncine/Shader.h>
+#include <ncine/ShaderState.h>
+#include <ncine/Sprite.h>
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS AND DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+ShaderWarmUp::ShaderWarmUp(nc::Texture *texture)
+    : texture_(texture), released_(false), currentPass_(~0u)
+{
+	ASSERT(texture != nullptr);
+	const int size = Cfg::WarmUp::TargetSize;
+	target_ = nctl::makeUnique<nc::Texture>("Shader warm-up", nc::Texture::Format::RGBA8, nc::Vector2i(size, size));
+	camera_ = nctl::makeUnique<nc::Camera>();
+	camera_->setOrthoProjection(0.0f, static_cast<float>(size), 0.0f, static_cast<float>(size));
+}
+
+ShaderWarmUp::~ShaderWarmUp()
+{
+	release();
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+unsigned int ShaderWarmUp::addPass(const char *name, nc::Shader *shader, unsigned int numSprites)
+{
+	ASSERT(released_ == false);
+	ASSERT(shader != nullptr && numSprites > 0);
+	const float size = static_cast<float>(Cfg::WarmUp::TargetSize);
+
+	Pass pass;
+	pass.root = nctl::makeUnique<nc::SceneNode>();
+	pass.viewport = nctl::makeUnique<nc::Viewport>(target_.get());
+	pass.viewport->setRootNode(pass.root.get());
+	pass.viewport->setCamera(camera_.get());
+	pass.viewport->setClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+
+	pass.sprites.setCapacity(numSprites);
+	pass.shaderStates.setCapacity(numSprites);
+	for (unsigned int i = 0; i < numSprites; i++)
+	{
+		// Sprites cover the whole target, so that every program runs its fragment shader
+		nctl::UniquePtr<nc::Sprite> sprite = nctl::makeUnique<nc::Sprite>(pass.root.get(), texture_, size * 0.5f, size * 0.5f);
+		sprite->setSize(nc::Vector2f(size, size));
+		pass.shaderStates.pushBack(nctl::makeUnique<nc::ShaderState>(sprite.get(), shader));
+		pass.sprites.pushBack(nctl::move(sprite));
+	}
+	passes_.pushBack(nctl::move(pass));
+
+	PassTime passTime;
+	passTime.name = name;
+	passTimes_.pushBack(passTime);
+
+	return passes_.size() - 1;
+}
+
+nc::ShaderState &ShaderWarmUp::shaderState(unsigned int pass, unsigned int sprite)
+{
+	ASSERT(pass < passes_.size());
+	ASSERT(sprite < passes_[pass].shaderStates.size());
+	return *passes_[pass].shaderStates[sprite];
+}
+
+int ShaderWarmUp::targetSize() const
+{
+	return Cfg::WarmUp::TargetSize;
+}
+
+void ShaderWarmUp::pushViewports()
+{
+	if (released_)
+		return;
+
+	// The last viewport in the chain is the first one to be drawn
+	nctl::Array<nc::Viewport *> &chain = nc::Viewport::chain();
+	for (int i = static_cast<int>(passes_.size()) - 1; i >= 0; i--)
+	{
+		if (passTimes_[i].drawn == false)
+			chain.pushBack(passes_[i].viewport.get());
+	}
+}
+
+bool ShaderWarmUp::onDrawViewport(const nc::Viewport &viewport)
+{
+	if (released_)
+		return false;
+
+	// Programs are compiled lazily when their first draw is submitted, the next viewport marks the end of it
+	if (currentPass_ < passTimes_.size())
+	{
+		passTimes_[currentPass_].time = passStart_.secondsSince() * 1000.0f;
+		passTimes_[currentPass_].drawn = true;
+		currentPass_ = ~0u;
+	}
+
+	for (unsigned int i = 0; i < passes_.size(); i++)
+	{
+		if (&viewport == passes_[i].viewport.get())
+		{
+			currentPass_ = i;
+			passStart_ = nc::TimeStamp::now();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool ShaderWarmUp::isFinished() const
+{
+	for (const PassTime &passTime : passTimes_)
+	{
+		if (passTime.drawn == false)
+			return false;
+	}
+	return true;
+}
+
+void ShaderWarmUp::release()
+{
+	if (released_)
+		return;
+
+	nctl::Array<nc::Viewport *> &chain = nc::Viewport::chain();
+	for (int i = static_cast<int>(chain.size()) - 1; i >= 0; i--)
+	{
+		for (const Pass &pass : passes_)
+		{
+			if (chain[i] == pass.viewport.get())
+			{
+				chain.removeAt(i);
+				break;
+			}
+		}
+	}
+
+	// Shader states are detached before their sprites are destroyed
+	passes_.clear();
+	camera_.reset(nullptr);
+	target_.reset(nullptr);
+	currentPass_ = ~0u;
+	released_ = true;
+}
+
+const char *ShaderWarmUp::passName(const nc::Viewport &viewport) const
+{
+	for (unsigned int i = 0; i < passes_.size(); i++)
+	{
+		if (&viewport == passes_[i].viewport.get())
+			return passTimes_[i].name;
+	}
+	return nullptr;
+}
+
+float ShaderWarmUp::totalTime() const
+{
+	float time = 0.0f;
+	for (const PassTime &passTime : passTimes_)
+		time += passTime.time;
+	return time;
+}
+
+void ShaderWarmUp::drawGui()
+{
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	if (ImGui::TreeNode("Shader Warm-up"))
+	{
+		ImGui::Text("Total: %.2f ms%s", totalTime(), isFinished() ? "" : " (pending)");
+		for (const PassTime &passTime : passTimes_)
+		{
+			if (passTime.drawn)
+				ImGui::BulletText("%s: %.2f ms", passTime.name, passTime.time);
+			else
+				ImGui::BulletText("%s: pending", passTime.name);
+		}
+		ImGui::TreePop();
+	}
+#endif
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <nctl/Array.h>
+#include <nctl/UniquePtr.h>
+#include <ncine/TimeStamp.h>
+
+namespace ncine {
+	class Viewport;
+	class Camera;
+	class SceneNode;
+	class Texture;
+	class Shader;
+	class ShaderState;
+	class Sprite;
+}
+
+namespace nc = ncine;
+
+/// Draws every shader program once to a small offscreen target, before the first frame that really needs it
+/*! Drivers might defer part of the compilation and of the state setup to the first draw with a program.
+ *  Every program is drawn by its own viewport, so that the time spent submitting each one can be measured. */
+class ShaderWarmUp
+{
+  public:
+	struct PassTime
+	{
+		const char *name = nullptr;
+		/// CPU time between the start of the pass and the start of the next viewport, in milliseconds
+		float time = 0.0f;
+		bool drawn = false;
+	};
+
+	/// The texture is sampled by every sprite, it should outlive the warm-up
+	explicit ShaderWarmUp(nc::Texture *texture);
+	~ShaderWarmUp();
+
+	/// Adds a pass drawing a number of sprites with the shader, more than one can exercise the batched program
+	unsigned int addPass(const char *name, nc::Shader *shader, unsigned int numSprites);
+	/// Returns the shader state of a sprite of a pass, to set the uniforms its program expects
+	nc::ShaderState &shaderState(unsigned int pass, unsigned int sprite);
+	/// Width and height of the offscreen target
+	int targetSize() const;
+
+	/// Adds the viewports of the passes that have not been drawn yet to the chain
+	void pushViewports();
+	/// Measures the passes, it returns true if the viewport belongs to the warm-up
+	bool onDrawViewport(const nc::Viewport &viewport);
+	/// Returns true when every pass has been drawn and measured
+	bool isFinished() const;
+	/// Removes the viewports from the chain and destroys the target, sprites and states, timings are kept
+	void release();
+	inline bool isReleased() const { return released_; }
+
+	/// Returns the name of the pass drawing a viewport, `nullptr` if it does not belong to the warm-up
+	const char *passName(const nc::Viewport &viewport) const;
+	inline unsigned int numPasses() const { return passTimes_.size(); }
+	inline const PassTime &passTime(unsigned int index) const { return passTimes_[index]; }
+	float totalTime() const;
+
+	void drawGui();
+
+  private:
+	struct Pass
+	{
+		nctl::UniquePtr<nc::Viewport> viewport;
+		nctl::UniquePtr<nc::SceneNode> root;
+		nctl::Array<nctl::UniquePtr<nc::Sprite>> sprites;
+		nctl::Array<nctl::UniquePtr<nc::ShaderState>> shaderStates;
+	};
+
+	nc::Texture *texture_;
+	nctl::UniquePtr<nc::Texture> target_;
+	nctl::UniquePtr<nc::Camera> camera_;
+	nctl::Array<Pass> passes_;
+	nctl::Array<PassTime> passTimes_;
+	bool released_;
+
+	/// The pass being measured, the next viewport to be drawn closes it
+	unsigned int currentPass_;
+	nc::TimeStamp passStart_;
+};
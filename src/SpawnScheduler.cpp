@@ -0,0 +1,289 @@
+#include <ncine/config.h>
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	#include <ncine/imgui.h>
+#endif
+
+#include "SpawnScheduler.h"
+#include "GameSnapshot.h"
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS AND DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+SpawnScheduler::SpawnScheduler()
+    : waveIndex_(0), waveTime_(0.0f), rateAccumulator_(0.0f), burstTime_(0.0f), pendingSpawns_(0),
+      area_(0.0f, 0.0f, 0.0f, 0.0f), minDistance_(0.0f), gridWidth_(0), gridHeight_(0), numRejectedSamples_(0)
+{
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void SpawnScheduler::defaultWaves(nctl::Array<SpawnWave> &waves)
+{
+	waves.clear();
+
+	// A steady start, similar to the jam version
+	SpawnWave warmUp;
+	warmUp.duration = 20.0f;
+	warmUp.rate = 4.0f;
+	warmUp.maxAlivePerPlayer = 5;
+	waves.pushBack(warmUp);
+
+	// Some bursts and more of the first two variants
+	SpawnWave bursts;
+	bursts.duration = 20.0f;
+	bursts.rate = 3.0f;
+	bursts.burstSize = 3;
+	bursts.burstInterval = 5.0f;
+	bursts.maxAlivePerPlayer = 7;
+	bursts.variantWeights[0] = 2.0f;
+	bursts.variantWeights[1] = 2.0f;
+	waves.pushBack(bursts);
+
+	// Lasts until the end of the match
+	SpawnWave storm;
+	storm.rate = 5.0f;
+	storm.burstSize = 5;
+	storm.burstInterval = 4.0f;
+	storm.maxAlivePerPlayer = 10;
+	waves.pushBack(storm);
+}
+
+void SpawnScheduler::setWaves(const nctl::Array<SpawnWave> &waves)
+{
+	waves_ = waves;
+	reset();
+}
+
+void SpawnScheduler::reset()
+{
+	waveIndex_ = 0;
+	waveTime_ = 0.0f;
+	rateAccumulator_ = 0.0f;
+	burstTime_ = 0.0f;
+	pendingSpawns_ = 0;
+	numRejectedSamples_ = 0;
+}
+
+void SpawnScheduler::seed(uint64_t initState, uint64_t initSequence)
+{
+	random_.init(initState, initSequence);
+}
+
+void SpawnScheduler::saveSnapshot(SpawnSnapshot &snapshot) const
+{
+	snapshot.waveIndex = waveIndex_;
+	snapshot.waveTime = waveTime_;
+	snapshot.rateAccumulator = rateAccumulator_;
+	snapshot.burstTime = burstTime_;
+	snapshot.pendingSpawns = pendingSpawns_;
+	snapshot.random = random_;
+}
+
+void SpawnScheduler::restoreSnapshot(const SpawnSnapshot &snapshot)
+{
+	ASSERT(waves_.isEmpty() || snapshot.waveIndex < waves_.size());
+	waveIndex_ = snapshot.waveIndex;
+	waveTime_ = snapshot.waveTime;
+	rateAccumulator_ = snapshot.rateAccumulator;
+	burstTime_ = snapshot.burstTime;
+	pendingSpawns_ = snapshot.pendingSpawns;
+	random_ = snapshot.random;
+}
+
+unsigned int SpawnScheduler::update(float deltaTime, unsigned int numAliveBubbles, unsigned int numPlayers)
+{
+	if (waves_.isEmpty())
+		return 0;
+
+	waveTime_ += deltaTime;
+	while (waveIndex_ + 1 < waves_.size() && waveTime_ >= waves_[waveIndex_].duration)
+	{
+		waveTime_ -= waves_[waveIndex_].duration;
+		waveIndex_++;
+		burstTime_ = 0.0f;
+	}
+	const SpawnWave &wave = waves_[waveIndex_];
+
+	// Spawns only depend on the elapsed time, not on the number of frames
+	rateAccumulator_ += wave.rate * deltaTime;
+	const unsigned int numRateSpawns = static_cast<unsigned int>(rateAccumulator_);
+	rateAccumulator_ -= static_cast<float>(numRateSpawns);
+	pendingSpawns_ += numRateSpawns;
+
+	if (wave.burstSize > 0)
+	{
+		burstTime_ += deltaTime;
+		while (burstTime_ >= wave.burstInterval)
+		{
+			burstTime_ -= wave.burstInterval;
+			pendingSpawns_ += wave.burstSize;
+		}
+	}
+
+	// Spawns exceeding the limit are dropped, so that they do not pile up while the screen is full
+	const unsigned int maxAliveBubbles = wave.maxAlivePerPlayer * numPlayers;
+	const unsigned int room = (maxAliveBubbles > numAliveBubbles) ? maxAliveBubbles - numAliveBubbles : 0;
+	const unsigned int numSpawns = (pendingSpawns_ < room) ? pendingSpawns_ : room;
+	pendingSpawns_ = 0;
+
+	return numSpawns;
+}
+
+void SpawnScheduler::postpone(unsigned int numSpawns)
+{
+	pendingSpawns_ += numSpawns;
+}
+
+unsigned int SpawnScheduler::pickVariant()
+{
+	if (waves_.isEmpty())
+		return random_.fastInteger(0, Cfg::Textures::NumBubbleVariants);
+
+	const SpawnWave &wave = waves_[waveIndex_];
+	float weightsSum = 0.0f;
+	for (unsigned int i = 0; i < Cfg::Textures::NumBubbleVariants; i++)
+		weightsSum += wave.variantWeights[i];
+
+	float value = random_.fastReal(0.0f, weightsSum);
+	for (unsigned int i = 0; i < Cfg::Textures::NumBubbleVariants; i++)
+	{
+		if (value < wave.variantWeights[i])
+			return i;
+		value -= wave.variantWeights[i];
+	}
+
+	return Cfg::Textures::NumBubbleVariants - 1;
+}
+
+void SpawnScheduler::setupArea(const nc::Rectf &area, float minDistance)
+{
+	FATAL_ASSERT(minDistance > 0.0f);
+	area_ = area;
+	minDistance_ = minDistance;
+
+	gridWidth_ = static_cast<unsigned int>(ceilf(area_.w / minDistance_));
+	gridHeight_ = static_cast<unsigned int>(ceilf(area_.h / minDistance_));
+	if (gridWidth_ == 0)
+		gridWidth_ = 1;
+	if (gridHeight_ == 0)
+		gridHeight_ = 1;
+
+	grid_.clear();
+	grid_.setCapacity(gridWidth_ * gridHeight_);
+	for (unsigned int i = 0; i < gridWidth_ * gridHeight_; i++)
+		grid_.pushBack(Cell());
+}
+
+void SpawnScheduler::clearGrid()
+{
+	for (Cell &cell : grid_)
+		cell.numPoints = 0;
+}
+
+void SpawnScheduler::addPoint(const nc::Vector2f &position)
+{
+	if (grid_.isEmpty())
+		return;
+
+	// Points just outside the area can still overlap with a bubble spawned on its border
+	int cellX = static_cast<int>(floorf((position.x - area_.x) / minDistance_));
+	int cellY = static_cast<int>(floorf((position.y - area_.y) / minDistance_));
+	if (cellX < -1 || cellX > static_cast<int>(gridWidth_) || cellY < -1 || cellY > static_cast<int>(gridHeight_))
+		return;
+	cellX = (cellX < 0) ? 0 : ((cellX >= static_cast<int>(gridWidth_)) ? gridWidth_ - 1 : cellX);
+	cellY = (cellY < 0) ? 0 : ((cellY >= static_cast<int>(gridHeight_)) ? gridHeight_ - 1 : cellY);
+
+	Cell &cell = grid_[cellY * gridWidth_ + cellX];
+	if (cell.numPoints < Cfg::Spawn::MaxPointsPerCell)
+		cell.points[cell.numPoints++] = position;
+}
+
+bool SpawnScheduler::samplePosition(nc::Vector2f &position)
+{
+	for (unsigned int i = 0; i < Cfg::Spawn::MaxSampleAttempts; i++)
+	{
+		const nc::Vector2f candidate = randomPosition();
+
+		int cellX = 0;
+		int cellY = 0;
+		if (cellCoordinates(candidate, cellX, cellY) && isFarFromNeighbours(candidate, cellX, cellY))
+		{
+			addPoint(candidate);
+			position = candidate;
+			return true;
+		}
+	}
+
+	numRejectedSamples_++;
+	return false;
+}
+
+nc::Vector2f SpawnScheduler::randomPosition()
+{
+	// Two statements, as the evaluation order of the constructor arguments is unspecified
+	const float x = random_.fastReal(area_.x, area_.x + area_.w);
+	const float y = random_.fastReal(area_.y, area_.y + area_.h);
+	return nc::Vector2f(x, y);
+}
+
+void SpawnScheduler::drawGui()
+{
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	if (ImGui::TreeNode("Spawn Scheduler"))
+	{
+		if (waves_.isEmpty() == false)
+		{
+			const SpawnWave &wave = waves_[waveIndex_];
+			ImGui::Text("Wave %u of %u, time: %.1f s", waveIndex_ + 1, waves_.size(), waveTime_);
+			ImGui::Text("Rate: %.1f/s, Burst: %u every %.1f s, Max alive per player: %u",
+			            wave.rate, wave.burstSize, wave.burstInterval, wave.maxAlivePerPlayer);
+		}
+		ImGui::Text("Grid: %u x %u cells of %.1f", gridWidth_, gridHeight_, minDistance_);
+		ImGui::Text("Postponed spawns: %u, Rejected samples: %u", pendingSpawns_, numRejectedSamples_);
+		ImGui::TreePop();
+	}
+#endif
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+bool SpawnScheduler::cellCoordinates(const nc::Vector2f &position, int &cellX, int &cellY) const
+{
+	if (grid_.isEmpty() || position.x < area_.x || position.y < area_.y)
+		return false;
+
+	cellX = static_cast<int>((position.x - area_.x) / minDistance_);
+	cellY = static_cast<int>((position.y - area_.y) / minDistance_);
+	return (cellX < static_cast<int>(gridWidth_) && cellY < static_cast<int>(gridHeight_));
+}
+
+bool SpawnScheduler::isFarFromNeighbours(const nc::Vector2f &position, int cellX, int cellY) const
+{
+	const float sqrMinDistance = minDistance_ * minDistance_;
+
+	for (int y = cellY - 1; y <= cellY + 1; y++)
+	{
+		if (y < 0 || y >= static_cast<int>(gridHeight_))
+			continue;
+
+		for (int x = cellX - 1; x <= cellX + 1; x++)
+		{
+			if (x < 0 || x >= static_cast<int>(gridWidth_))
+				continue;
+
+			const Cell &cell = grid_[y * gridWidth_ + x];
+			for (unsigned int i = 0; i < cell.numPoints; i++)
+			{
+				if ((cell.points[i] - position).sqrLength() < sqrMinDistance)
+					return false;
+			}
+		}
+	}
+
+	return true;
+}
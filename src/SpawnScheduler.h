@@ -0,0 +1,80 @@
+#pragma once
+
+#include <nctl/Array.h>
+#include <ncine/Rect.h>
+#include <ncine/Vector2.h>
+#include <ncine/Random.h>
+#include "SpawnWave.h"
+
+namespace nc = ncine;
+
+struct SpawnSnapshot;
+
+/// Decides when and where bubbles are spawned, following a list of time-based waves
+/*! Spawn positions are chosen by rejection sampling against a uniform grid, so that new bubbles do not overlap. */
+class SpawnScheduler
+{
+  public:
+	SpawnScheduler();
+
+	/// Fills the array with the waves used when the spawn waves file is missing
+	static void defaultWaves(nctl::Array<SpawnWave> &waves);
+
+	void setWaves(const nctl::Array<SpawnWave> &waves);
+	/// Restarts from the first wave
+	void reset();
+	/// Seeds the generator used for spawn positions and variants, the same seed leads to the same spawns
+	void seed(uint64_t initState, uint64_t initSequence);
+
+	void saveSnapshot(SpawnSnapshot &snapshot) const;
+	void restoreSnapshot(const SpawnSnapshot &snapshot);
+
+	/// Advances the schedule and returns how many bubbles should be spawned now
+	unsigned int update(float deltaTime, unsigned int numAliveBubbles, unsigned int numPlayers);
+	/// Spawns that could not find a free position are retried on the next update
+	void postpone(unsigned int numSpawns);
+	unsigned int pickVariant();
+
+	void setupArea(const nc::Rectf &area, float minDistance);
+	/// Empties the sampling grid, to be filled again with the positions of the alive bubbles
+	void clearGrid();
+	/// Adds a position to the sampling grid, positions far from the spawn area are ignored
+	void addPoint(const nc::Vector2f &position);
+	/// Looks for a position far enough from every point in the grid, and adds it to the grid when found
+	bool samplePosition(nc::Vector2f &position);
+	/// Returns a position inside the spawn area without checking for overlaps
+	nc::Vector2f randomPosition();
+
+	inline unsigned int waveIndex() const { return waveIndex_; }
+	inline unsigned int numWaves() const { return waves_.size(); }
+
+	void drawGui();
+
+  private:
+	struct Cell
+	{
+		nc::Vector2f points[Cfg::Spawn::MaxPointsPerCell];
+		unsigned int numPoints = 0;
+	};
+
+	nctl::Array<SpawnWave> waves_;
+	unsigned int waveIndex_;
+	float waveTime_;
+	float rateAccumulator_;
+	float burstTime_;
+	unsigned int pendingSpawns_;
+	/// Not the global generator, so that its state can be part of a snapshot
+	nc::Random random_;
+
+	nc::Rectf area_;
+	float minDistance_;
+	/// The cell side is equal to the minimum distance, so only the 3x3 neighbourhood has to be checked
+	unsigned int gridWidth_;
+	unsigned int gridHeight_;
+	nctl::Array<Cell> grid_;
+
+	unsigned int numRejectedSamples_;
+
+	bool cellCoordinates(const nc::Vector2f &position, int &cellX, int &cellY) const;
+	bool isFarFromNeighbours(const nc::Vector2f &position, int cellX, int cellY) const;
+};
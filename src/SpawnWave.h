@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Config.h"
+
+/// The description of a bubble wave, loaded from the spawn waves file
+struct SpawnWave
+{
+	/// Wave duration in seconds, the last wave always lasts until the end of the match
+	float duration = 0.0f;
+	/// Bubbles per second that are spawned continuously
+	float rate = 4.0f;
+	/// Bubbles spawned at once every `burstInterval` seconds, zero to disable bursts
+	unsigned int burstSize = 0;
+	float burstInterval = 0.0f;
+	/// The maximum number of alive bubbles for each player
+	unsigned int maxAlivePerPlayer = Cfg::Game::NumBubbleForSpawnPerPlayer;
+	/// Relative probabilities of every bubble variant
+	float variantWeights[Cfg::Textures::NumBubbleVariants] = { 1.0f, 1.0f, 1.0f, 1.0f };
+};
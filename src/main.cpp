@@ -10,12 +10,21 @@
 #include "Config.h"
 #include "ResourceManager.h"
 #include "InputActions.h"
+#include "InputBinder.h"
 #include "Serializer.h"
 #include "MusicManager.h"
 #include "ShaderEffects.h"
+#include "FrameProfiler.h"
+#include "GpuProfiler.h"
+#include "QualityScaler.h"
+#include "JobSystem.h"
+#include "Benchmark.h"
+#include "RollbackSession.h"
+#include "ArenaBatch.h"
 #include "nodes/SplashScreen.h"
 #include "nodes/Menu.h"
 #include "nodes/Game.h"
+#include "nodes/FrameStatsOverlay.h"
 
 #include <ncine/ILogger.h>
 #include <ncine/Application.h>
@@ -60,6 +69,15 @@ void MyEventHandler::onPreInit(nc::AppConfiguration &config)
 
 	Serializer::loadSettings(settings_);
 	Serializer::loadStatistics(statistics_);
+	benchmarkRequested_ = Benchmark::isRequested(config);
+	numRequestedArenas_ = ArenaBatch::requestedArenas(config);
+	NetplayConfig netplayConfig;
+	if (benchmarkRequested_ == false && RollbackSession::parseArguments(config, netplayConfig))
+		netplayConfig_ = nctl::makeUnique<NetplayConfig>(netplayConfig);
+
+	// Linked programs are stored per driver and reused on the next launches, a stale binary is compiled again
+	config.useBinaryShaderCache = true;
+	config.shaderCacheDirname = Cfg::ShaderCacheDirname;
 
 	config.windowTitle = "Wet Paper";
 	config.windowIconFilename = "icon48.png";
@@ -88,10 +106,47 @@ void MyEventHandler::onInit()
 
 	musicManager_ = nctl::makeUnique<MusicManager>(this);
 	shaderEffects_ = nctl::makeUnique<ShaderEffects>();
+	shaderEffects_->setBlurQuality(static_cast<ShaderEffects::BlurQuality>(settings_.blurQuality));
+	shaderEffects_->setRenderScale(settings_.renderScale);
+	shaderEffects_->setSharpenUpscale(settings_.sharpenUpscale);
+	// Programs are drawn once while the splash screen is shown
+	shaderEffects_->warmUpShaders();
+	gpuProfiler_ = nctl::makeUnique<GpuProfiler>();
+	qualityScaler_ = nctl::makeUnique<QualityScaler>(this);
+	qualityScaler_->setEnabled(settings_.autoQuality);
 	nc::SceneNode &rootNode = nc::theApplication().rootNode();
+	frameStatsOverlay_ = nctl::makeUnique<FrameStatsOverlay>(&rootNode, "FRAMESTATS");
+
+	if (numRequestedArenas_ > 0)
+	{
+		// The headless simulator does not need any scene, it quits as soon as the measures are done
+		ArenaBatch::measureThroughput(numRequestedArenas_);
+		nc::theApplication().quit();
+		return;
+	}
+
+	if (benchmarkRequested_)
+	{
+		// The benchmark skips both the splash screen and the menu
+		nc::theApplication().setAutoSuspension(false);
+		benchmark_ = nctl::makeUnique<Benchmark>(this);
+		benchmark_->applySettings();
+		showGame();
+		game_->setBenchmarkMode(true);
+		return;
+	}
+
+	if (netplayConfig_ != nullptr)
+	{
+		// A network match also skips the splash screen and the menu, both peers have to be started at once
+		nc::theApplication().setAutoSuspension(false);
+		showGame();
+		game_->startNetplay(*netplayConfig_);
+		return;
+	}
+
 #ifdef NCPROJECT_DEBUG
-	menu_ = nctl::makeUnique<Menu>(&rootNode, "MENU", this);
-	musicManager_->goToMainMenu();
+	showMenu();
 #else
 	splashScreen_ = nctl::makeUnique<SplashScreen>(&rootNode, "SPLASHSCREEN", this);
 #endif
@@ -99,8 +154,12 @@ void MyEventHandler::onInit()
 
 void MyEventHandler::onShutdown()
 {
+	// Query objects are deleted while the OpenGL context is still current
+	gpuProfiler_.reset(nullptr);
 	resourceManager().releaseAll();
 
+	if (benchmark_ != nullptr)
+		benchmark_->restoreSettings();
 	settings_.windowState.x = nc::theApplication().gfxDevice().windowPositionX();
 	settings_.windowState.y = nc::theApplication().gfxDevice().windowPositionY();
 	settings_.windowState.w = nc::theApplication().gfxDevice().resolution().x;
@@ -111,11 +170,20 @@ void MyEventHandler::onShutdown()
 
 void MyEventHandler::onFrameStart()
 {
-	if (menu_ != nullptr)
+	FrameProfiler &profiler = frameProfiler();
+	profiler.onFrameStart();
+	profiler.beginZone(FrameProfiler::Zone::FRAME_START);
+	gpuProfiler_->onFrameStart();
+	qualityScaler_->onFrameStart();
+
+	if (currentScene_ == Scene::MENU)
 		menu_->onFrameStart();
-	else if (game_ != nullptr)
+	else if (currentScene_ == Scene::GAME)
 		game_->onFrameStart();
 
+	if (benchmark_ != nullptr && currentScene_ == Scene::GAME)
+		benchmark_->onFrameStart(*game_);
+
 	if (requestMenuTransition_)
 	{
 		showMenu();
@@ -124,10 +192,15 @@ void MyEventHandler::onFrameStart()
 	else if (requestGameTransition_)
 	{
 		showGame();
+		if (requestAttractMode_)
+			game_->setAttractMode(true);
 		requestGameTransition_ = false;
+		requestAttractMode_ = false;
 	}
 
 	musicManager_->onFrameStart();
+	shaderEffects_->onFrameStart();
+	frameStatsOverlay_->followScreenViewport();
 
 #if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
 	if (showInterface)
@@ -148,66 +221,93 @@ void MyEventHandler::onFrameStart()
 
 			const float deltaTime = nc::theApplication().frameTime();
 			ImGui::Text("Delta time: %0.3f ms (%0.1f FPS)", deltaTime * 1000.0f, 1.0f / deltaTime);
+			profiler.drawGui();
+			gpuProfiler_->drawGui();
+			qualityScaler_->drawGui();
+			jobSystem().drawGui();
 			ImGui::Separator();
 
 			if (splashScreen_ != nullptr)
 				splashScreen_->drawGui();
+			if (benchmark_ != nullptr)
+				benchmark_->drawGui();
 			musicManager_->drawGui();
-			if (menu_ != nullptr)
+			shaderEffects_->drawGui();
+			if (currentScene_ == Scene::MENU)
 				menu_->drawGui();
-			if (game_ != nullptr)
+			else if (currentScene_ == Scene::GAME)
 				game_->drawGui();
 		}
 		ImGui::End();
 	}
 #endif
+
+	profiler.endZone(FrameProfiler::Zone::FRAME_START);
 }
 
 void MyEventHandler::onDrawViewport(nc::Viewport &viewport)
 {
+	gpuProfiler_->beginPass(shaderEffects_->viewportName(viewport));
 	shaderEffects_->onDrawViewport(viewport);
 }
 
+void MyEventHandler::onResizeWindow(int width, int height)
+{
+	shaderEffects_->invalidateBlurCache();
+}
+
 void MyEventHandler::onChangeScalingFactor(float factor)
 {
 	if (menu_ != nullptr)
 		menu_->setScale(factor);
 	if (game_ != nullptr)
 		game_->setScale(factor);
+	shaderEffects_->invalidateBlurCache();
 }
 
 void MyEventHandler::onKeyReleased(const nc::KeyboardEvent &event)
 {
 	if (event.mod & nc::KeyMod::CTRL && event.sym == nc::KeySym::H)
 		showInterface = !showInterface;
+	else if (event.mod & nc::KeyMod::CTRL && event.sym == nc::KeySym::F)
+		frameStatsOverlay_->toggle();
 	else if (event.mod & nc::KeyMod::CTRL && event.sym == nc::KeySym::Q)
 		nc::theApplication().quit();
 }
 
 void MyEventHandler::onKeyPressed(const nc::KeyboardEvent &event)
 {
-	if (menu_ != nullptr)
+	if (currentScene_ == Scene::MENU)
 		menu_->onKeyPressed(event);
+	else if (currentScene_ == Scene::GAME && game_->isAttractMode())
+		requestMenu();
 }
 
 void MyEventHandler::onJoyMappedButtonPressed(const nc::JoyMappedButtonEvent &event)
 {
-	if (menu_ != nullptr)
+	if (currentScene_ == Scene::MENU)
 		menu_->onJoyMappedButtonPressed(event);
+	else if (currentScene_ == Scene::GAME && game_->isAttractMode())
+		requestMenu();
 }
 
 void MyEventHandler::onJoyMappedAxisMoved(const nc::JoyMappedAxisEvent &event)
 {
-	if (menu_ != nullptr)
+	if (currentScene_ == Scene::MENU)
 		menu_->onJoyMappedAxisMoved(event);
+	else if (currentScene_ == Scene::GAME && game_->isAttractMode() &&
+	         (event.value >= InputBinder::PressedAxisThreshold || event.value <= -InputBinder::PressedAxisThreshold))
+	{
+		requestMenu();
+	}
 }
 
 bool MyEventHandler::onQuitRequest()
 {
 #ifndef NCPROJECT_DEBUG
-	if (menu_)
+	if (currentScene_ == Scene::MENU)
 		menu_->onQuitRequest();
-	else if (game_)
+	else if (currentScene_ == Scene::GAME)
 		game_->onQuitRequest();
 
 	return false;
@@ -226,6 +326,16 @@ ShaderEffects &MyEventHandler::shaderEffects()
 	return *shaderEffects_;
 }
 
+GpuProfiler &MyEventHandler::gpuProfiler()
+{
+	return *gpuProfiler_;
+}
+
+QualityScaler &MyEventHandler::qualityScaler()
+{
+	return *qualityScaler_;
+}
+
 void MyEventHandler::requestMenu()
 {
 	requestMenuTransition_ = true;
@@ -236,6 +346,25 @@ void MyEventHandler::requestGame()
 	requestGameTransition_ = true;
 }
 
+void MyEventHandler::requestAttractMode()
+{
+	requestGameTransition_ = true;
+	requestAttractMode_ = true;
+}
+
+bool MyEventHandler::withShaders() const
+{
+	return settings_.withShaders && qualityScaler_->allowsShaders();
+}
+
+void MyEventHandler::requestShaderEffectsChange()
+{
+	if (currentScene_ == Scene::MENU)
+		menu_->requestShaderEffectsChange();
+	else if (currentScene_ == Scene::GAME)
+		game_->requestShaderEffectsChange();
+}
+
 const Settings &MyEventHandler::settings() const
 {
 	return settings_;
@@ -262,19 +391,51 @@ Statistics &MyEventHandler::statisticsMut()
 
 void MyEventHandler::showGame()
 {
-	menu_.reset(nullptr);
+	if (menu_ != nullptr)
+		menu_->setActive(false);
 
-	nc::SceneNode &rootNode = nc::theApplication().rootNode();
-	game_ = nctl::makeUnique<Game>(&rootNode, "GAME", this);
+	if (game_ == nullptr)
+	{
+		nc::SceneNode &rootNode = nc::theApplication().rootNode();
+		game_ = nctl::makeUnique<Game>(&rootNode, "GAME", this);
+	}
+	else
+	{
+		// The settings might have changed since the game was created
+		game_->reset();
+		game_->setActive(true);
+	}
+
+	currentScene_ = Scene::GAME;
 	musicManager_->goToGame();
 }
 
 void MyEventHandler::showMenu()
 {
 	splashScreen_.reset(nullptr);
-	game_.reset(nullptr);
+	if (game_ != nullptr)
+		game_->setActive(false);
+
+	// Leaving the game interrupts a running benchmark
+	if (benchmark_ != nullptr)
+	{
+		benchmark_->restoreSettings();
+		benchmark_.reset(nullptr);
+	}
 
 	nc::SceneNode &rootNode = nc::theApplication().rootNode();
-	menu_ = nctl::makeUnique<Menu>(&rootNode, "MENU", this);
+	if (menu_ == nullptr)
+		menu_ = nctl::makeUnique<Menu>(&rootNode, "MENU", this);
+	else
+		menu_->setActive(true);
+
+	// The game is created while the menu is shown, so that starting a match does not load anything
+	if (game_ == nullptr)
+	{
+		game_ = nctl::makeUnique<Game>(&rootNode, "GAME", this);
+		game_->setActive(false);
+	}
+
+	currentScene_ = Scene::MENU;
 	musicManager_->goToMainMenu();
 }
@@ -16,6 +16,11 @@ class ShaderEffects;
 class SplashScreen;
 class Menu;
 class Game;
+class FrameStatsOverlay;
+class Benchmark;
+struct NetplayConfig;
+class GpuProfiler;
+class QualityScaler;
 
 namespace nc = ncine;
 
@@ -30,6 +35,7 @@ class MyEventHandler :
 	void onShutdown() override;
 	void onFrameStart() override;
 	void onDrawViewport(nc::Viewport &viewport) override;
+	void onResizeWindow(int width, int height) override;
 	void onChangeScalingFactor(float factor) override;
 
 	void onKeyReleased(const nc::KeyboardEvent &event) override;
@@ -41,8 +47,16 @@ class MyEventHandler :
 
 	MusicManager &musicManager();
 	ShaderEffects &shaderEffects();
+	GpuProfiler &gpuProfiler();
+	QualityScaler &qualityScaler();
 	void requestMenu();
 	void requestGame();
+	/// Shows the game with two bots playing, any input goes back to the menu
+	void requestAttractMode();
+	/// Returns true if shaders are enabled in the settings and allowed by the quality scaler
+	bool withShaders() const;
+	/// Asks the current scene to enable or disable shader effects on the next frame
+	void requestShaderEffectsChange();
 
 	const Settings &settings() const;
 	const Statistics &statistics() const;
@@ -50,17 +64,36 @@ class MyEventHandler :
 	Statistics &statisticsMut();
 
   private:
+	enum class Scene
+	{
+		SPLASH_SCREEN,
+		MENU,
+		GAME
+	};
+
+	/// Menu and game are kept resident once created, only one of them is active
+	Scene currentScene_ = Scene::SPLASH_SCREEN;
 	bool requestMenuTransition_ = false;
 	bool requestGameTransition_ = false;
+	bool requestAttractMode_ = false;
+	bool benchmarkRequested_ = false;
+	/// Arenas of the headless simulator throughput test, zero if it has not been requested
+	unsigned int numRequestedArenas_ = 0;
 
 	void showMenu();
 	void showGame();
 
 	nctl::UniquePtr<MusicManager> musicManager_;
 	nctl::UniquePtr<ShaderEffects> shaderEffects_;
+	nctl::UniquePtr<GpuProfiler> gpuProfiler_;
+	nctl::UniquePtr<QualityScaler> qualityScaler_;
 	nctl::UniquePtr<SplashScreen> splashScreen_;
 	nctl::UniquePtr<Menu> menu_;
 	nctl::UniquePtr<Game> game_;
+	nctl::UniquePtr<FrameStatsOverlay> frameStatsOverlay_;
+	nctl::UniquePtr<Benchmark> benchmark_;
+	/// Set when a network match has been requested on the command line
+	nctl::UniquePtr<NetplayConfig> netplayConfig_;
 
 	Settings settings_;
 	Statistics statistics_;
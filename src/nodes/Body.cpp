@@ -3,8 +3,8 @@
 #include "../Config.h"
 
 // All the bubbles plus the two players and the three obstacles
-nctl::Array<Body *> Body::All(Cfg::Game::BubblePoolSize + 5);
-nctl::Array<CollisionPair> Body::Collisions(Cfg::Game::BubblePoolSize + 5);
+nctl::Array<Body *> Body::All(Cfg::Game::BubblePoolChunkSize + 5);
+nctl::Array<CollisionPair> Body::Collisions(Cfg::Game::BubblePoolChunkSize + 5);
 
 ///////////////////////////////////////////////////////////
 // CONSTRUCTORS AND DESTRUCTOR
@@ -15,9 +15,9 @@ Body::Body(SceneNode *parent, nctl::String name, ColliderKind collKind, BodyKind
       linearVelocity_(nc::Vector2f::Zero), linearVelocityDamping_(Cfg::Physics::LinearVelocityDamping),
       maxVelocity_(Cfg::Physics::PlayerMaxVelocity), gravity_(Cfg::Physics::Gravity),
       colliderHalfSize_(Cfg::Physics::ColliderHalfSize),
-      bodyId_(bodyId), bodyKind_(kind), colliderKind_(collKind)
+      bodyId_(bodyId), bodyKind_(kind), colliderKind_(collKind), allIndex_(InvalidIndex)
 {
-	All.pushBack(this);
+	addToAll();
 }
 
 Body::~Body()
@@ -106,18 +106,22 @@ void Body::integrate(float dT)
 	if (bodyKind_ == BodyKind::STATIC)
 		return;
 
-	linearVelocity_ += gravity_ * dT;
-	position_ += linearVelocity_ * dT;
+	integrate(position_, linearVelocity_, gravity_, linearVelocityDamping_, maxVelocity_, dT);
+	setPosition(position_);
+}
+
+void Body::integrate(nc::Vector2f &position, nc::Vector2f &velocity, const nc::Vector2f &gravity, float damping, float maxVelocity, float dT)
+{
+	velocity += gravity * dT;
+	position += velocity * dT;
 
 	// Apply damping
-	if (linearVelocityDamping_ < 1.0f)
-		linearVelocity_ *= powf(linearVelocityDamping_, dT);
+	if (damping < 1.0f)
+		velocity *= powf(damping, dT);
 
 	// Limit maximum velocity
-	if (linearVelocity_.sqrLength() > (maxVelocity_ * maxVelocity_))
-		linearVelocity_ = linearVelocity_.normalized() * maxVelocity_;
-
-	setPosition(position_);
+	if (velocity.sqrLength() > (maxVelocity * maxVelocity))
+		velocity = velocity.normalized() * maxVelocity;
 }
 
 bool Body::isGrounded()
@@ -140,16 +144,25 @@ bool Body::isGrounded()
 	return false;
 }
 
+void Body::addToAll()
+{
+	if (isInAll())
+		return;
+
+	allIndex_ = All.size();
+	All.pushBack(this);
+}
+
 void Body::removeFromAll()
 {
-	for (unsigned int i = 0; i < Body::All.size(); i++)
+	if (isInAll())
 	{
-		if (Body::All[i] == this)
-		{
-			Body::All.unorderedRemoveAt(i);
-			break;
-		}
+		Body *lastBody = All.back();
+		All[allIndex_] = lastBody;
+		lastBody->allIndex_ = allIndex_;
+		All.popBack();
 	}
+	allIndex_ = InvalidIndex;
 }
 
 void Body::drawGui()
@@ -163,18 +176,26 @@ void Body::drawGui()
 
 // ------------------------------------------------------------------------------------------------
 
-void Body::circleVsCircleCollision(Body *bodyA, Body *bodyB)
+bool Body::circleVsCircleContact(const Body &bodyA, const Body &bodyB, nc::Vector2f &normal, float &penetrationAmount)
 {
-	ASSERT(bodyA->colliderKind_ == ColliderKind::CIRCLE);
-	ASSERT(bodyB->colliderKind_ == ColliderKind::CIRCLE);
+	ASSERT(bodyA.colliderKind_ == ColliderKind::CIRCLE);
+	ASSERT(bodyB.colliderKind_ == ColliderKind::CIRCLE);
 
-	const nc::Vector2f posA = bodyA->position();
-	const nc::Vector2f posB = bodyB->position();
+	return circleVsCircleContact(bodyA.position(), bodyA.colliderHalfSize_.x, bodyB.position(), bodyB.colliderHalfSize_.x, normal, penetrationAmount);
+}
 
-	const float radiusA = bodyA->colliderHalfSize_.x;
-	const float radiusB = bodyB->colliderHalfSize_.x;
+bool Body::circleVsAabbContact(const Body &bodyA, const Body &bodyB, nc::Vector2f &normal, float &penetrationAmount)
+{
+	ASSERT(bodyA.colliderKind_ == ColliderKind::CIRCLE);
+	ASSERT(bodyB.colliderKind_ == ColliderKind::AABB);
 
-	nc::Vector2f aToB = posA - posB;
+	return circleVsAabbContact(bodyA.position(), bodyA.colliderHalfSize_.x, bodyB.position(), bodyB.colliderHalfSize_, normal, penetrationAmount);
+}
+
+bool Body::circleVsCircleContact(const nc::Vector2f &posA, float radiusA, const nc::Vector2f &posB, float radiusB,
+                                 nc::Vector2f &normal, float &penetrationAmount)
+{
+	const nc::Vector2f aToB = posA - posB;
 	const float dist2 = aToB.sqrLength();
 
 	// Do they overlap?
@@ -183,64 +204,28 @@ void Body::circleVsCircleCollision(Body *bodyA, Body *bodyB)
 	const float minDist2 = minDist * minDist;
 
 	if (dist2 >= minDist2)
-		return; // not overlapping
-
-	// We want a deterministic order
-	if (bodyA > bodyB)
-	{
-		Body *tmp = bodyA;
-		bodyA = bodyB;
-		bodyB = tmp;
+		return false; // not overlapping
 
-		aToB = aToB * -1.0f;
-	}
-
-	// Add to collision pairs
-	{
-		const CollisionPair pair = { bodyA, bodyB, aToB.normalized() };
-
-		for (const CollisionPair &it : Body::Collisions)
-		{
-			if (it.a == pair.a && it.b == pair.b)
-				return; // avoid duplicates
-		}
-
-		Body::Collisions.pushBack(pair);
-	}
-
-	const float penetrationAmount = minDist - sqrtf(dist2);
-
-	aToB.normalize();
-
-	const float factor = (bodyA && bodyB) ? 0.5f : 1.0f;
-	if (bodyA)
-		bodyA->move(aToB * (penetrationAmount * factor));
-
-	if (bodyB)
-		bodyB->move(aToB * (-penetrationAmount * factor));
+	normal = aToB.normalized();
+	penetrationAmount = minDist - sqrtf(dist2);
+	return true;
 }
 
-void Body::circleVsAabbCollision(Body *bodyA, Body *bodyB)
+bool Body::circleVsAabbContact(const nc::Vector2f &circlePos, float radius, const nc::Vector2f &boxPos, const nc::Vector2f &boxHalfSize,
+                               nc::Vector2f &normal, float &penetrationAmount)
 {
-	ASSERT(bodyA->colliderKind_ == ColliderKind::CIRCLE);
-	ASSERT(bodyB->colliderKind_ == ColliderKind::AABB);
-
-	const float radiusA = bodyA->colliderHalfSize_.x;
-	nc::Vector2f posA = bodyA->position();
-	nc::Vector2f posB = bodyB->position();
-
-	const float rectHalfW = bodyB->colliderHalfSize_.x;
-	const float rectHalfH = bodyB->colliderHalfSize_.y;
+	const float rectHalfW = boxHalfSize.x;
+	const float rectHalfH = boxHalfSize.y;
 
 	// Can we exclude this contact?
-	const float circleRadius = radiusA;
+	const float circleRadius = radius;
 
-	const nc::Vector2f circleRelPos = posA - posB;
+	const nc::Vector2f circleRelPos = circlePos - boxPos;
 
 	if ((fabsf(circleRelPos.x) - circleRadius) > rectHalfW ||
 	    (fabsf(circleRelPos.y) - circleRadius) > rectHalfH)
 	{
-		return; // no collision
+		return false; // no collision
 	}
 
 	nc::Vector2f contactNormal = nc::Vector2f::Zero;
@@ -274,30 +259,11 @@ void Body::circleVsAabbCollision(Body *bodyA, Body *bodyB)
 	const float closestPointToCircleRelPosSquared = (closestPoint - circleRelPos).sqrLength();
 	if (closestPointToCircleRelPosSquared >= circleRadius * circleRadius)
 	{
-		return; // no collision
+		return false; // no collision
 	}
 
-	// Add to collision pairs
-	{
-		const CollisionPair pair = { bodyA, bodyB, contactNormal };
-
-		for (const CollisionPair &it : Body::Collisions)
-		{
-			if (it.a == pair.a && it.b == pair.b)
-				return; // avoid duplicates
-		}
-
-		Body::Collisions.pushBack(pair);
-	}
-
-	// Collision resolution
-	const float penetrationAmount = circleRadius - sqrtf(closestPointToCircleRelPosSquared);
+	normal = contactNormal;
+	penetrationAmount = circleRadius - sqrtf(closestPointToCircleRelPosSquared);
 	ASSERT(penetrationAmount > 0.0f);
-
-	const float factor = (bodyA->bodyKind_ == BodyKind::DYNAMIC && bodyB->bodyKind_ == BodyKind::DYNAMIC) ? 0.5f : 1.0f;
-	if (bodyA->bodyKind_ == BodyKind::DYNAMIC)
-		bodyA->move(contactNormal * (penetrationAmount * factor));
-
-	if (bodyB->bodyKind_ == BodyKind::DYNAMIC)
-		bodyB->move(contactNormal * (-penetrationAmount * factor));
+	return true;
 }
@@ -59,17 +59,38 @@ class Body : public LogicNode
 
 	void onPostTick(nc::RenderQueue &renderQueue, unsigned int &visitOrderIndex) override;
 	void integrate(float dT);
+	/// The integration of a dynamic body on plain values, for the headless arenas that have no body nodes
+	static void integrate(nc::Vector2f &position, nc::Vector2f &velocity, const nc::Vector2f &gravity, float damping, float maxVelocity, float dT);
 
 	bool isGrounded();
+	/// Adds the body to `All`, remembering its position for a constant time removal
+	void addToAll();
 	void removeFromAll();
+	/// Returns the position inside `All`, or `~0u` if the body is not there
+	inline unsigned int allIndex() const { return isInAll() ? allIndex_ : InvalidIndex; }
 
 	void drawGui();
 
-	static void circleVsCircleCollision(Body *bodyA, Body *bodyB);
-	static void circleVsAabbCollision(Body *bodyA, Body *bodyB);
+	/// Returns true if the circles overlap, the normal goes from the second body to the first one
+	/*! The bodies are only read, contacts can be detected in parallel and resolved later by the contact solver */
+	static bool circleVsCircleContact(const Body &bodyA, const Body &bodyB, nc::Vector2f &normal, float &penetrationAmount);
+	/// Returns true if the circle overlaps the box, the normal goes from the box to the circle
+	static bool circleVsAabbContact(const Body &bodyA, const Body &bodyB, nc::Vector2f &normal, float &penetrationAmount);
+	/// The same tests on plain values, for the headless arenas that have no body nodes
+	static bool circleVsCircleContact(const nc::Vector2f &posA, float radiusA, const nc::Vector2f &posB, float radiusB,
+	                                  nc::Vector2f &normal, float &penetrationAmount);
+	static bool circleVsAabbContact(const nc::Vector2f &circlePos, float radius, const nc::Vector2f &boxPos, const nc::Vector2f &boxHalfSize,
+	                                nc::Vector2f &normal, float &penetrationAmount);
 
   private:
+	static const unsigned int InvalidIndex = ~0u;
+
 	int bodyId_;
 	BodyKind bodyKind_;
 	ColliderKind colliderKind_;
+	/// Position inside `All`, or `InvalidIndex`
+	unsigned int allIndex_;
+
+	/// The index is stale if `All` has been cleared in the meantime
+	inline bool isInAll() const { return allIndex_ < All.size() && All[allIndex_] == this; }
 };
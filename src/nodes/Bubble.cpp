@@ -15,17 +15,17 @@
 // CONSTRUCTORS AND DESTRUCTOR
 ///////////////////////////////////////////////////////////
 
-Bubble::Bubble(nc::SceneNode *parent, nctl::String name, nc::Vector2f pos, unsigned int variant)
-    : LogicNode(parent, name), variant_(variant)
+Bubble::Bubble(nc::SceneNode *parent, nctl::String name, nc::Vector2f pos, unsigned int variant, unsigned int poolIndex)
+    : LogicNode(parent, name), variant_(variant), poolIndex_(poolIndex), aliveIndex_(0), alive_(false), grounded_(false)
 {
 	// Setup the physics body
 	{
 		body_ = nctl::makeUnique<Body>(this, "Body", ColliderKind::CIRCLE, BodyKind::DYNAMIC, BodyId::BUBBLE);
 		body_->setPosition(pos);
-		body_->linearVelocityDamping_ = 1.0f;
+		body_->linearVelocityDamping_ = Cfg::Physics::BubbleDamping;
 		body_->maxVelocity_ = Cfg::Physics::BubbleMaxVelocity;
 		body_->colliderHalfSize_.set(64.0f, 0.0f);
-		body_->gravity_.set(0.0f, -100.0f);
+		body_->gravity_ = Cfg::Physics::BubbleGravity;
 	}
 
 	// Setup the sprite
@@ -49,11 +49,15 @@ Bubble::Bubble(nc::SceneNode *parent, nctl::String name, nc::Vector2f pos, unsig
 // PUBLIC FUNCTIONS
 ///////////////////////////////////////////////////////////
 
-void Bubble::onTick(float deltaTime)
+void Bubble::checkGrounded()
 {
-	if (body_->isGrounded())
+	grounded_ = alive_ && body_->isGrounded();
+}
+
+void Bubble::simulate()
+{
+	if (alive_ && grounded_)
 	{
-		LOGI("Bubble touched ground");
 		Game::killBubble(this);
 		Game::incrementDroppedBubble();
 		Game::playSound();
@@ -62,7 +66,6 @@ void Bubble::onTick(float deltaTime)
 
 void Bubble::touched()
 {
-	LOGI("Touched");
 	Game::killBubble(this);
 	Game::playSound();
 }
@@ -78,12 +81,14 @@ void Bubble::drawGui(unsigned int index)
 void Bubble::onSpawn()
 {
 	setEnabled(true);
-	Body::All.pushBack(body_.get());
+	alive_ = true;
+	body_->addToAll();
 }
 
 void Bubble::onKilled()
 {
 	setEnabled(false);
+	alive_ = false;
 	body_->removeFromAll();
 }
 
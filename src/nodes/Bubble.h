@@ -12,9 +12,12 @@ namespace nc = ncine;
 class Bubble : public LogicNode
 {
   public:
-	Bubble(nc::SceneNode *parent, nctl::String name, nc::Vector2f pos, unsigned int variant);
+	Bubble(nc::SceneNode *parent, nctl::String name, nc::Vector2f pos, unsigned int variant, unsigned int poolIndex);
 
-	void onTick(float deltaTime) override;
+	/// Looks for a contact with the ground, it only writes to this bubble and can run in parallel with the others
+	void checkGrounded();
+	/// Kills the bubble when it has reached the ground, called by the game after the players have been simulated
+	void simulate();
 	void touched();
 	void drawGui(unsigned int index);
 
@@ -22,11 +25,23 @@ class Bubble : public LogicNode
 	void onKilled();
 
 	unsigned int variant() const;
+	/// Only changes the variant index, the texture is changed by the caller
+	inline void setVariant(unsigned int variant) { variant_ = variant; }
+	/// The index of the bubble inside the pool, it never changes
+	inline unsigned int poolIndex() const { return poolIndex_; }
+	/// The position of the bubble in the list of alive ones, only meaningful while alive
+	inline unsigned int aliveIndex() const { return aliveIndex_; }
+	inline void setAliveIndex(unsigned int aliveIndex) { aliveIndex_ = aliveIndex; }
+	inline bool isAlive() const { return alive_; }
 	Body *body();
 	nc::Sprite *sprite();
 
   private:
 	unsigned int variant_;
+	unsigned int poolIndex_;
+	unsigned int aliveIndex_;
+	bool alive_;
+	bool grounded_;
 	nctl::UniquePtr<Body> body_;
 	nctl::UniquePtr<nc::Sprite> sprite_;
 };
@@ -0,0 +1,82 @@
+#include "FrameStatsOverlay.h"
+#include "Label.h"
+#include "../Config.h"
+#include "../FrameProfiler.h"
+
+#include <ncine/Application.h>
+#include <ncine/Viewport.h>
+
+namespace {
+	nctl::String auxString(256);
+}
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS AND DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+FrameStatsOverlay::FrameStatsOverlay(SceneNode *parent, nctl::String name)
+    : LogicNode(parent, name)
+{
+	text_ = nctl::makeUnique<Label>(this, ResourceManager::FontSize::SMALL, 256);
+	text_->setLayer(Cfg::Layers::Overlay);
+	text_->setAlignment(nc::TextNode::Alignment::LEFT);
+
+	setEnabled(false);
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void FrameStatsOverlay::onTick(float deltaTime)
+{
+	if (lastRefresh_.secondsSince() >= Cfg::FrameStats::OverlayRefreshTime)
+		refreshText();
+}
+
+void FrameStatsOverlay::toggle()
+{
+	setEnabled(!isEnabled());
+	if (isEnabled())
+		refreshText();
+}
+
+void FrameStatsOverlay::followScreenViewport()
+{
+	nc::SceneNode *screenRoot = nc::theApplication().screenViewport().rootNode();
+	if (screenRoot == nullptr)
+		return;
+
+	if (parent() != screenRoot)
+		setParent(screenRoot);
+
+	// The screen sprite used by shader effects is centered on the screen
+	setPosition(-screenRoot->position());
+}
+
+///////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void FrameStatsOverlay::refreshText()
+{
+	const FrameProfiler &profiler = frameProfiler();
+	const FrameProfiler::Summary stats = profiler.summary();
+
+	auxString.format("Frame: avg %.2f p50 %.2f p95 %.2f p99 %.2f max %.2f ms\n", stats.average, stats.p50, stats.p95, stats.p99, stats.max);
+	auxString.formatAppend("Hitches: %u", profiler.numHitches());
+	for (unsigned int i = 0; i < FrameProfiler::NumZones; i++)
+	{
+		const FrameProfiler::Zone zone = static_cast<FrameProfiler::Zone>(i);
+		auxString.formatAppend("\n%s: %.2f ms, %u hitches", FrameProfiler::zoneName(zone), profiler.averageZoneTime(zone), profiler.numZoneHitches(zone));
+	}
+	text_->setString(auxString);
+
+	const float screenWidth = nc::theApplication().gfxDevice().width();
+	const float screenHeight = nc::theApplication().gfxDevice().height();
+	// Anchoring the top-left corner of the text
+	text_->setPosition(screenWidth * Cfg::FrameStats::OverlayRelativePos.x + text_->width() * 0.5f,
+	                   screenHeight * Cfg::FrameStats::OverlayRelativePos.y - text_->height() * 0.5f);
+
+	lastRefresh_.toNow();
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "LogicNode.h"
+#include <ncine/TimeStamp.h>
+
+class Label;
+
+/// A text overlay showing frame-time percentiles and hitches, available in release builds too
+class FrameStatsOverlay : public LogicNode
+{
+  public:
+	FrameStatsOverlay(SceneNode *parent, nctl::String name);
+
+	void onTick(float deltaTime) override;
+
+	void toggle();
+	/// Attaches the overlay to the root node of the screen viewport, which can change with shader effects
+	void followScreenViewport();
+
+  private:
+	nctl::UniquePtr<Label> text_;
+	nc::TimeStamp lastRefresh_;
+
+	void refreshText();
+};
@@ -5,6 +5,7 @@
 
 #include "Game.h"
 #include "Player.h"
+#include "Hud.h"
 #include "Bubble.h"
 #include "Body.h"
 #include "../ResourceManager.h"
@@ -14,14 +15,22 @@
 #include "../main.h"
 #include "../MusicManager.h"
 #include "../ShaderEffects.h"
+#include "../FrameProfiler.h"
+#include "../BubblePool.h"
+#include "../BubbleGrid.h"
+#include "../SpawnScheduler.h"
+#include "../Serializer.h"
+#include "../RenderStats.h"
+#include "../GameSnapshot.h"
+#include "../RollbackSession.h"
+#include "../JobSystem.h"
+#include "../ContactSolver.h"
 
 #include <ncine/Application.h>
 #include <ncine/FileSystem.h>
 #include <ncine/Texture.h>
 #include <ncine/Sprite.h>
 #include <ncine/AudioBufferPlayer.h>
-#include <ncine/Font.h>
-#include <ncine/TextNode.h>
 #include <ncine/Random.h>
 
 namespace {
@@ -32,6 +41,7 @@ namespace {
 	enum SimpleSelectEntry
 	{
 		RESUME_GAME,
+		REMATCH,
 		GOTO_MAIN_MENU,
 		GOTO_QUIT_PAGE_FROM_PAUSE,
 		GOTO_QUIT_PAGE_FROM_ENDMATCH,
@@ -64,11 +74,13 @@ MenuPage::PageConfig Game::quitConfirmationEndMatchPage_;
 ///////////////////////////////////////////////////////////
 
 Game::Game(SceneNode *parent, nctl::String name, MyEventHandler *eventHandler)
-    : LogicNode(parent, name), eventHandler_(eventHandler),
-      paused_(false), matchEnded_(false)
+    : LogicNode(parent, name), eventHandler_(eventHandler), playerB_(nullptr), bubbleGridIsValid_(false),
+      matchTime_(0.0f), matchDuration_(0), paused_(false), matchEnded_(false), benchmarkMode_(false),
+      attractMode_(false), bubbleSpawnTarget_(0), muteEffects_(false)
 {
 	gamePtr = this;
 	loadScene();
+	reset();
 }
 
 Game::~Game()
@@ -87,83 +99,49 @@ Game::~Game()
 
 void Game::onTick(float deltaTime)
 {
-	if (inputBinder().isTriggered(inputActions().GAME_PAUSE))
-		togglePause();
-
-	const float matchTimeFloat = static_cast<float>(eventHandler_->settings().matchTime);
-	if (matchEnded_ == false && paused_ == false && matchTimer_.secondsSince() > matchTimeFloat)
-		endMatch();
-
-	if (paused_ || matchEnded_)
-		return;
-
-	destroyDeadBubbles();
-	spawnBubbles();
-	Body::Collisions.clear();
+	FrameProfiler &profiler = frameProfiler();
+	profiler.beginZone(FrameProfiler::Zone::GAME_LOGIC);
 
-	const unsigned int subSteps = 16;
-	const float subStepLength = deltaTime / static_cast<float>(subSteps);
-
-	for (unsigned int subStep = 0; subStep < subSteps; subStep++)
+	if (rollback_ != nullptr)
 	{
-		// Integrate all physics bodies
-		for (Body *body : Body::All)
-			body->integrate(subStepLength);
-
-		// Resolve collisions
-		const unsigned int len = Body::All.size();
-		for (unsigned int i = 0; i < len; i++)
+		// A network match cannot be paused, the session advances the simulation at its own fixed rate
+		if (matchEnded_ == false)
 		{
-			Body *bA = Body::All[i];
-
-			for (unsigned int j = i + 1; j < len; j++)
-			{
-				Body *bB = Body::All[j];
-
-				if (bA->bodyKind() == BodyKind::STATIC && bB->bodyKind() == BodyKind::STATIC)
-					continue;
-
-				if (bA->colliderKind() == ColliderKind::CIRCLE && bB->colliderKind() == ColliderKind::CIRCLE)
-					Body::circleVsCircleCollision(bA, bB);
-				else if (bA->colliderKind() == ColliderKind::CIRCLE && bB->colliderKind() == ColliderKind::AABB)
-					Body::circleVsAabbCollision(bA, bB);
-				else if (bA->colliderKind() == ColliderKind::AABB && bB->colliderKind() == ColliderKind::CIRCLE)
-					Body::circleVsAabbCollision(bB, bA);
-				else
-					LOGW_X("Unhandled: %s vs %s", bA->colliderKindName(), bB->colliderKindName());
-			}
+			rollback_->update(deltaTime);
+			const int lastFrame = static_cast<int>(matchDuration_ * Cfg::Netplay::TickRate);
+			if (rollback_->hasReachedFrame(lastFrame) || rollback_->state() == RollbackSession::State::DISCONNECTED)
+				endMatch();
+			updateHud();
 		}
+		profiler.endZone(FrameProfiler::Zone::GAME_LOGIC);
+		return;
 	}
 
-	// Stamina bar sprite for player A
-	nc::Recti redRect = redBar_->texRect();
-	redRect.w *= playerA_->stamina();
-	redRect.x += redBar_->texRect().w - redRect.w;
-	redBarFill_->setTexRect(redRect);
-	nc::Vector2f redPos = redBar_->absPosition();
-	redPos.x += (redBar_->width() * (1.0f - playerA_->stamina())) * 0.5f;
-	redBarFill_->setPosition(redPos);
-
-	auxString.format("%d", playerA_->points());
-	pointsAText_->setString(auxString);
+	if (benchmarkMode_ == false && attractMode_ == false && inputBinder().isTriggered(inputActions().GAME_PAUSE))
+		togglePause();
 
-	if (eventHandler_->settings().numPlayers == 2)
+	const float matchDurationFloat = static_cast<float>(matchDuration_);
+	if (benchmarkMode_ == false && matchEnded_ == false && paused_ == false && matchTime_ > matchDurationFloat)
 	{
-		// Stamina bar sprite for player B
-		nc::Recti blueRect = blueBar_->texRect();
-		blueRect.w *= playerB_->stamina();
-		blueBarFill_->setTexRect(blueRect);
-		nc::Vector2f bluePos = blueBar_->absPosition();
-		bluePos.x -= (blueBar_->width() * (1.0f - playerB_->stamina())) * 0.5f;
-		blueBarFill_->setPosition(bluePos);
+		// Bots start a new match without showing the end match page or saving any statistics
+		if (attractMode_)
+			requestRematch_ = true;
+		else
+			endMatch();
+	}
 
-		auxString.format("%d", playerB_->points());
-		pointsBText_->setString(auxString);
+	if (paused_ || matchEnded_)
+	{
+		profiler.endZone(FrameProfiler::Zone::GAME_LOGIC);
+		return;
 	}
 
-	const float secondsLeft = static_cast<float>(eventHandler_->settings().matchTime) - matchTimer_.secondsSince();
-	auxString.format("%d", static_cast<int>(secondsLeft));
-	timeText_->setString(auxString);
+	PlayerInput inputs[2];
+	pollInputs(inputs);
+	step(deltaTime, inputs, false);
+	updateHud();
+
+	profiler.endZone(FrameProfiler::Zone::GAME_LOGIC);
 }
 
 void Game::drawGui()
@@ -178,10 +156,15 @@ void Game::drawGui()
 	}
 	if (ImGui::Button("Return To Menu"))
 		requestMenu_ = true;
+	ImGui::SameLine();
+	if (ImGui::Button("Rematch"))
+		requestRematch_ = true;
 	if (ImGui::Button("Quit"))
 		nc::theApplication().quit();
 	ImGui::NewLine();
 
+	RenderStats::collect().drawGui();
+
 	if (ImGui::TreeNode("Settings"))
 	{
 		const Settings &settings = eventHandler_->settings();
@@ -191,6 +174,8 @@ void Game::drawGui()
 		ImGui::Text("Number of players: %d", settings.numPlayers);
 		ImGui::Text("Match time: %d", settings.matchTime);
 		ImGui::Text("Shaders: %s", settings.withShaders ? "on" : "off");
+		ImGui::Text("Blur quality: %u%s", settings.blurQuality, eventHandler_->shaderEffects().isBlurCached() ? " (cached)" : "");
+		ImGui::Text("Render scale: %.2f%s", settings.renderScale, settings.sharpenUpscale ? " (sharpened)" : "");
 		ImGui::Text("Vibration: %s", settings.withVibration ? "on" : "off");
 		ImGui::TreePop();
 	}
@@ -227,13 +212,16 @@ void Game::drawGui()
 	}
 	else
 	{
-		const float secondsLeft = static_cast<float>(eventHandler_->settings().matchTime) - matchTimer_.secondsSince();
+		const float secondsLeft = static_cast<float>(matchDuration_) - matchTime_;
 		ImGui::Text("Time left: %d", static_cast<int>(secondsLeft));
 		ImGui::SameLine();
 		if (ImGui::Button("Reset##Time"))
-			matchTimer_.toNow();
+			matchTime_ = 0.0f;
 	}
 
+	if (rollback_ != nullptr)
+		rollback_->drawGui();
+
 	playerA_->drawGui();
 	if (playerB_ != nullptr)
 		playerB_->drawGui();
@@ -251,11 +239,15 @@ void Game::drawGui()
 		ImGui::TreePop();
 	}
 
+	contactSolver_->drawGui();
+	spawnScheduler_->drawGui();
+	hud_->drawGui();
+
 	if (ImGui::TreeNode("Bubbles"))
 	{
-		ImGui::Text("Alive: %d, Dead: %d, Pool: %d", bubbles_.size(), deadBubbles_.size(), bubblePool_.size());
-		auxString.format("Pool: %d / %d", bubblePool_.size(), Cfg::Game::BubblePoolSize);
-		const float poolFraction = bubblePool_.size() / static_cast<float>(Cfg::Game::BubblePoolSize);
+		ImGui::Text("Alive: %d, Dead: %d, Free: %d", bubbles_.size(), deadBubbles_.size(), bubblePool_->numFree());
+		auxString.format("Pool: %d / %d", bubblePool_->size(), bubblePool_->maxSize());
+		const float poolFraction = bubblePool_->size() / static_cast<float>(bubblePool_->maxSize());
 		ImGui::ProgressBar(poolFraction, ImVec2(0.0f, 0.0f), auxString.data());
 		ImGui::NewLine();
 
@@ -268,9 +260,21 @@ void Game::drawGui()
 
 void Game::onFrameStart()
 {
+	// The reset raises the requests that set up the viewports again for an unpaused match
+	if (requestRematch_)
+	{
+		// Resumes the audio and the music when restarting from the pause
+		if (paused_)
+			togglePause();
+		const bool attractMode = attractMode_;
+		reset();
+		if (attractMode)
+			setAttractMode(true);
+	}
+
 	if (requestShaderEffectsChange_)
 	{
-		enableShaderEffects(eventHandler_->settings().withShaders);
+		enableShaderEffects(eventHandler_->withShaders());
 		requestShaderEffectsChange_ = false;
 	}
 
@@ -290,6 +294,16 @@ void Game::onFrameStart()
 
 void Game::onQuitRequest()
 {
+	if (attractMode_)
+	{
+		requestMenu_ = true;
+		return;
+	}
+
+	// Quitting abandons a network match, as it cannot be paused
+	if (rollback_ != nullptr && matchEnded_ == false)
+		endMatch();
+
 	if (paused_ == false && matchEnded_ == false)
 		togglePause();
 
@@ -299,15 +313,281 @@ void Game::onQuitRequest()
 		menuPage_->setup(quitConfirmationEndMatchPage_);
 }
 
+void Game::reset()
+{
+	releaseBubbles();
+	Body::Collisions.clear();
+	spawnScheduler_->reset();
+	// Every match has different spawns, unless a snapshot is restored
+	spawnScheduler_->seed(nc::random().integer(), nc::random().integer());
+
+	// A new match is always a local one, a network match is started again from the command line
+	rollback_.reset(nullptr);
+	const Settings &settings = eventHandler_->settings();
+	matchDuration_ = settings.matchTime;
+	setupPlayers(settings.numPlayers);
+
+	for (unsigned int i = 0; i < Cfg::Sounds::NumBubblePopPlayers; i++)
+		poppingPlayers_[i]->stop();
+	setSfxVolume();
+
+	paused_ = false;
+	matchEnded_ = false;
+	benchmarkMode_ = false;
+	attractMode_ = false;
+	bubbleGridIsValid_ = false;
+	bubbleSpawnTarget_ = 0;
+	statistics_ = {};
+	menuPage_->setEnabled(false);
+	darkForeground_->setEnabled(false);
+	matchTime_ = 0.0f;
+
+	requestMenu_ = false;
+	requestRematch_ = false;
+	requestShaderEffectsChange_ = true;
+	// The viewports might still be set up for the pause
+	requestPauseShaderEffectsChange_ = shaderEffectsEnabled_;
+}
+
+void Game::setActive(bool active)
+{
+	setEnabled(active);
+	if (active == false)
+	{
+		rollback_.reset(nullptr);
+		enableShaderEffects(false);
+		for (unsigned int i = 0; i < Cfg::Sounds::NumBubblePopPlayers; i++)
+			poppingPlayers_[i]->stop();
+	}
+}
+
+void Game::step(float deltaTime, const PlayerInput inputs[2], bool resimulation)
+{
+	muteEffects_ = resimulation;
+	matchTime_ += deltaTime;
+	bubbleGridIsValid_ = false;
+
+	destroyDeadBubbles();
+	spawnBubbles(deltaTime);
+	Body::Collisions.clear();
+	contactSolver_->beginStep();
+
+	FrameProfiler &profiler = frameProfiler();
+	profiler.beginZone(FrameProfiler::Zone::PHYSICS);
+
+	const float subStepLength = deltaTime / static_cast<float>(Cfg::Physics::NumSubSteps);
+
+	for (unsigned int subStep = 0; subStep < Cfg::Physics::NumSubSteps; subStep++)
+	{
+		// Integrate all physics bodies, each job only moves the bodies of its range
+		jobSystem().parallelFor(0, Body::All.size(), Cfg::Jobs::BodiesPerJob, [subStepLength](unsigned int first, unsigned int last) {
+			for (unsigned int i = first; i < last; i++)
+				Body::All[i]->integrate(subStepLength);
+		});
+
+		// Resolve collisions, the contacts are detected in parallel and resolved in the same order on every run
+		contactSolver_->solve();
+	}
+	profiler.endZone(FrameProfiler::Zone::PHYSICS);
+
+	// Players and bubbles are simulated in a fixed order instead of being ticked by the scene graph
+	playerA_->simulate(deltaTime, inputs[0]);
+	if (playerB_ != nullptr)
+		playerB_->simulate(deltaTime, inputs[1]);
+	// The contacts are scanned in parallel, then kills, sounds and counters follow the order of the alive bubbles
+	jobSystem().parallelFor(0, bubbles_.size(), Cfg::Jobs::BubblesPerJob, [this](unsigned int first, unsigned int last) {
+		for (unsigned int i = first; i < last; i++)
+			bubbles_[i]->checkGrounded();
+	});
+	// Bubbles killed in this step stay in the array until the next one
+	for (unsigned int i = 0; i < bubbles_.size(); i++)
+		bubbles_[i]->simulate();
+
+	muteEffects_ = false;
+}
+
+void Game::pollInputs(PlayerInput inputs[2])
+{
+	inputs[0] = pollInput(0);
+	inputs[1] = pollInput(1);
+}
+
+PlayerInput Game::pollInput(unsigned int playerIndex)
+{
+	ASSERT(playerIndex < 2);
+	Player *player = (playerIndex == 0) ? playerA_.get() : playerB_;
+	if (player == nullptr)
+		return PlayerInput();
+
+	if (player->isAutopilotEnabled())
+		updateBubbleGrid();
+	return player->pollInput(*bubbleGrid_);
+}
+
+void Game::startNetplay(const NetplayConfig &config)
+{
+	rollback_ = nctl::makeUnique<RollbackSession>(*this, config);
+	if (rollback_->isOpen() == false)
+	{
+		LOGW("Cannot open the network link, playing a local match instead");
+		rollback_.reset(nullptr);
+		return;
+	}
+
+	// The simulation does not advance until the peer has connected
+	setupPlayers(2);
+}
+
+void Game::startNetplayMatch(uint64_t seed, unsigned int matchDuration)
+{
+	ASSERT(rollback_ != nullptr);
+
+	releaseBubbles();
+	Body::Collisions.clear();
+	spawnScheduler_->reset();
+	spawnScheduler_->seed(seed, seed >> 32);
+	statistics_ = {};
+	matchTime_ = 0.0f;
+	matchDuration_ = matchDuration;
+	rollback_->setLastFrame(static_cast<int>(matchDuration_ * Cfg::Netplay::TickRate));
+
+	// Both peers use the bindings of the first player for the player they control
+	setupPlayers(2);
+	playerA_->setInputBindings(0);
+	secondPlayer_->setInputBindings(0);
+}
+
+void Game::saveSnapshot(GameSnapshot &snapshot) const
+{
+	snapshot.matchTime = matchTime_;
+	snapshot.numPlayers = (playerB_ != nullptr) ? 2 : 1;
+	snapshot.statistics = statistics_;
+	spawnScheduler_->saveSnapshot(snapshot.spawn);
+	playerA_->saveSnapshot(snapshot.players[0]);
+	secondPlayer_->saveSnapshot(snapshot.players[1]);
+
+	// Bubbles killed in the last tick are already out of `Body::All`
+	snapshot.numBodies = Body::All.size();
+	for (unsigned int i = 0; i < GameSnapshot::NumFixedBodies; i++)
+		snapshot.fixedBodyIndices[i] = fixedBody(i)->allIndex();
+
+	unsigned int numBubbles = 0;
+	for (const Body *body : Body::All)
+	{
+		if (body->bodyId() != BodyId::BUBBLE)
+			continue;
+
+		const Bubble *bubble = static_cast<const Bubble *>(body->parent());
+		BubbleSnapshot &bubbleSnapshot = snapshot.bubbles[numBubbles++];
+		bubbleSnapshot.position = body->position();
+		bubbleSnapshot.linearVelocity = body->linearVelocity_;
+		bubbleSnapshot.variant = bubble->variant();
+	}
+	snapshot.numBubbles = numBubbles;
+}
+
+void Game::restoreSnapshot(const GameSnapshot &snapshot)
+{
+	ASSERT(snapshot.numPlayers == ((playerB_ != nullptr) ? 2u : 1u));
+	ASSERT(snapshot.numBubbles <= snapshot.numBodies);
+
+	matchTime_ = snapshot.matchTime;
+	statistics_ = snapshot.statistics;
+	spawnScheduler_->restoreSnapshot(snapshot.spawn);
+	playerA_->restoreSnapshot(snapshot.players[0]);
+	secondPlayer_->restoreSnapshot(snapshot.players[1]);
+
+	// `Body::All` is filled again in the captured order, as it decides the order of the collision responses
+	releaseBubbles();
+	for (unsigned int i = 0; i < GameSnapshot::NumFixedBodies; i++)
+		fixedBody(i)->removeFromAll();
+	ASSERT(Body::All.isEmpty());
+	Body::Collisions.clear();
+
+	bubbleGridIsValid_ = false;
+	unsigned int bubbleIndex = 0;
+	for (unsigned int i = 0; i < snapshot.numBodies; i++)
+	{
+		bool isFixedBody = false;
+		for (unsigned int j = 0; j < GameSnapshot::NumFixedBodies; j++)
+		{
+			if (snapshot.fixedBodyIndices[j] == i)
+			{
+				fixedBody(j)->addToAll();
+				isFixedBody = true;
+				break;
+			}
+		}
+		if (isFixedBody)
+			continue;
+
+		const BubbleSnapshot &bubbleSnapshot = snapshot.bubbles[bubbleIndex++];
+		Bubble *bubble = acquireBubble(bubbleSnapshot.variant);
+		if (bubble == nullptr)
+			continue;
+
+		bubble->body()->setPosition(bubbleSnapshot.position);
+		bubble->body()->linearVelocity_ = bubbleSnapshot.linearVelocity;
+		bubble->onSpawn();
+		bubble->setAliveIndex(bubbles_.size());
+		bubbles_.pushBack(bubble);
+	}
+
+	updateHud();
+}
+
+void Game::setBenchmarkMode(bool enabled)
+{
+	benchmarkMode_ = enabled;
+	const BotDifficulty difficulty = static_cast<BotDifficulty>(Cfg::Bot::BenchmarkDifficulty);
+	playerA_->setAutopilot(enabled);
+	playerA_->bot().setDifficulty(difficulty);
+	if (playerB_ != nullptr)
+	{
+		playerB_->setAutopilot(enabled);
+		playerB_->bot().setDifficulty(difficulty);
+	}
+}
+
+void Game::setAttractMode(bool enabled)
+{
+	ASSERT(rollback_ == nullptr);
+	attractMode_ = enabled;
+	// Bots always play against each other, whatever the number of players in the settings
+	setupPlayers(enabled ? 2 : eventHandler_->settings().numPlayers);
+
+	const BotDifficulty difficulty = static_cast<BotDifficulty>(Cfg::Bot::AttractDifficulty);
+	playerA_->setAutopilot(enabled);
+	playerA_->bot().setDifficulty(difficulty);
+	secondPlayer_->setAutopilot(enabled);
+	secondPlayer_->bot().setDifficulty(difficulty);
+}
+
+void Game::setBubbleSpawnTarget(unsigned int numBubbles)
+{
+	if (numBubbles > Cfg::Game::BubblePoolMaxSize)
+	{
+		LOGW_X("The bubble pool is limited to %u bubbles, cannot reach a target of %u", Cfg::Game::BubblePoolMaxSize, numBubbles);
+		numBubbles = Cfg::Game::BubblePoolMaxSize;
+	}
+	bubbleSpawnTarget_ = numBubbles;
+}
+
 void Game::playSound()
 {
 	FATAL_ASSERT(gamePtr != nullptr);
+	if (gamePtr->muteEffects_)
+		return;
 	gamePtr->playPoppingSound();
 }
 
 void Game::killBubble(Bubble *bubblePtr)
 {
 	FATAL_ASSERT(gamePtr != nullptr);
+	// A bubble can be touched by both players, or touched while reaching the ground, in the same frame
+	if (bubblePtr->isAlive() == false)
+		return;
+
 	bubblePtr->onKilled();
 	gamePtr->deadBubbles_.pushBack(bubblePtr);
 }
@@ -321,8 +601,15 @@ void Game::incrementDroppedBubble()
 void Game::vibrateJoy(int index)
 {
 	FATAL_ASSERT(gamePtr != nullptr);
-	if (gamePtr->eventHandler_->settings().withVibration == false)
+	if (gamePtr->muteEffects_ || gamePtr->attractMode_ || gamePtr->eventHandler_->settings().withVibration == false)
 		return;
+	if (gamePtr->rollback_ != nullptr)
+	{
+		// The only joystick of a network peer belongs to its local player
+		if (static_cast<unsigned int>(index) != gamePtr->rollback_->localPlayer())
+			return;
+		index = 0;
+	}
 
 	nc::IInputManager &inputManager = nc::theApplication().inputManager();
 	if (inputManager.isJoyPresent(index) && inputManager.hasJoyVibration(index))
@@ -362,65 +649,36 @@ void Game::loadScene()
 	darkForeground_->setLayer(Cfg::Layers::Menu_Page - 128);
 	darkForeground_->setEnabled(false);
 
-	const nctl::String fontFntPath_ = nc::fs::joinPath(nc::fs::dataPath(), Cfg::Fonts::Modak50Fnt);
-	const nctl::String fontTexPath_ = nc::fs::joinPath(nc::fs::dataPath(), Cfg::Fonts::Modak50Png);
-	font_ = nctl::makeUnique<nc::Font>(fontFntPath_.data(), resourceManager().retrieveTexture(Cfg::Fonts::Modak50Png));
-
-	redBar_ = nctl::makeUnique<nc::Sprite>(this, resourceManager().retrieveTexture(Cfg::Textures::RedBar));
-	redBarFill_ = nctl::makeUnique<nc::Sprite>(this, resourceManager().retrieveTexture(Cfg::Textures::RedBarFill));
-
-	redBar_->setLayer(Cfg::Layers::Gui_StaminaBar);
-	redBar_->setPosition(screenTopRight * Cfg::Gui::RedBarRelativePos);
-	redBar_->setScale(Cfg::Gui::BarScale);
-	redBarFill_->setLayer(Cfg::Layers::Gui_StaminaBar_Fill);
-	redBarFill_->setPosition(screenTopRight * Cfg::Gui::RedBarRelativePos);
-	redBarFill_->setScale(Cfg::Gui::BarScale);
-
-	pointsAText_ = nctl::makeUnique<nc::TextNode>(this, font_.get(), 256);
-	pointsAText_->setLayer(Cfg::Layers::Gui_Text);
-	pointsAText_->setRenderMode(nc::Font::RenderMode::GLYPH_SPRITE);
-	pointsAText_->setString("0");
-	pointsAText_->setPosition((screenTopRight - pointsAText_->absSize() * 0.5f) * Cfg::Gui::PointsATextRelativePos);
+	hud_ = nctl::makeUnique<Hud>(this, "Hud", eventHandler_->settings().numPlayers, eventHandler_->settings().matchTime);
 
+	// Both players are created, the second one is only active in a two players match
 	playerA_ = nctl::makeUnique<Player>(this, "Player A", 0);
-
-	if (eventHandler_->settings().numPlayers == 2)
+	secondPlayer_ = nctl::makeUnique<Player>(this, "Player B", 1);
+
+	bubblePool_ = nctl::makeUnique<BubblePool>(this, Cfg::Game::BubblePoolChunkSize, Cfg::Game::BubblePoolMaxSize);
+	bubbles_.setCapacity(Cfg::Game::BubblePoolChunkSize);
+	deadBubbles_.setCapacity(Cfg::Game::BubblePoolChunkSize);
+
+	// The grid also covers the spawn area above the screen, where the bubbles start falling from
+	bubbleGrid_ = nctl::makeUnique<BubbleGrid>(Cfg::Game::BubblePoolMaxSize);
+	bubbleGrid_->setupArea(nc::Rectf(0.0f, 0.0f, screenWidth, screenHeight * Cfg::Spawn::AreaRelativeMax.y), Cfg::Bot::GridCellSize);
+	contactSolver_ = nctl::makeUnique<ContactSolver>(jobSystem());
+
+	nctl::Array<SpawnWave> spawnWaves;
+	if (Serializer::loadSpawnWaves(spawnWaves) == false)
+		SpawnScheduler::defaultWaves(spawnWaves);
+	spawnScheduler_ = nctl::makeUnique<SpawnScheduler>();
+	spawnScheduler_->setWaves(spawnWaves);
 	{
-		blueBar_ = nctl::makeUnique<nc::Sprite>(this, resourceManager().retrieveTexture(Cfg::Textures::BlueBar));
-		blueBarFill_ = nctl::makeUnique<nc::Sprite>(this, resourceManager().retrieveTexture(Cfg::Textures::BlueBarFill));
-
-		blueBar_->setLayer(Cfg::Layers::Gui_StaminaBar);
-		blueBar_->setPosition(screenTopRight * Cfg::Gui::BlueBarRelativePos);
-		blueBar_->setScale(Cfg::Gui::BarScale);
-		blueBarFill_->setLayer(Cfg::Layers::Gui_StaminaBar_Fill);
-		blueBarFill_->setPosition(screenTopRight * Cfg::Gui::BlueBarRelativePos);
-		blueBarFill_->setScale(Cfg::Gui::BarScale);
-
-		pointsBText_ = nctl::makeUnique<nc::TextNode>(this, font_.get(), 256);
-		pointsBText_->setLayer(Cfg::Layers::Gui_Text);
-		pointsBText_->setRenderMode(nc::Font::RenderMode::GLYPH_SPRITE);
-		pointsBText_->setString("0");
-		pointsBText_->setPosition((screenTopRight - pointsBText_->absSize() * 0.5f) * Cfg::Gui::PointsBTextRelativePos);
-
-		playerB_ = nctl::makeUnique<Player>(this, "Player B", 1);
+		const float width = nc::theApplication().gfxDevice().width();
+		const float height = nc::theApplication().gfxDevice().height();
+		const nc::Vector2f areaMin(width * Cfg::Spawn::AreaRelativeMin.x, height * Cfg::Spawn::AreaRelativeMin.y);
+		const nc::Vector2f areaMax(width * Cfg::Spawn::AreaRelativeMax.x, height * Cfg::Spawn::AreaRelativeMax.y);
+		const float bubbleRadius = (*bubblePool_)[0].body()->colliderHalfSize_.x;
+		spawnScheduler_->setupArea(nc::Rectf(areaMin.x, areaMin.y, areaMax.x - areaMin.x, areaMax.y - areaMin.y),
+		                           bubbleRadius * 2.0f * Cfg::Spawn::MinDistanceFactor);
 	}
 
-	for (unsigned int i = 0; i < Cfg::Game::BubblePoolSize; i++)
-	{
-		auxString.format("Bubble #%u", i);
-		const unsigned int variant = nc::random().integer(0, Cfg::Textures::NumBubbleVariants);
-		nctl::UniquePtr<Bubble> bubble = nctl::makeUnique<Bubble>(this, auxString.data(), nc::Vector2f::Zero, variant);
-		bubble->onKilled();
-		bubblePool_.pushBack(nctl::move(bubble));
-	}
-
-	timeText_ = nctl::makeUnique<nc::TextNode>(this, font_.get(), 256);
-	timeText_->setLayer(Cfg::Layers::Gui_Text);
-	timeText_->setRenderMode(nc::Font::RenderMode::GLYPH_SPRITE);
-	auxString.format("%d", eventHandler_->settings().matchTime);
-	timeText_->setString(auxString);
-	timeText_->setPosition((screenTopRight - timeText_->absSize() * 0.5f) * Cfg::Gui::TimeTextRelativePos);
-
 	const Settings &settings = eventHandler_->settings();
 	const float targetVolume = settings.sfxVolume * settings.volume;
 	for (unsigned int i = 0; i < Cfg::Sounds::NumBubblePopPlayers; i++)
@@ -433,16 +691,16 @@ void Game::loadScene()
 
 	// Floor
 	obstacle1_ = nctl::makeUnique<Body>(this, "Floor", ColliderKind::AABB, BodyKind::STATIC, BodyId::STATIC);
-	obstacle1_->setPosition(screenWidth * 0.5f, 0.0f);
-	obstacle1_->colliderHalfSize_ = nc::Vector2f(4096.0f, Cfg::Game::FloorHeight);
+	obstacle1_->setPosition(screenTopRight * Cfg::Game::Obstacles[0].relativePosition);
+	obstacle1_->colliderHalfSize_ = Cfg::Game::Obstacles[0].halfSize;
 	obstacle1Gfx_ = nctl::makeUnique<nc::Sprite>(obstacle1_.get(), nullptr);
 	obstacle1Gfx_->setSize(obstacle1_->colliderHalfSize_ * 2.0f);
 	obstacle1Gfx_->setAlphaF(0.3f);
 
 	// Left limit
 	obstacle2_ = nctl::makeUnique<Body>(this, "Obstacle", ColliderKind::AABB, BodyKind::STATIC, BodyId::STATIC);
-	obstacle2_->setPosition(0.0f, 0.0f);
-	obstacle2_->colliderHalfSize_ = nc::Vector2f(Cfg::Game::FloorHeight, 4096.0f);
+	obstacle2_->setPosition(screenTopRight * Cfg::Game::Obstacles[1].relativePosition);
+	obstacle2_->colliderHalfSize_ = Cfg::Game::Obstacles[1].halfSize;
 #if NCPROJECT_DEBUG
 	obstacle2Gfx_ = nctl::makeUnique<nc::Sprite>(obstacle2_.get(), nullptr);
 	obstacle2Gfx_->setSize(obstacle2_->colliderHalfSize_ * 2.0f);
@@ -451,8 +709,8 @@ void Game::loadScene()
 
 	// Right limit
 	obstacle3_ = nctl::makeUnique<Body>(this, "Obstacle", ColliderKind::AABB, BodyKind::STATIC, BodyId::STATIC);
-	obstacle3_->setPosition(screenWidth, screenHeight);
-	obstacle3_->colliderHalfSize_ = nc::Vector2f(Cfg::Game::FloorHeight, 4096.0f);
+	obstacle3_->setPosition(screenTopRight * Cfg::Game::Obstacles[2].relativePosition);
+	obstacle3_->colliderHalfSize_ = Cfg::Game::Obstacles[2].halfSize;
 #if NCPROJECT_DEBUG
 	obstacle3Gfx_ = nctl::makeUnique<nc::Sprite>(obstacle3_.get(), nullptr);
 	obstacle3Gfx_->setSize(obstacle3_->colliderHalfSize_ * 2.0f);
@@ -474,54 +732,179 @@ void Game::loadScene()
 
 	foregroundRoot_ = nctl::makeUnique<nc::SceneNode>(this);
 	foregroundRoot_->setDeleteChildrenOnDestruction(false);
+}
 
-	requestShaderEffectsChange_ = true;
+void Game::setupPlayers(unsigned int numPlayers)
+{
+	const bool twoPlayers = (numPlayers == 2);
+	playerA_->reset();
+	secondPlayer_->reset();
+	secondPlayer_->setActive(twoPlayers);
+	playerB_ = twoPlayers ? secondPlayer_.get() : nullptr;
+	hud_->reset(numPlayers, matchDuration_);
 }
 
-void Game::spawnBubbles()
+void Game::updateHud()
 {
-	const unsigned int aliveCount = bubbles_.size();
-	const unsigned int spawnTarget = Cfg::Game::NumBubbleForSpawnPerPlayer * eventHandler_->settings().numPlayers;
+	hud_->setStamina(0, playerA_->stamina());
+	hud_->setPoints(0, playerA_->points());
+	if (playerB_ != nullptr)
+	{
+		hud_->setStamina(1, playerB_->stamina());
+		hud_->setPoints(1, playerB_->points());
+	}
 
-	if (aliveCount < spawnTarget)
-		spawnBubble();
+	const float secondsLeft = static_cast<float>(matchDuration_) - matchTime_;
+	hud_->setSecondsLeft(static_cast<int>(secondsLeft));
+}
+
+void Game::releaseBubbles()
+{
+	// Alive bubbles, dead ones included until they are destroyed, go back to the pool without shrinking it
+	for (Bubble *bubble : bubbles_)
+	{
+		bubble->onKilled();
+		bubblePool_->release(bubble->poolIndex());
+	}
+	bubbles_.clear();
+	deadBubbles_.clear();
 }
 
-void Game::spawnBubble()
+Body *Game::fixedBody(unsigned int index) const
 {
-	if (bubblePool_.isEmpty())
+	switch (index)
 	{
-		LOGW("Bubble pool is empty, cannot spawn a new bubble!");
+		case 0: return playerA_->body();
+		case 1: return secondPlayer_->body();
+		case 2: return obstacle1_.get();
+		case 3: return obstacle2_.get();
+		case 4: return obstacle3_.get();
+		default:
+			ASSERT_MSG_X(false, "Invalid fixed body index: %u", index);
+			return nullptr;
+	}
+}
+
+void Game::spawnBubbles(float deltaTime)
+{
+	if (bubbleSpawnTarget_ > 0)
+	{
+		// The target overrides the waves and is reached as fast as possible, overlaps are allowed
+		while (bubbles_.size() < bubbleSpawnTarget_)
+		{
+			const nc::Vector2f position = spawnScheduler_->randomPosition();
+			if (spawnBubble(position, spawnScheduler_->pickVariant()) == false)
+				break;
+		}
 		return;
 	}
 
-	const float screenWidth = nc::theApplication().gfxDevice().width();
-	const float screenHeight = nc::theApplication().gfxDevice().height();
+	const unsigned int numPlayers = (playerB_ != nullptr) ? 2 : 1;
+	const unsigned int numSpawns = spawnScheduler_->update(deltaTime, bubbles_.size(), numPlayers);
+	if (numSpawns == 0)
+		return;
 
-	const nc::Vector2f pos = nc::Vector2f(lerp(screenWidth * 0.1f, screenWidth - screenWidth * 0.1f, nc::random().real()),
-	                                      screenHeight + lerp(screenHeight * 0.2f, screenHeight * 1.0f, nc::random().real()));
+	spawnScheduler_->clearGrid();
+	for (Bubble *bubble : bubbles_)
+		spawnScheduler_->addPoint(bubble->body()->position());
+
+	for (unsigned int i = 0; i < numSpawns; i++)
+	{
+		nc::Vector2f pos;
+		if (spawnScheduler_->samplePosition(pos) == false)
+		{
+			spawnScheduler_->postpone(numSpawns - i);
+			break;
+		}
+		spawnBubble(pos, spawnScheduler_->pickVariant());
+	}
+}
+
+Bubble *Game::acquireBubble(unsigned int variant)
+{
+	const unsigned int poolSize = bubblePool_->size();
+	const unsigned int index = bubblePool_->acquire();
+	if (index == BubblePool::InvalidIndex)
+	{
+		LOGW("Bubble pool is full, cannot spawn a new bubble!");
+		return nullptr;
+	}
+	if (bubblePool_->size() > poolSize)
+		setupNewBubbles(poolSize);
+
+	Bubble &bubble = (*bubblePool_)[index];
+	if (bubble.variant() != variant)
+	{
+		bubble.setVariant(variant);
+		// When shader effects are enabled the variant is a region of the bubble atlas
+		if (shaderEffectsEnabled_)
+			eventHandler_->shaderEffects().setBubbleVariant(bubble.sprite(), variant);
+		else
+			bubble.sprite()->setTexture(resourceManager().retrieveTexture(Cfg::Textures::Bubbles[variant]));
+	}
+
+	return &bubble;
+}
+
+bool Game::spawnBubble(const nc::Vector2f &pos, unsigned int variant)
+{
+	Bubble *bubble = acquireBubble(variant);
+	if (bubble == nullptr)
+		return false;
 
-	nctl::UniquePtr<Bubble> bubble = nctl::move(bubblePool_.back());
-	bubblePool_.popBack();
 	bubble->body()->setPosition(pos);
+	bubble->body()->linearVelocity_ = nc::Vector2f::Zero;
 	bubble->onSpawn();
-	bubbles_.pushBack(nctl::move(bubble));
+	bubble->setAliveIndex(bubbles_.size());
+	bubbles_.pushBack(bubble);
+
+	return true;
+}
+
+/// Gives the bubbles created by a pool growth the same setup as the existing ones
+void Game::setupNewBubbles(unsigned int firstIndex)
+{
+	if (shaderEffectsEnabled_ == false)
+		return;
+
+	for (unsigned int i = firstIndex; i < bubblePool_->size(); i++)
+	{
+		Bubble &bubble = (*bubblePool_)[i];
+		bubble.setParent(sceneRoot_.get());
+		eventHandler_->shaderEffects().setBubbleShader(bubble.sprite(), i, bubble.variant());
+	}
+}
+
+void Game::updateBubbleGrid()
+{
+	if (bubbleGridIsValid_)
+		return;
+
+	bubbleGrid_->clear();
+	for (Bubble *bubble : bubbles_)
+	{
+		// Bubbles killed in the last step are still in the array
+		if (bubble->isAlive())
+			bubbleGrid_->addPoint(bubble->body()->position());
+	}
+	bubbleGrid_->build();
+	bubbleGridIsValid_ = true;
 }
 
 void Game::destroyDeadBubbles()
 {
-	// Destroy all dead nodes from last frame
-	for (const Bubble *it : deadBubbles_)
+	// Recycle all dead bubbles from last frame, the last alive one takes the place of each removed one
+	for (const Bubble *deadBubble : deadBubbles_)
 	{
-		for (int i = bubbles_.size() - 1; i >= 0; i--)
-		{
-			if (bubbles_[i].get() == it)
-			{
-				bubblePool_.pushBack(nctl::move(bubbles_[i]));
-				bubbles_.unorderedRemoveAt(i);
-				break;
-			}
-		}
+		const unsigned int aliveIndex = deadBubble->aliveIndex();
+		ASSERT(aliveIndex < bubbles_.size() && bubbles_[aliveIndex] == deadBubble);
+
+		Bubble *lastBubble = bubbles_.back();
+		bubbles_[aliveIndex] = lastBubble;
+		lastBubble->setAliveIndex(aliveIndex);
+		bubbles_.popBack();
+
+		bubblePool_->release(deadBubble->poolIndex());
 	}
 	deadBubbles_.clear();
 }
@@ -550,6 +933,10 @@ void Game::setSfxVolume()
 
 void Game::togglePause()
 {
+	// Pausing is disabled in netplay
+	if (rollback_ != nullptr)
+		return;
+
 	// The following code allows the `GAME_PAUSE` action key to be shared with the `UI_BACK` one
 	static unsigned int lastToggleFrame = 0;
 	if (lastToggleFrame == nc::theApplication().numFrames())
@@ -567,15 +954,9 @@ void Game::togglePause()
 
 	nc::IAudioDevice &audioDevice = nc::theServiceLocator().audioDevice();
 	if (paused_)
-	{
-		pauseTime_ = nc::TimeStamp::now();
 		audioDevice.pausePlayers(nc::IAudioDevice::PlayerType::BUFFER);
-	}
 	else
-	{
 		audioDevice.resumePlayers();
-		matchTimer_ += (nc::TimeStamp::now() - pauseTime_);
-	}
 	eventHandler_->musicManager().togglePause();
 
 	if (shaderEffectsEnabled_)
@@ -599,7 +980,7 @@ void Game::endMatch()
 void Game::saveStatistics()
 {
 	Statistics &statistics = eventHandler_->statisticsMut();
-	statistics.playTime += eventHandler_->settings().matchTime;
+	statistics.playTime += matchDuration_;
 	statistics.numMatches++;
 	statistics.numDroppedBubles += statistics_.numDroppedBubles;
 
@@ -629,17 +1010,7 @@ void Game::enableShaderEffects(bool enabled)
 		background_->setParent(backgroundRoot_.get());
 		darkForeground_->setParent(sceneRoot_.get());
 		playerA_->setParent(sceneRoot_.get());
-		redBar_->setParent(sceneRoot_.get());
-		redBarFill_->setParent(sceneRoot_.get());
-		pointsAText_->setParent(sceneRoot_.get());
-
-		if (playerB_)
-		{
-			playerB_->setParent(sceneRoot_.get());
-			blueBar_->setParent(sceneRoot_.get());
-			blueBarFill_->setParent(sceneRoot_.get());
-			pointsBText_->setParent(sceneRoot_.get());
-		}
+		secondPlayer_->setParent(sceneRoot_.get());
 
 		obstacle1Gfx_->setParent(sceneRoot_.get());
 		obstacle1Gfx_->setAlphaF(0.7f);
@@ -649,24 +1020,20 @@ void Game::enableShaderEffects(bool enabled)
 		obstacle2Gfx_->setAlphaF(0.5f);
 		obstacle3Gfx_->setAlphaF(0.5f);
 #endif
-		timeText_->setParent(sceneRoot_.get());
 
+		// Text is drawn at the window resolution, also when the scene is rendered at a lower scale
+		hud_->setParent(foregroundRoot_.get());
 		menuPage_->setParent(foregroundRoot_.get());
 
 		background_->setFlippedY(true);
 		darkForeground_->setAlpha(128 + 52);
 
-		nctl::StaticArray<Bubble *, Cfg::Game::BubblePoolSize> allBubbles;
-		for (unsigned int i = 0; i < bubblePool_.size(); i++)
-			allBubbles.pushBack(bubblePool_[i].get());
-		for (unsigned int i = 0; i < bubbles_.size(); i++)
-			allBubbles.pushBack(bubbles_[i].get());
-
-		for (unsigned int i = 0; i < allBubbles.size(); i++)
+		for (unsigned int i = 0; i < bubblePool_->size(); i++)
 		{
-			allBubbles[i]->setParent(sceneRoot_.get());
-			nc::Sprite *bubbleSprite = allBubbles[i]->sprite();
-			eventHandler_->shaderEffects().setBubbleShader(bubbleSprite, i);
+			Bubble &bubble = (*bubblePool_)[i];
+			bubble.setParent(sceneRoot_.get());
+			nc::Sprite *bubbleSprite = bubble.sprite();
+			eventHandler_->shaderEffects().setBubbleShader(bubbleSprite, i, bubble.variant());
 		}
 
 		eventHandler_->shaderEffects().setupGameViewports(this, backgroundRoot_.get(), sceneRoot_.get(), foregroundRoot_.get());
@@ -676,17 +1043,8 @@ void Game::enableShaderEffects(bool enabled)
 		background_->setParent(this);
 		darkForeground_->setParent(this);
 		playerA_->setParent(this);
-		redBar_->setParent(this);
-		redBarFill_->setParent(this);
-		pointsAText_->setParent(this);
-
-		if (playerB_)
-		{
-			playerB_->setParent(this);
-			blueBar_->setParent(this);
-			blueBarFill_->setParent(this);
-			pointsBText_->setParent(this);
-		}
+		secondPlayer_->setParent(this);
+		hud_->setParent(this);
 
 		obstacle1Gfx_->setParent(this);
 		obstacle1Gfx_->setAlphaF(0.3f);
@@ -696,25 +1054,20 @@ void Game::enableShaderEffects(bool enabled)
 		obstacle2Gfx_->setAlphaF(0.2f);
 		obstacle3Gfx_->setAlphaF(0.2f);
 #endif
-		timeText_->setParent(this);
 
 		menuPage_->setParent(this);
 
 		background_->setFlippedY(false);
 		darkForeground_->setAlpha(128);
 
-		nctl::StaticArray<Bubble *, Cfg::Game::BubblePoolSize> allBubbles;
-		for (unsigned int i = 0; i < bubblePool_.size(); i++)
-			allBubbles.pushBack(bubblePool_[i].get());
-		for (unsigned int i = 0; i < bubbles_.size(); i++)
-			allBubbles.pushBack(bubbles_[i].get());
-
-		for (unsigned int i = 0; i < allBubbles.size(); i++)
+		for (unsigned int i = 0; i < bubblePool_->size(); i++)
 		{
-			nc::Sprite *bubbleSprite = allBubbles[i]->sprite();
-			nc::Texture *bubbleTex = resourceManager().retrieveTexture(Cfg::Textures::Bubbles[allBubbles[i]->variant()]);
+			Bubble &bubble = (*bubblePool_)[i];
+			nc::Sprite *bubbleSprite = bubble.sprite();
+			nc::Texture *bubbleTex = resourceManager().retrieveTexture(Cfg::Textures::Bubbles[bubble.variant()]);
 			bubbleSprite->setTexture(bubbleTex);
-			allBubbles[i]->setParent(this);
+			bubbleSprite->setTexRect(nc::Recti(0, 0, bubbleTex->width(), bubbleTex->height()));
+			bubble.setParent(this);
 			eventHandler_->shaderEffects().clearBubbleShader(i);
 		}
 
@@ -753,6 +1106,7 @@ void Game::setupPages()
 		MenuPage::PageEntry numJumpsEntry("Jumps", reinterpret_cast<void *>(StatisticsTextEntry::NUM_JUMPS), Game::statisticsTextFunc, textEventReplyBits);
 		MenuPage::PageEntry numDoubleJumpsEntry("Double Jumps", reinterpret_cast<void *>(StatisticsTextEntry::NUM_DOUBLE_JUMPS), Game::statisticsTextFunc, textEventReplyBits);
 		MenuPage::PageEntry numDashesEntry("Dashes", reinterpret_cast<void *>(StatisticsTextEntry::NUM_DASHES), Game::statisticsTextFunc, textEventReplyBits);
+		MenuPage::PageEntry rematchEntry("Rematch", reinterpret_cast<void *>(SimpleSelectEntry::REMATCH), Game::simpleSelectFunc, selectEventReplyBits);
 		MenuPage::PageEntry menuEntry("Main Menu", reinterpret_cast<void *>(SimpleSelectEntry::GOTO_MAIN_MENU), Game::simpleSelectFunc, selectEventReplyBits);
 		MenuPage::PageEntry quitEntry("Quit", reinterpret_cast<void *>(SimpleSelectEntry::GOTO_QUIT_PAGE_FROM_ENDMATCH), Game::simpleSelectFunc, selectEventReplyBits);
 
@@ -762,6 +1116,7 @@ void Game::setupPages()
 		endMatchPage_.entries.pushBack(numJumpsEntry);
 		endMatchPage_.entries.pushBack(numDoubleJumpsEntry);
 		endMatchPage_.entries.pushBack(numDashesEntry);
+		endMatchPage_.entries.pushBack(rematchEntry);
 		endMatchPage_.entries.pushBack(menuEntry);
 		endMatchPage_.entries.pushBack(quitEntry);
 		endMatchPage_.title = "End Match";
@@ -834,6 +1189,10 @@ void Game::simpleSelectFunc(MenuPage::EntryEvent &event)
 			ASSERT(gamePtr->paused_ == true);
 			gamePtr->togglePause();
 			break;
+		case REMATCH:
+			ASSERT(gamePtr->matchEnded_ == true);
+			gamePtr->requestRematch_ = true;
+			break;
 		case GOTO_MAIN_MENU:
 			gamePtr->goToMainMenu();
 			break;
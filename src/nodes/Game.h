@@ -1,23 +1,30 @@
 #pragma once
 
+#include <nctl/Array.h>
 #include <nctl/StaticArray.h>
-#include <ncine/TimeStamp.h>
 #include "LogicNode.h"
 #include "MenuPage.h"
 #include "../Config.h"
 #include "../Statistics.h"
+#include "../PlayerInput.h"
 
 namespace ncine {
 	class Sprite;
 	class AudioBufferPlayer;
-	class Font;
-	class TextNode;
 }
 
 class Player;
+class Hud;
 class Body;
 class Bubble;
+class BubblePool;
+class BubbleGrid;
+class ContactSolver;
+class SpawnScheduler;
 class MyEventHandler;
+class RollbackSession;
+struct GameSnapshot;
+struct NetplayConfig;
 
 namespace nc = ncine;
 
@@ -33,6 +40,46 @@ class Game : public LogicNode
 	void onFrameStart();
 	void onQuitRequest();
 
+	/// Brings the match back to its initial state with the current settings, reusing every node and bubble
+	void reset();
+	/// The game scene is kept resident, an inactive game is neither updated nor drawn
+	void setActive(bool active);
+
+	/// Advances the match by one simulation step, the same inputs from the same state always lead to the same state
+	/*! Sounds and vibrations are muted when a step is simulated again after a rollback */
+	void step(float deltaTime, const PlayerInput inputs[2], bool resimulation);
+	/// Polls the input of both players, the second one is left empty in a single player match
+	void pollInputs(PlayerInput inputs[2]);
+	PlayerInput pollInput(unsigned int playerIndex);
+	/// Match duration in seconds, from the settings or from the host of a network match
+	inline unsigned int matchDuration() const { return matchDuration_; }
+
+	/// Starts connecting to a remote peer, the match starts when the connection has been established
+	void startNetplay(const NetplayConfig &config);
+	/// Called by the rollback session when both peers are ready, with the seed and duration chosen by the host
+	void startNetplayMatch(uint64_t seed, unsigned int matchDuration);
+	inline bool isNetplay() const { return rollback_ != nullptr; }
+
+	/// Captures the simulation state of the match, it never allocates
+	void saveSnapshot(GameSnapshot &snapshot) const;
+	/// Brings the simulation back to a captured state, bubbles are recycled through the pool
+	void restoreSnapshot(const GameSnapshot &snapshot);
+
+	/// Disables pausing and the end of the match, and lets the players be driven by bots
+	void setBenchmarkMode(bool enabled);
+	/// Bots play two players matches one after the other, until the game is left
+	void setAttractMode(bool enabled);
+	inline bool isAttractMode() const { return attractMode_; }
+	/// Overrides the spawn waves with a number of alive bubbles to reach, zero restores the waves
+	void setBubbleSpawnTarget(unsigned int numBubbles);
+	inline unsigned int numAliveBubbles() const { return bubbles_.size(); }
+	/// Also sets up the pause viewports again, in case shader effects are enabled while paused
+	inline void requestShaderEffectsChange()
+	{
+		requestShaderEffectsChange_ = true;
+		requestPauseShaderEffectsChange_ = true;
+	}
+
 	static void playSound();
 	static void killBubble(Bubble *bubblePtr);
 	static void incrementDroppedBubble();
@@ -44,12 +91,11 @@ class Game : public LogicNode
 	nctl::UniquePtr<nc::Sprite> background_;
 	nctl::UniquePtr<nc::Sprite> darkForeground_;
 	nctl::UniquePtr<Player> playerA_;
-	nctl::UniquePtr<Player> playerB_;
+	nctl::UniquePtr<Player> secondPlayer_;
+	/// The second player when the match has two players, `nullptr` otherwise
+	Player *playerB_;
 
-	nctl::UniquePtr<nc::Sprite> redBar_;
-	nctl::UniquePtr<nc::Sprite> redBarFill_;
-	nctl::UniquePtr<nc::Sprite> blueBar_;
-	nctl::UniquePtr<nc::Sprite> blueBarFill_;
+	nctl::UniquePtr<Hud> hud_;
 
 	nctl::UniquePtr<Body> obstacle1_;
 	nctl::UniquePtr<Body> obstacle2_;
@@ -61,25 +107,33 @@ class Game : public LogicNode
 	nctl::UniquePtr<nc::Sprite> obstacle3Gfx_;
 #endif
 
-	nctl::StaticArray<nctl::UniquePtr<Bubble>, Cfg::Game::BubblePoolSize> bubblePool_;
-	nctl::StaticArray<nctl::UniquePtr<Bubble>, Cfg::Game::BubblePoolSize> bubbles_;
-	nctl::StaticArray<Bubble*, Cfg::Game::BubblePoolSize> deadBubbles_;
+	nctl::UniquePtr<BubblePool> bubblePool_;
+	/// Alive bubbles, owned by the pool
+	nctl::Array<Bubble *> bubbles_;
+	nctl::Array<Bubble *> deadBubbles_;
+	/// The positions of the alive bubbles for the bots, filled once per step when a bot asks for it
+	nctl::UniquePtr<BubbleGrid> bubbleGrid_;
+	bool bubbleGridIsValid_;
+	nctl::UniquePtr<ContactSolver> contactSolver_;
+	nctl::UniquePtr<SpawnScheduler> spawnScheduler_;
 	nctl::StaticArray<nctl::UniquePtr<nc::AudioBufferPlayer>, Cfg::Sounds::NumBubblePopPlayers> poppingPlayers_;
 
-	nctl::UniquePtr<nc::Font> font_;
-	nctl::UniquePtr<nc::TextNode> timeText_;
-	nctl::UniquePtr<nc::TextNode> pointsAText_;
-	nctl::UniquePtr<nc::TextNode> pointsBText_;
-
 	nctl::UniquePtr<nc::SceneNode> backgroundRoot_;
 	nctl::UniquePtr<nc::SceneNode> sceneRoot_;
 	nctl::UniquePtr<nc::SceneNode> foregroundRoot_;
 
-	nc::TimeStamp matchTimer_;
-	nc::TimeStamp pauseTime_;
+	/// Seconds of simulation since the start of the match, it does not advance while paused
+	float matchTime_;
+	unsigned int matchDuration_;
 	bool paused_;
 	bool matchEnded_;
+	bool benchmarkMode_;
+	bool attractMode_;
+	unsigned int bubbleSpawnTarget_;
+	/// Set while resimulating after a rollback, when sounds and vibrations have already been played
+	bool muteEffects_;
 	Statistics statistics_;
+	nctl::UniquePtr<RollbackSession> rollback_;
 
 	nctl::UniquePtr<MenuPage> menuPage_;
 	static MenuPage::PageConfig pausePage_;
@@ -88,8 +142,19 @@ class Game : public LogicNode
 	static MenuPage::PageConfig quitConfirmationEndMatchPage_;
 
 	void loadScene();
-	void spawnBubbles();
-	void spawnBubble();
+	/// Activates the second player when needed, every player goes back to its starting state
+	void setupPlayers(unsigned int numPlayers);
+	void updateHud();
+	/// Kills every bubble and gives it back to the pool
+	void releaseBubbles();
+	/// The players and the obstacles, in the order used by snapshots
+	Body *fixedBody(unsigned int index) const;
+	void spawnBubbles(float deltaTime);
+	/// Takes a bubble from the pool and sets its variant, the bubble is not spawned yet
+	Bubble *acquireBubble(unsigned int variant);
+	bool spawnBubble(const nc::Vector2f &pos, unsigned int variant);
+	void setupNewBubbles(unsigned int firstIndex);
+	void updateBubbleGrid();
 	void destroyDeadBubbles();
 	void playPoppingSound();
 	void setSfxVolume();
@@ -99,6 +164,8 @@ class Game : public LogicNode
 	void saveStatistics();
 
 	bool requestMenu_ = false;
+	/// A new match starts in place on the next frame, without leaving the game scene
+	bool requestRematch_ = false;
 	bool requestShaderEffectsChange_ = false;
 	bool requestPauseShaderEffectsChange_ = false;
 	bool shaderEffectsEnabled_ = false;
@@ -0,0 +1,162 @@
+#include <ncine/config.h>
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	#include <ncine/imgui.h>
+#endif
+
+#include "Hud.h"
+#include "Label.h"
+#include "../Config.h"
+#include "../ResourceManager.h"
+
+#include <ncine/Application.h>
+#include <ncine/Texture.h>
+#include <ncine/Sprite.h>
+
+namespace {
+	nctl::String auxString(32);
+}
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS AND DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+Hud::Hud(SceneNode *parent, nctl::String name, unsigned int numPlayers, int secondsLeft)
+    : LogicNode(parent, name), numPlayers_(numPlayers), lastSecondsLeft_(secondsLeft),
+      numSpriteUpdates_(0), numTextUpdates_(0)
+{
+#ifndef __EMSCRIPTEN__
+	const float screenWidth = nc::theApplication().gfxDevice().width();
+	const float screenHeight = nc::theApplication().gfxDevice().height();
+#else
+	const float screenWidth = nc::theApplication().gfxDevice().drawableWidth();
+	const float screenHeight = nc::theApplication().gfxDevice().drawableHeight();
+#endif
+	const nc::Vector2f screenTopRight(screenWidth, screenHeight);
+
+	char const * const barTextures[MaxPlayers] = { Cfg::Textures::RedBar, Cfg::Textures::BlueBar };
+	char const * const barFillTextures[MaxPlayers] = { Cfg::Textures::RedBarFill, Cfg::Textures::BlueBarFill };
+	const nc::Vector2f barRelativePositions[MaxPlayers] = { Cfg::Gui::RedBarRelativePos, Cfg::Gui::BlueBarRelativePos };
+	const nc::Vector2f pointsRelativePositions[MaxPlayers] = { Cfg::Gui::PointsATextRelativePos, Cfg::Gui::PointsBTextRelativePos };
+
+	// The elements of both players are created, the ones of the second player are hidden in a single player match
+	for (unsigned int i = 0; i < MaxPlayers; i++)
+	{
+		bars_[i] = nctl::makeUnique<nc::Sprite>(this, resourceManager().retrieveTexture(barTextures[i]));
+		bars_[i]->setLayer(Cfg::Layers::Gui_StaminaBar);
+		bars_[i]->setPosition(screenTopRight * barRelativePositions[i]);
+		bars_[i]->setScale(Cfg::Gui::BarScale);
+
+		barFills_[i] = nctl::makeUnique<nc::Sprite>(this, resourceManager().retrieveTexture(barFillTextures[i]));
+		barFills_[i]->setLayer(Cfg::Layers::Gui_StaminaBar_Fill);
+		barFills_[i]->setPosition(screenTopRight * barRelativePositions[i]);
+		barFills_[i]->setScale(Cfg::Gui::BarScale);
+
+		pointsTexts_[i] = nctl::makeUnique<Label>(this, ResourceManager::FontSize::MENU, 256);
+		pointsTexts_[i]->setLayer(Cfg::Layers::Gui_Text);
+		pointsTexts_[i]->setString("0");
+		pointsTexts_[i]->setPosition((screenTopRight - pointsTexts_[i]->absSize() * 0.5f) * pointsRelativePositions[i]);
+
+		lastFillWidths_[i] = bars_[i]->texRect().w;
+		lastPoints_[i] = 0;
+	}
+
+	timeText_ = nctl::makeUnique<Label>(this, ResourceManager::FontSize::MENU, 256);
+	timeText_->setLayer(Cfg::Layers::Gui_Text);
+	auxString.format("%d", secondsLeft);
+	timeText_->setString(auxString);
+	timeText_->setPosition((screenTopRight - timeText_->absSize() * 0.5f) * Cfg::Gui::TimeTextRelativePos);
+
+	reset(numPlayers, secondsLeft);
+}
+
+///////////////////////////////////////////////////////////
+// PUBLIC FUNCTIONS
+///////////////////////////////////////////////////////////
+
+void Hud::reset(unsigned int numPlayers, int secondsLeft)
+{
+	FATAL_ASSERT(numPlayers > 0 && numPlayers <= MaxPlayers);
+	numPlayers_ = numPlayers;
+
+	for (unsigned int i = 0; i < MaxPlayers; i++)
+	{
+		const bool enabled = (i < numPlayers_);
+		bars_[i]->setEnabled(enabled);
+		barFills_[i]->setEnabled(enabled);
+		pointsTexts_[i]->setEnabled(enabled);
+
+		barFills_[i]->setTexRect(bars_[i]->texRect());
+		barFills_[i]->setPosition(bars_[i]->position());
+		lastFillWidths_[i] = bars_[i]->texRect().w;
+		if (lastPoints_[i] != 0)
+		{
+			pointsTexts_[i]->setString("0");
+			lastPoints_[i] = 0;
+		}
+	}
+
+	setSecondsLeft(secondsLeft);
+}
+
+void Hud::setStamina(unsigned int playerIndex, float stamina)
+{
+	ASSERT(playerIndex < numPlayers_);
+	const nc::Sprite &bar = *bars_[playerIndex];
+	nc::Sprite &barFill = *barFills_[playerIndex];
+
+	const int fillWidth = static_cast<int>(bar.texRect().w * stamina);
+	if (fillWidth == lastFillWidths_[playerIndex])
+		return;
+	lastFillWidths_[playerIndex] = fillWidth;
+
+	// The red bar of player A empties towards the left, the blue one of player B towards the right
+	nc::Recti fillRect = bar.texRect();
+	nc::Vector2f fillPos = bar.position();
+	const float emptyOffset = (bar.width() * (1.0f - stamina)) * 0.5f;
+	fillRect.w = fillWidth;
+	if (playerIndex == 0)
+	{
+		fillRect.x += bar.texRect().w - fillRect.w;
+		fillPos.x += emptyOffset;
+	}
+	else
+		fillPos.x -= emptyOffset;
+
+	barFill.setTexRect(fillRect);
+	barFill.setPosition(fillPos);
+	numSpriteUpdates_++;
+}
+
+void Hud::setPoints(unsigned int playerIndex, int points)
+{
+	ASSERT(playerIndex < numPlayers_);
+	if (points == lastPoints_[playerIndex])
+		return;
+	lastPoints_[playerIndex] = points;
+
+	auxString.format("%d", points);
+	pointsTexts_[playerIndex]->setString(auxString);
+	numTextUpdates_++;
+}
+
+void Hud::setSecondsLeft(int seconds)
+{
+	if (seconds == lastSecondsLeft_)
+		return;
+	lastSecondsLeft_ = seconds;
+
+	auxString.format("%d", seconds);
+	timeText_->setString(auxString);
+	numTextUpdates_++;
+}
+
+void Hud::drawGui()
+{
+#if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
+	if (ImGui::TreeNode("HUD"))
+	{
+		ImGui::Text("Sprite updates: %u, Text updates: %u", numSpriteUpdates_, numTextUpdates_);
+		ImGui::TreePop();
+	}
+#endif
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "LogicNode.h"
+
+namespace ncine {
+	class Sprite;
+}
+class Label;
+
+namespace nc = ncine;
+
+/// The in-game HUD with stamina bars, points and remaining time
+/*! The last shown values are cached, sprites and text nodes are only touched when they change. */
+class Hud : public LogicNode
+{
+  public:
+	Hud(SceneNode *parent, nctl::String name, unsigned int numPlayers, int secondsLeft);
+
+	/// Shows the elements of the players in the match, with full stamina bars and no points
+	void reset(unsigned int numPlayers, int secondsLeft);
+	void setStamina(unsigned int playerIndex, float stamina);
+	void setPoints(unsigned int playerIndex, int points);
+	void setSecondsLeft(int seconds);
+
+	void drawGui();
+
+  private:
+	static const unsigned int MaxPlayers = 2;
+
+	unsigned int numPlayers_;
+
+	nctl::UniquePtr<nc::Sprite> bars_[MaxPlayers];
+	nctl::UniquePtr<nc::Sprite> barFills_[MaxPlayers];
+	nctl::UniquePtr<Label> pointsTexts_[MaxPlayers];
+	nctl::UniquePtr<Label> timeText_;
+
+	/// Stamina is quantized to the number of visible texels of the fill sprite
+	int lastFillWidths_[MaxPlayers];
+	int lastPoints_[MaxPlayers];
+	int lastSecondsLeft_;
+
+	unsigned int numSpriteUpdates_;
+	unsigned int numTextUpdates_;
+};
@@ -0,0 +1,13 @@
+#include "Label.h"
+
+#include <ncine/Font.h>
+
+///////////////////////////////////////////////////////////
+// CONSTRUCTORS AND DESTRUCTOR
+///////////////////////////////////////////////////////////
+
+Label::Label(SceneNode *parent, ResourceManager::FontSize size, unsigned int maxStringLength)
+    : nc::TextNode(parent, resourceManager().retrieveFont(size), maxStringLength)
+{
+	setRenderMode(nc::Font::RenderMode::GLYPH_SPRITE);
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <ncine/TextNode.h>
+#include "../ResourceManager.h"
+
+namespace nc = ncine;
+
+/// A text node that uses the shared Modak font at one of the game text sizes
+class Label : public nc::TextNode
+{
+  public:
+	Label(SceneNode *parent, ResourceManager::FontSize size, unsigned int maxStringLength);
+};
@@ -6,6 +6,8 @@
 #include "version.h"
 
 #include "Menu.h"
+#include "Label.h"
+#include "../RenderStats.h"
 #include "../main.h"
 #include "../Config.h"
 #include "../ResourceManager.h"
@@ -20,11 +22,8 @@
 #include <nctl/HashSet.h>
 #include <ncine/InputEvents.h>
 #include <ncine/Application.h>
-#include <ncine/FileSystem.h>
 #include <ncine/Random.h>
 #include <ncine/Sprite.h>
-#include <ncine/Font.h>
-#include <ncine/TextNode.h>
 
 namespace {
 	Menu *menuPtr = nullptr;
@@ -241,7 +240,6 @@ MenuPage::PageConfig Menu::creditsPage_;
 Menu::Menu(SceneNode *parent, nctl::String name, MyEventHandler *eventHandler)
     : LogicNode(parent, name), eventHandler_(eventHandler)
 {
-	static_assert(Menu::NumBubbles <= Cfg::Game::BubblePoolSize, "Cannot have more bubbles than the pool size");
 	menuPtr = this;
 
 #ifndef __EMSCRIPTEN__
@@ -269,29 +267,20 @@ Menu::Menu(SceneNode *parent, nctl::String name, MyEventHandler *eventHandler)
 	darkForeground_->setColor(0, 0, 0, 128);
 	darkForeground_->setLayer(Cfg::Layers::Background + 2);
 
-	const nctl::String titleFontFntPath_ = nc::fs::joinPath(nc::fs::dataPath(), Cfg::Fonts::Modak200Fnt);
-	titleFont_ = nctl::makeUnique<nc::Font>(titleFontFntPath_.data(), resourceManager().retrieveTexture(Cfg::Fonts::Modak200Png));
-
-	const nctl::String smallFontFntPath_ = nc::fs::joinPath(nc::fs::dataPath(), Cfg::Fonts::Modak20Fnt);
-	smallFont_ = nctl::makeUnique<nc::Font>(smallFontFntPath_.data(), resourceManager().retrieveTexture(Cfg::Fonts::Modak20Png));
-
-	gameTitleText_ = nctl::makeUnique<nc::TextNode>(this, titleFont_.get(), 32);
+	gameTitleText_ = nctl::makeUnique<Label>(this, ResourceManager::FontSize::TITLE, 32);
 	gameTitleText_->setLayer(Cfg::Layers::Gui_Text);
-	gameTitleText_->setRenderMode(nc::Font::RenderMode::GLYPH_SPRITE);
 	gameTitleText_->setString("Wet Paper");
 	gameTitleText_->setPosition(screenTopRight.x * 0.5f, screenTopRight.y * 0.75f);
 
 	nctl::String versionString(64);
 	versionString.format("Wet Paper r%s.%s (%s)", VersionStrings::GitRevCount, VersionStrings::GitShortHash, VersionStrings::CompilationDate);
-	versionText_ = nctl::makeUnique<nc::TextNode>(this, smallFont_.get(), 64);
+	versionText_ = nctl::makeUnique<Label>(this, ResourceManager::FontSize::SMALL, 64);
 	versionText_->setLayer(Cfg::Layers::Gui_Text);
-	versionText_->setRenderMode(nc::Font::RenderMode::GLYPH_SPRITE);
 	versionText_->setString(versionString);
 	versionText_->setPosition(screenTopRight.x - versionText_->width() * 0.5f, versionText_->height() * 0.75f);
 
-	statusText_ = nctl::makeUnique<nc::TextNode>(this, smallFont_.get(), 64);
+	statusText_ = nctl::makeUnique<Label>(this, ResourceManager::FontSize::SMALL, 64);
 	statusText_->setLayer(Cfg::Layers::Gui_Text);
-	statusText_->setRenderMode(nc::Font::RenderMode::GLYPH_SPRITE);
 	statusText_->setEnabled(false);
 
 	menuPage_ = nctl::makeUnique<MenuPage>(this, "MenuPage");
@@ -380,6 +369,16 @@ void Menu::onTick(float deltaTime)
 		bubble.move(bubbleDirection * speed);
 	}
 
+	// Rebinding a control can take a while, it does not count as being idle
+	if (rebindingState == RebindingState::NOT_REBINDING)
+	{
+		idleTime_ += deltaTime;
+		if (idleTime_ >= Cfg::Menu::AttractModeIdleTime && requestGame_ == false)
+			requestAttractMode_ = true;
+	}
+	else
+		idleTime_ = 0.0f;
+
 	if (statusText_->isEnabled())
 		statusText_->setPosition(screenWidth * 0.5f - statusText_->width() * 0.5f, statusText_->height() * 0.75f * 10);
 
@@ -399,6 +398,7 @@ void Menu::drawGui()
 {
 #if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
 	ImGui::Text("Version: r%s.%s (%s)", VersionStrings::GitRevCount, VersionStrings::GitShortHash, VersionStrings::CompilationDate);
+	RenderStats::collect().drawGui();
 
 	if (ImGui::Button("Toggle shaders"))
 	{
@@ -406,6 +406,10 @@ void Menu::drawGui()
 		settings.withShaders = !settings.withShaders;
 		requestShaderEffectsChange_ = true;
 	}
+	ImGui::Text("Idle time: %.1f / %.1f s", idleTime_, Cfg::Menu::AttractModeIdleTime);
+	ImGui::SameLine();
+	if (ImGui::Button("Attract mode"))
+		requestAttractMode_ = true;
 	ImGui::NewLine();
 
 	menuPage_->drawGui();
@@ -416,6 +420,7 @@ void Menu::onKeyPressed(const nc::KeyboardEvent &event)
 {
 	FATAL_ASSERT(menuPtr != nullptr);
 	FATAL_ASSERT(menuPagePtr != nullptr);
+	idleTime_ = 0.0f;
 
 	// Also accepting `REBINDING_JOY` state to use Escape when binding a gamepad control
 	if ((rebindingState != RebindingState::REBINDING_KEY && rebindingState != RebindingState::REBINDING_JOY) || rebindActionId == InputBinder::InvalidId)
@@ -448,6 +453,7 @@ void Menu::onJoyMappedButtonPressed(const nc::JoyMappedButtonEvent &event)
 {
 	FATAL_ASSERT(menuPtr != nullptr);
 	FATAL_ASSERT(menuPagePtr != nullptr);
+	idleTime_ = 0.0f;
 
 	const bool joyIdIsValid = (event.joyId >= 0 && event.joyId <= 1);
 	if (rebindingState != RebindingState::REBINDING_JOY || rebindActionId == InputBinder::InvalidId || !joyIdIsValid)
@@ -489,6 +495,8 @@ void Menu::onJoyMappedAxisMoved(const nc::JoyMappedAxisEvent &event)
 	FATAL_ASSERT(menuPagePtr != nullptr);
 
 	const bool axisMoved = (event.value >= InputBinder::PressedAxisThreshold) || (event.value <= -InputBinder::PressedAxisThreshold);
+	if (axisMoved)
+		idleTime_ = 0.0f;
 	const bool joyIdIsValid = (event.joyId >= 0 && event.joyId <= 1);
 	if (rebindingState != RebindingState::REBINDING_JOY || rebindActionId == InputBinder::InvalidId || !axisMoved || !joyIdIsValid)
 		return;
@@ -526,7 +534,7 @@ void Menu::onFrameStart()
 {
 	if (requestShaderEffectsChange_)
 	{
-		enableShaderEffects(eventHandler_->settings().withShaders);
+		enableShaderEffects(eventHandler_->withShaders());
 		requestShaderEffectsChange_ = false;
 	}
 
@@ -536,6 +544,12 @@ void Menu::onFrameStart()
 		eventHandler_->requestGame();
 		requestGame_ = false;
 	}
+	else if (requestAttractMode_)
+	{
+		enableShaderEffects(false);
+		eventHandler_->requestAttractMode();
+		requestAttractMode_ = false;
+	}
 
 	if (deferShaderEffectsChange)
 	{
@@ -550,6 +564,21 @@ void Menu::onQuitRequest()
 	menuPagePtr->setup(quitConfirmationPage_);
 }
 
+void Menu::setActive(bool active)
+{
+	setEnabled(active);
+	requestGame_ = false;
+	requestAttractMode_ = false;
+	idleTime_ = 0.0f;
+	if (active)
+	{
+		menuPage_->setup(mainPage_);
+		requestShaderEffectsChange_ = true;
+	}
+	else
+		enableShaderEffects(false);
+}
+
 ///////////////////////////////////////////////////////////
 // PRIVATE FUNCTIONS
 ///////////////////////////////////////////////////////////
@@ -575,7 +604,7 @@ void Menu::enableShaderEffects(bool enabled)
 		{
 			nc::Sprite *bubble = bubbles_[i].get();
 			bubble->setParent(sceneRoot_.get());
-			eventHandler_->shaderEffects().setBubbleShader(bubble, i);
+			eventHandler_->shaderEffects().setBubbleShader(bubble, i, bubbleVariants_[i]);
 		}
 
 		eventHandler_->shaderEffects().setupMenuViewports(this, backgroundRoot_.get(), sceneRoot_.get(), foregroundRoot_.get());
@@ -597,6 +626,7 @@ void Menu::enableShaderEffects(bool enabled)
 			nc::Sprite *bubble = bubbles_[i].get();
 			nc::Texture *tex = resourceManager().retrieveTexture(Cfg::Textures::Bubbles[bubbleVariants_[i]]);
 			bubble->setTexture(tex);
+			bubble->setTexRect(nc::Recti(0, 0, tex->width(), tex->height()));
 			bubble->setParent(this);
 			eventHandler_->shaderEffects().clearBubbleShader(i);
 		}
@@ -1088,15 +1118,20 @@ void Menu::settingsShadersFunc(MenuPage::EntryEvent &event)
 {
 	FATAL_ASSERT(menuPtr != nullptr);
 	const Settings &settings = menuPtr->eventHandler_->settings();
-	bool withShaders = settings.withShaders;
+	// Level zero disables shaders, the others select a pause blur quality from the lowest to the highest
+	const unsigned int numLevels = Cfg::Settings::NumBlurQualities + 1;
+	const unsigned int currentLevel = settings.withShaders ? numLevels - 1 - settings.blurQuality : 0;
+	unsigned int level = currentLevel;
 
 	switch (event.type)
 	{
 		case MenuPage::EventType::LEFT:
-			withShaders = false;
+			if (level > 0)
+				level--;
 			break;
 		case MenuPage::EventType::RIGHT:
-			withShaders = true;
+			if (level < numLevels - 1)
+				level++;
 			break;
 		default:
 			break;
@@ -1106,17 +1141,27 @@ void Menu::settingsShadersFunc(MenuPage::EntryEvent &event)
 	{
 		case MenuPage::EventType::LEFT:
 		case MenuPage::EventType::RIGHT:
-			if (withShaders != settings.withShaders)
+			if (level != currentLevel)
 			{
 				Settings &settingsMut = menuPtr->eventHandler_->settingsMut();
-				settingsMut.withShaders = withShaders;
-				menuPtr->requestShaderEffectsChange_ = true;
+				const bool withShaders = (level > 0);
+				if (withShaders != settings.withShaders)
+				{
+					settingsMut.withShaders = withShaders;
+					menuPtr->requestShaderEffectsChange_ = true;
+				}
+				if (withShaders)
+				{
+					settingsMut.blurQuality = numLevels - 1 - level;
+					menuPtr->eventHandler_->shaderEffects().setBlurQuality(static_cast<ShaderEffects::BlurQuality>(settingsMut.blurQuality));
+				}
 				event.shouldUpdateEntryText = true;
 			}
 			break;
 		case MenuPage::EventType::TEXT:
 		{
-			event.entryText.format(withShaders ? "< Shaders: on" : "Shaders: off >");
+			static char const * const levelNames[numLevels] = { "off", "low", "medium", "high" };
+			event.entryText.format("%sShaders: %s%s", (level > 0) ? "< " : "", levelNames[level], (level < numLevels - 1) ? " >" : "");
 			break;
 		}
 		default:
@@ -11,10 +11,9 @@ namespace ncine {
 	class JoyMappedAxisEvent;
 
 	class Sprite;
-	class Font;
-	class TextNode;
 }
 class MyEventHandler;
+class Label;
 
 namespace nc = ncine;
 
@@ -33,6 +32,10 @@ class Menu : public LogicNode
 
 	void onFrameStart();
 	void onQuitRequest();
+	/// The menu scene is kept resident, an active menu starts again from the main page
+	void setActive(bool active);
+
+	inline void requestShaderEffectsChange() { requestShaderEffectsChange_ = true; }
 
   private:
 	MyEventHandler *eventHandler_;
@@ -40,12 +43,9 @@ class Menu : public LogicNode
 	nctl::UniquePtr<nc::Sprite> background_;
 	nctl::UniquePtr<nc::Sprite> darkForeground_;
 
-	nctl::UniquePtr<nc::Font> titleFont_;
-	nctl::UniquePtr<nc::TextNode> gameTitleText_;
-
-	nctl::UniquePtr<nc::Font> smallFont_;
-	nctl::UniquePtr<nc::TextNode> versionText_;
-	nctl::UniquePtr<nc::TextNode> statusText_;
+	nctl::UniquePtr<Label> gameTitleText_;
+	nctl::UniquePtr<Label> versionText_;
+	nctl::UniquePtr<Label> statusText_;
 
 	nctl::UniquePtr<nc::SceneNode> backgroundRoot_;
 	nctl::UniquePtr<nc::SceneNode> sceneRoot_;
@@ -71,6 +71,9 @@ class Menu : public LogicNode
 	nctl::StaticArray<unsigned int, NumBubbles> bubbleVariants_;
 
 	bool requestGame_ = false;
+	/// Seconds since the last input, bots start playing when it gets too long
+	float idleTime_ = 0.0f;
+	bool requestAttractMode_ = false;
 	bool requestShaderEffectsChange_ = false;
 	bool shaderEffectsEnabled_ = false;
 	void enableShaderEffects(bool enabled);
@@ -4,15 +4,13 @@
 #endif
 
 #include "MenuPage.h"
+#include "Label.h"
 #include "../Config.h"
 #include "../ResourceManager.h"
 #include "../InputBinder.h"
 #include "../InputActions.h"
 
 #include <nctl/CString.h>
-#include <ncine/Font.h>
-#include <ncine/TextNode.h>
-#include <ncine/FileSystem.h>
 #include <ncine/AudioBufferPlayer.h>
 
 #if NCINE_WITH_IMGUI && defined(NCPROJECT_DEBUG)
@@ -28,12 +26,8 @@ namespace {
 MenuPage::MenuPage(SceneNode *parent, nctl::String name)
     : LogicNode(parent, name), hoveredEntry_(0), actionsEnabled_(true)
 {
-	const nctl::String menuFontFntPath_ = nc::fs::joinPath(nc::fs::dataPath(), Cfg::Fonts::Modak50Fnt);
-	menuFont_ = nctl::makeUnique<nc::Font>(menuFontFntPath_.data(), resourceManager().retrieveTexture(Cfg::Fonts::Modak50Png));
-
-	titleTextNode_ = nctl::makeUnique<nc::TextNode>(this, menuFont_.get(), Cfg::Menu::MaxMenuEntryLength);
+	titleTextNode_ = nctl::makeUnique<Label>(this, ResourceManager::FontSize::MENU, Cfg::Menu::MaxMenuEntryLength);
 	titleTextNode_->setLayer(Cfg::Layers::Menu_Page);
-	titleTextNode_->setRenderMode(nc::Font::RenderMode::GLYPH_SPRITE);
 	titleTextNode_->setAlignment(nc::TextNode::Alignment::CENTER);
 	titleTextNode_->setEnabled(false);
 	titleTextNode_->setScale(1.25f);
@@ -41,9 +35,8 @@ MenuPage::MenuPage(SceneNode *parent, nctl::String name)
 
 	for (unsigned int i = 0; i < MaxNumEntries; i++)
 	{
-		nctl::UniquePtr<nc::TextNode> textNode = nctl::makeUnique<nc::TextNode>(this, menuFont_.get(), Cfg::Menu::MaxMenuEntryLength);
+		nctl::UniquePtr<Label> textNode = nctl::makeUnique<Label>(this, ResourceManager::FontSize::MENU, Cfg::Menu::MaxMenuEntryLength);
 		textNode->setLayer(Cfg::Layers::Menu_Page);
-		textNode->setRenderMode(nc::Font::RenderMode::GLYPH_SPRITE);
 		textNode->setAlignment(nc::TextNode::Alignment::CENTER);
 		textNode->setEnabled(false);
 
@@ -109,7 +102,7 @@ void MenuPage::setup(const PageConfig &config)
 			entry.eventFunc(event);
 		}
 
-		nc::TextNode &textNode = *entryTextNodes_[i];
+		Label &textNode = *entryTextNodes_[i];
 		textNode.setString(entry.text);
 		textNode.setEnabled(true);
 		verticalPos -= textNode.height();
@@ -142,8 +135,10 @@ void MenuPage::updateEntryText(unsigned int entryIndex)
 		entry.eventFunc(event);
 		FATAL_ASSERT(event.shouldUpdateEntryText == false);
 
+		// Setting the same string would lay out the glyphs again
 		nc::TextNode &textNode = *entryTextNodes_[entryIndex];
-		textNode.setString(entry.text);
+		if (textNode.string() != entry.text)
+			textNode.setString(entry.text);
 	}
 }
 
@@ -5,11 +5,10 @@
 #include <nctl/BitSet.h>
 
 namespace ncine {
-	class Font;
-	class TextNode;
 	class AudioBufferPlayer;
 }
 class Menu;
+class Label;
 
 namespace nc = ncine;
 
@@ -79,9 +78,8 @@ class MenuPage : public LogicNode
 
   private:
 	PageConfig config_;
-	nctl::UniquePtr<nc::Font> menuFont_;
-	nctl::UniquePtr<nc::TextNode> titleTextNode_;
-	nctl::StaticArray<nctl::UniquePtr<nc::TextNode>, MaxNumEntries> entryTextNodes_;
+	nctl::UniquePtr<Label> titleTextNode_;
+	nctl::StaticArray<nctl::UniquePtr<Label>, MaxNumEntries> entryTextNodes_;
 
 	nctl::UniquePtr<nc::AudioBufferPlayer> clickSoundPlayer_;
 	nctl::UniquePtr<nc::AudioBufferPlayer> selectSoundPlayer_;
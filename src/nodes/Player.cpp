@@ -7,10 +7,12 @@
 #include "Body.h"
 #include "Game.h"
 #include "Bubble.h"
+#include "../GameSnapshot.h"
 #include "../ResourceManager.h"
 #include "../Config.h"
 #include "../InputBinder.h"
 #include "../InputActions.h"
+#include "../PlayerMovement.h"
 
 #include <ncine/Texture.h>
 #include <ncine/Application.h>
@@ -31,21 +33,25 @@ namespace {
 
 Player::Player(nc::SceneNode *parent, nctl::String name, int playerIndex)
     : LogicNode(parent, name),
-      index_(playerIndex), stamina_(1.0f), points_(0),
-      dashEnergy_(0.0f), dashDir_(0.0f, 0.0f), jumpCount_(0)
+      index_(playerIndex), bindingsIndex_(playerIndex), stamina_(1.0f), points_(0),
+      dashEnergy_(0.0f), dashDir_(0.0f, 0.0f), jumpCount_(0), autopilot_(false)
 {
+	// Every player has its own bot sequence, so that two bots do not make the same choices
+	bot_.seed(1, static_cast<uint64_t>(playerIndex));
+
 	// Setup the physics body
 	{
 		body_ = nctl::makeUnique<Body>(this, "Body", ColliderKind::CIRCLE, BodyKind::DYNAMIC, BodyId::PLAYER);
 
 		if (playerIndex == 0)
-			body_->setPosition(body_->colliderHalfSize_.x * 2.0f, body_->colliderHalfSize_.y * 2.1f);
+			startPosition_.set(body_->colliderHalfSize_.x * 2.0f, body_->colliderHalfSize_.y * 2.1f);
 		if (playerIndex == 1)
-			body_->setPosition(nc::theApplication().gfxDevice().width() - body_->colliderHalfSize_.x * 2.0f, body_->colliderHalfSize_.y * 2.1f);
+			startPosition_.set(nc::theApplication().gfxDevice().width() - body_->colliderHalfSize_.x * 2.0f, body_->colliderHalfSize_.y * 2.1f);
+		body_->setPosition(startPosition_);
 
-		body_->linearVelocityDamping_ = 0.01f;
-		body_->maxVelocity_ = 2000.0f;
-		body_->colliderHalfSize_ = nc::Vector2f(64.0f, 0.0f);
+		body_->linearVelocityDamping_ = Cfg::Player::StartDamping;
+		body_->maxVelocity_ = Cfg::Player::MaxVelocity;
+		body_->colliderHalfSize_ = nc::Vector2f(Cfg::Player::Radius, 0.0f);
 	}
 
 	// Setup the sprite frames
@@ -73,123 +79,92 @@ Player::Player(nc::SceneNode *parent, nctl::String name, int playerIndex)
 // PUBLIC FUNCTIONS
 ///////////////////////////////////////////////////////////
 
-void Player::onTick(float deltaTime)
+void Player::reset()
 {
-	// Compute the new movement direction
-	{
-		bool leftDown = false;
-		bool rightDown = false;
-		bool jumpPressed = false;
-		bool dashPressed = false;
-
-		InputBinder &ib = inputBinder();
-		const InputActions &ia = inputActions();
-
-		leftDown = (ib.isTriggered(index_ ? ia.P2_LEFT : ia.P1_LEFT));
-		rightDown = (ib.isTriggered(index_ ? ia.P2_RIGHT : ia.P1_RIGHT));
-		jumpPressed = (ib.isTriggered(index_ ? ia.P2_JUMP : ia.P1_JUMP));
-		dashPressed = (ib.isTriggered(index_ ? ia.P2_DASH : ia.P1_DASH));
-
-		if (body_->isGrounded())
-		{
-			if (body_->linearVelocity_.y < 0.0f)
-			{
-				// We're going down and touching the floor, let's reset the jump count
-				jumpCount_ = 0; // reset the jump count
-			}
-
-			body_->linearVelocityDamping_ = 0.2f; // drag active
-			body_->gravity_ = nc::Vector2f::Zero; // no gravity
-
-			if (leftDown)
-			{
-				if (body_->linearVelocity_.x > 0.0f)
-					body_->linearVelocity_.x *= 0.8f;
-
-				body_->linearVelocity_ += nc::Vector2f(-1.0f, 0.0f) * Cfg::Player::MaxGroundMoveSpeed;
-			}
-
-			if (rightDown)
-			{
-				if (body_->linearVelocity_.x < 0.0f)
-					body_->linearVelocity_.x *= 0.8f;
-
-				body_->linearVelocity_ += nc::Vector2f(1.0f, 0.0f) * Cfg::Player::MaxGroundMoveSpeed;
-			}
-
-			if (jumpPressed)
-			{
-				jumpCount_++;
-				statistics_.numJumps++;
-
-				body_->linearVelocity_.y = 0.0f; // removing the Y component
-				body_->linearVelocity_ += nc::Vector2f(0.0f, 1.0f) * Cfg::Player::JumpVelocity;
-			}
-		}
-		else
-		{
-			body_->linearVelocityDamping_ = 1.0f; // no drag
-			body_->gravity_ = nc::Vector2f(0.0f, -1250.0f); // normal gravity
-
-			if (leftDown)
-			{
-				if (body_->linearVelocity_.x > 0.0f)
-					body_->linearVelocity_.x *= 0.8f;
-
-				body_->linearVelocity_ += nc::Vector2f(-1.0f, 0.0f) * Cfg::Player::MaxAirMoveSpeed;
-			}
-
-			if (rightDown)
-			{
-				if (body_->linearVelocity_.x < 0.0f)
-					body_->linearVelocity_.x *= 0.8f;
-
-				body_->linearVelocity_ += nc::Vector2f(1.0f, 0.0f) * Cfg::Player::MaxAirMoveSpeed;
-			}
+	stamina_ = 1.0f;
+	points_ = 0;
+	dashEnergy_ = 0.0f;
+	dashDir_ = nc::Vector2f::Zero;
+	jumpCount_ = 0;
+	autopilot_ = false;
+	bot_.reset();
+	bindingsIndex_ = index_;
+	statistics_ = {};
+
+	body_->setPosition(startPosition_);
+	body_->linearVelocity_ = nc::Vector2f::Zero;
+	sprite_->setFlippedX(false);
+	sprite_->setPaused(true);
+	sprite_->setFrame(0);
+	setUpdateEnabled(true);
+}
 
-			if (jumpPressed && jumpCount_ < Cfg::Player::MaxJumpCount)
-			{
-				jumpCount_++;
-				statistics_.numDoubleJumps++;
+void Player::setActive(bool active)
+{
+	setEnabled(active);
+	if (active)
+		body_->addToAll();
+	else
+		body_->removeFromAll();
+}
 
-				body_->linearVelocity_.y = 0.0f; // removing the Y component
-				body_->linearVelocity_ += nc::Vector2f(0.0f, 1.0f) * Cfg::Player::JumpVelocity;
-			}
-		}
+void Player::saveSnapshot(PlayerSnapshot &snapshot) const
+{
+	snapshot.position = body_->position();
+	snapshot.linearVelocity = body_->linearVelocity_;
+	snapshot.linearVelocityDamping = body_->linearVelocityDamping_;
+	snapshot.gravity = body_->gravity_;
+	snapshot.stamina = stamina_;
+	snapshot.points = points_;
+	snapshot.dashEnergy = dashEnergy_;
+	snapshot.dashDir = dashDir_;
+	snapshot.jumpCount = jumpCount_;
+	snapshot.flippedX = sprite_->isFlippedX();
+	snapshot.statistics = statistics_;
+}
 
-		if (dashPressed && stamina_ >= Cfg::Player::DashStaminaCost)
-		{
-			stamina_ -= Cfg::Player::DashStaminaCost;
-			dashEnergy_ = Cfg::Player::DashDuration;
-			statistics_.numDashes++;
-
-			if (leftDown)
-			{
-				dashDir_ = nc::Vector2f(-1.0f, 0.0f);
-				if (body_->linearVelocity_.x > 0)
-					body_->linearVelocity_.x *= 0.5f;
-			}
-			else if (rightDown)
-			{
-				dashDir_ = nc::Vector2f(1.0f, 0.0f);
-				if (body_->linearVelocity_.x < 0)
-					body_->linearVelocity_.x *= 0.5f;
-			}
-			else
-			{
-				// no explicit direction, let's use current velocity
-				dashDir_ = nc::Vector2f((body_->linearVelocity_.x <= 0.0f) ? -1.0f : 1.0f, 0.0f);
-			}
-		}
+void Player::restoreSnapshot(const PlayerSnapshot &snapshot)
+{
+	body_->setPosition(snapshot.position);
+	body_->linearVelocity_ = snapshot.linearVelocity;
+	body_->linearVelocityDamping_ = snapshot.linearVelocityDamping;
+	body_->gravity_ = snapshot.gravity;
+	stamina_ = snapshot.stamina;
+	points_ = snapshot.points;
+	dashEnergy_ = snapshot.dashEnergy;
+	dashDir_ = snapshot.dashDir;
+	jumpCount_ = snapshot.jumpCount;
+	sprite_->setFlippedX(snapshot.flippedX);
+	statistics_ = snapshot.statistics;
+}
 
-		if (dashEnergy_ > 0.0f)
-		{
-			dashEnergy_ -= deltaTime;
-			body_->linearVelocity_ += dashDir_ * Cfg::Player::MaxDashVelocity;
-		}
+PlayerInput Player::pollInput(const BubbleGrid &bubbles)
+{
+	return autopilot_ ? botInput(bubbles) : boundInput();
+}
 
-		const float regen = (Cfg::Player::MaxStamina / Cfg::Player::StaminaRegenTime) * deltaTime;
-		stamina_ = fminf(stamina_ + regen, Cfg::Player::MaxStamina);
+void Player::simulate(float deltaTime, const PlayerInput &input)
+{
+	// Compute the new movement direction, with the same rule as the headless arenas
+	{
+		PlayerMotion motion;
+		motion.velocity = body_->linearVelocity_;
+		motion.damping = body_->linearVelocityDamping_;
+		motion.gravity = body_->gravity_;
+		motion.stamina = stamina_;
+		motion.dashEnergy = dashEnergy_;
+		motion.dashDir = dashDir_;
+		motion.jumpCount = jumpCount_;
+
+		movePlayer(motion, body_->isGrounded(), input, deltaTime, &statistics_);
+
+		body_->linearVelocity_ = motion.velocity;
+		body_->linearVelocityDamping_ = motion.damping;
+		body_->gravity_ = motion.gravity;
+		stamina_ = motion.stamina;
+		dashEnergy_ = motion.dashEnergy;
+		dashDir_ = motion.dashDir;
+		jumpCount_ = motion.jumpCount;
 	}
 
 	// check collisions with bubbles
@@ -229,6 +204,9 @@ void Player::drawGui()
 		ImGui::ProgressBar(stamina_, ImVec2(0.0f, 0.0f), "Stamina");
 		ImGui::Text("Points (%d): %d", index_, points_);
 		ImGui::Text("Jumps (%d): %d", index_, jumpCount_);
+		ImGui::Checkbox("Autopilot", &autopilot_);
+		if (autopilot_)
+			bot_.drawGui();
 
 		ImGui::TextUnformatted("Dashing: ");
 		ImGui::SameLine();
@@ -255,6 +233,33 @@ void Player::drawGui()
 // PRIVATE FUNCTIONS
 ///////////////////////////////////////////////////////////
 
+PlayerInput Player::boundInput() const
+{
+	PlayerInput input;
+
+	InputBinder &ib = inputBinder();
+	const InputActions &ia = inputActions();
+
+	input.left = (ib.isTriggered(bindingsIndex_ ? ia.P2_LEFT : ia.P1_LEFT));
+	input.right = (ib.isTriggered(bindingsIndex_ ? ia.P2_RIGHT : ia.P1_RIGHT));
+	input.jump = (ib.isTriggered(bindingsIndex_ ? ia.P2_JUMP : ia.P1_JUMP));
+	input.dash = (ib.isTriggered(bindingsIndex_ ? ia.P2_DASH : ia.P1_DASH));
+
+	return input;
+}
+
+PlayerInput Player::botInput(const BubbleGrid &bubbles)
+{
+	BotView view;
+	view.position = body_->position();
+	view.velocity = body_->linearVelocity_;
+	view.stamina = stamina_;
+	view.jumpCount = jumpCount_;
+	view.grounded = body_->isGrounded();
+
+	return bot_.think(view, bubbles);
+}
+
 void Player::onBubbleTouched(Bubble *bubble)
 {
 	bubble->touched();
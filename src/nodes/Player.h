@@ -2,12 +2,16 @@
 
 #include "LogicNode.h"
 #include "../Statistics.h"
+#include "../PlayerInput.h"
+#include "../BotController.h"
 
 namespace ncine {
 	class AnimatedSprite;
 }
 class Body;
 class Bubble;
+class BubbleGrid;
+struct PlayerSnapshot;
 
 namespace nc = ncine;
 
@@ -19,12 +23,33 @@ class Player : public LogicNode
 	inline float stamina() const { return stamina_; }
 	inline int points() const { return points_; }
 	inline const PlayerStatistics &statistics() const { return statistics_; }
+	/// Puts the player back at its starting position, with full stamina and no points
+	void reset();
+	/// An inactive player is neither updated nor drawn, and its body does not collide
+	void setActive(bool active);
+	inline Body *body() { return body_.get(); }
 
-	void onTick(float deltaTime) override;
+	void saveSnapshot(PlayerSnapshot &snapshot) const;
+	void restoreSnapshot(const PlayerSnapshot &snapshot);
+
+	inline bool isAutopilotEnabled() const { return autopilot_; }
+	/// When enabled the player is driven by a bot instead of the bound input actions
+	inline void setAutopilot(bool enabled) { autopilot_ = enabled; }
+	inline BotController &bot() { return bot_; }
+	/// Selects the bound input actions of the first or of the second player, a network player always uses the first ones
+	inline void setInputBindings(int index) { bindingsIndex_ = index; }
+
+	/// Returns the input for the next step, from the bot or from the bound input actions
+	/*! The grid of the alive bubbles is only used by the bot */
+	PlayerInput pollInput(const BubbleGrid &bubbles);
+	/// Advances the player by one simulation step, after the physics bodies have been integrated
+	void simulate(float deltaTime, const PlayerInput &input);
 	void drawGui();
 
   private:
 	int index_;
+	int bindingsIndex_;
+	nc::Vector2f startPosition_;
 	/// Normalised (0..1)
 	float stamina_;
 	int points_;
@@ -36,8 +61,12 @@ class Player : public LogicNode
 	nc::Vector2f dashDir_;
 
 	int jumpCount_;
+	bool autopilot_;
+	BotController bot_;
 
 	PlayerStatistics statistics_;
 
+	PlayerInput boundInput() const;
+	PlayerInput botInput(const BubbleGrid &bubbles);
 	void onBubbleTouched(Bubble *bubble);
 };
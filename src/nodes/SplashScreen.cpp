@@ -4,6 +4,7 @@
 #endif
 
 #include "SplashScreen.h"
+#include "Label.h"
 #include "../main.h"
 #include "../Config.h"
 #include "../ResourceManager.h"
@@ -11,10 +12,7 @@
 #include "../InputActions.h"
 
 #include <ncine/Application.h>
-#include <ncine/FileSystem.h>
 #include <ncine/Sprite.h>
-#include <ncine/Font.h>
-#include <ncine/TextNode.h>
 
 namespace {
 	float FastFadeTime = 0.0f;
@@ -52,12 +50,8 @@ SplashScreen::SplashScreen(SceneNode *parent, nctl::String name, MyEventHandler
 	nCineLogo_->setPosition(screenTopRight * 0.5f);
 	nCineLogo_->setLayer(Cfg::Layers::Background + 1);
 
-	const nctl::String smallFontFntPath_ = nc::fs::joinPath(nc::fs::dataPath(), Cfg::Fonts::Modak20Fnt);
-	smallFont_ = nctl::makeUnique<nc::Font>(smallFontFntPath_.data(), resourceManager().retrieveTexture(Cfg::Fonts::Modak20Png));
-
-	smallText_ = nctl::makeUnique<nc::TextNode>(this, smallFont_.get(), 32);
+	smallText_ = nctl::makeUnique<Label>(this, ResourceManager::FontSize::SMALL, 32);
 	smallText_->setLayer(Cfg::Layers::Gui_Text);
-	smallText_->setRenderMode(nc::Font::RenderMode::GLYPH_SPRITE);
 	smallText_->setString("Made with nCine");
 	smallText_->setPosition(screenTopRight.x * 0.5f, screenTopRight.y * 0.25f);
 
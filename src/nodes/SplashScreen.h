@@ -5,10 +5,9 @@
 
 namespace ncine {
 	class Sprite;
-	class Font;
-	class TextNode;
 }
 class MyEventHandler;
+class Label;
 
 namespace nc = ncine;
 
@@ -36,8 +35,7 @@ class SplashScreen : public LogicNode
 	nctl::UniquePtr<nc::Sprite> background_;
 	nctl::UniquePtr<nc::Sprite> nCineLogo_;
 
-	nctl::UniquePtr<nc::Font> smallFont_;
-	nctl::UniquePtr<nc::TextNode> smallText_;
+	nctl::UniquePtr<Label> smallText_;
 
 	nc::TimeStamp stateTimer_;
 };
@@ -27,6 +27,32 @@ void main()
 }
 )";
 
+char const * const sprite_sharpen_fs = R"(
+#ifdef GL_ES
+precision mediump float;
+#endif
+
+uniform sampler2D uTexture;
+uniform vec2 uTexelSize;
+uniform float uSharpness;
+in vec2 vTexCoords;
+in vec4 vColor;
+out vec4 fragColor;
+
+void main()
+{
+	// Unsharp mask with the four neighbouring texels, it recovers some of the detail smoothed by the bilinear upscale
+	vec4 center = texture(uTexture, vTexCoords);
+	vec4 neighbours = texture(uTexture, vTexCoords + vec2(uTexelSize.x, 0.0));
+	neighbours += texture(uTexture, vTexCoords - vec2(uTexelSize.x, 0.0));
+	neighbours += texture(uTexture, vTexCoords + vec2(0.0, uTexelSize.y));
+	neighbours += texture(uTexture, vTexCoords - vec2(0.0, uTexelSize.y));
+
+	vec3 sharpened = center.rgb + (center.rgb - neighbours.rgb * 0.25) * uSharpness;
+	fragColor = vec4(clamp(sharpened, 0.0, 1.0), center.a) * vColor;
+}
+)";
+
 char const * const sprite_dispersion_vs = R"(
 uniform mat4 uProjectionMatrix;
 uniform mat4 uViewMatrix;
@@ -114,8 +140,9 @@ const float uDiffuseness = 0.2;
 const vec3 uLight = vec3(-1.0, 1.0, 1.0);
 
 uniform vec2 winResolution;
-uniform sampler2D uTexture0;
-uniform sampler2D uTexture1;
+// The bubble atlas is the sprite texture, the scene behind the bubbles is bound to the second unit
+uniform sampler2D uTexture;
+uniform sampler2D uSceneTexture;
 in vec2 vPosition;
 in vec2 vTexCoords;
 out vec4 fragColor;
@@ -167,7 +194,8 @@ void main()
 		discard;
 	vec3 normal = vec3(centeredPos.x, centeredPos.y, sqrt(1.0 - distSquared));
 
-	vec2 centeredTC = vTexCoords * 2.0 - 1.0;
+	// Texture coordinates point inside the atlas, the eye vector is derived from the quad position instead
+	vec2 centeredTC = vec2(centeredPos.x, -centeredPos.y);
 	vec3 eyeVector = normalize(vec3(centeredTC.x, centeredTC.y, -1.0));
 
 	vec3 color = vec3(0.0);
@@ -182,23 +210,23 @@ void main()
 		vec3 refractVecB = refract(eyeVector, normal, (1.0 / uIorB));
 		vec3 refractVecP = refract(eyeVector, normal, (1.0 / uIorP));
 
-		float r = texture(uTexture0, uv + refractVecR.xy * (uRefractPower + slide * 1.0) * uChromaticAberration).x * 0.5;
+		float r = texture(uSceneTexture, uv + refractVecR.xy * (uRefractPower + slide * 1.0) * uChromaticAberration).x * 0.5;
 
-		float y = (texture(uTexture0, uv + refractVecY.xy * (uRefractPower + slide * 1.0) * uChromaticAberration).x * 2.0 +
-		           texture(uTexture0, uv + refractVecY.xy * (uRefractPower + slide * 1.0) * uChromaticAberration).y * 2.0 -
-		           texture(uTexture0, uv + refractVecY.xy * (uRefractPower + slide * 1.0) * uChromaticAberration).z) / 6.0;
+		float y = (texture(uSceneTexture, uv + refractVecY.xy * (uRefractPower + slide * 1.0) * uChromaticAberration).x * 2.0 +
+		           texture(uSceneTexture, uv + refractVecY.xy * (uRefractPower + slide * 1.0) * uChromaticAberration).y * 2.0 -
+		           texture(uSceneTexture, uv + refractVecY.xy * (uRefractPower + slide * 1.0) * uChromaticAberration).z) / 6.0;
 
-		float g = texture(uTexture0, uv + refractVecG.xy * (uRefractPower + slide * 2.0) * uChromaticAberration).y * 0.5;
+		float g = texture(uSceneTexture, uv + refractVecG.xy * (uRefractPower + slide * 2.0) * uChromaticAberration).y * 0.5;
 
-		float c = (texture(uTexture0, uv + refractVecC.xy * (uRefractPower + slide * 2.5) * uChromaticAberration).y * 2.0 +
-		           texture(uTexture0, uv + refractVecC.xy * (uRefractPower + slide * 2.5) * uChromaticAberration).z * 2.0 -
-		           texture(uTexture0, uv + refractVecC.xy * (uRefractPower + slide * 2.5) * uChromaticAberration).x) / 6.0;
+		float c = (texture(uSceneTexture, uv + refractVecC.xy * (uRefractPower + slide * 2.5) * uChromaticAberration).y * 2.0 +
+		           texture(uSceneTexture, uv + refractVecC.xy * (uRefractPower + slide * 2.5) * uChromaticAberration).z * 2.0 -
+		           texture(uSceneTexture, uv + refractVecC.xy * (uRefractPower + slide * 2.5) * uChromaticAberration).x) / 6.0;
 
-		float b = texture(uTexture0, uv + refractVecB.xy * (uRefractPower + slide * 3.0) * uChromaticAberration).z * 0.5;
+		float b = texture(uSceneTexture, uv + refractVecB.xy * (uRefractPower + slide * 3.0) * uChromaticAberration).z * 0.5;
 
-		float p = (texture(uTexture0, uv + refractVecP.xy * (uRefractPower + slide * 1.0) * uChromaticAberration).z * 2.0 +
-		           texture(uTexture0, uv + refractVecP.xy * (uRefractPower + slide * 1.0) * uChromaticAberration).x * 2.0 -
-		           texture(uTexture0, uv + refractVecP.xy * (uRefractPower + slide * 1.0) * uChromaticAberration).y) / 6.0;
+		float p = (texture(uSceneTexture, uv + refractVecP.xy * (uRefractPower + slide * 1.0) * uChromaticAberration).z * 2.0 +
+		           texture(uSceneTexture, uv + refractVecP.xy * (uRefractPower + slide * 1.0) * uChromaticAberration).x * 2.0 -
+		           texture(uSceneTexture, uv + refractVecP.xy * (uRefractPower + slide * 1.0) * uChromaticAberration).y) / 6.0;
 
 		float R = r + (2.0 * p + 2.0 * y - c) / 3.0;
 		float G = g + (2.0 * y + 2.0 * c - p) / 3.0;
@@ -222,7 +250,7 @@ void main()
 	float f = fresnel(eyeVector, normal, uFresnelPower);
 	color.rgb += f * vec3(1.0);
 
-	vec4 bubbleTex = texture(uTexture1, vTexCoords);
+	vec4 bubbleTex = texture(uTexture, vTexCoords);
 	vec3 blendedRGB = bubbleTex.rgb * bubbleTex.a + color.rgb * (1.0 - bubbleTex.a);
 	float blendedA = (bubbleTex.a < 0.1) ? bubbleTex.a : 1.0;
 